@@ -1,19 +1,42 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "pppsolutionfile.h"
 #include <QDesktopServices>
 #include <QUrl>
 #include <QDateTime>
-#include <QFile>
-#include <QTextStream>
 #include <QFileInfo>
-#include <QRegularExpression>
+#include <QApplication>
 #include <QClipboard>
+#include <QElapsedTimer>
+#include <QHeaderView>
+#include <QPointer>
+#include <QScrollBar>
+#include <QThread>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , m_logModel(new PPPLogModel(this))
+    , m_logFollow(true)
+    , m_resultModel(new PPPResultModel(this))
+    , m_resultLoad(0)
 {    ui->setupUi(this);
     
+    // 结果表格由数据模型按需提供单元格；行高固定，不按内容计算每一行
+    ui->tableWidgetResults->setModel(m_resultModel);
+    ui->tableWidgetResults->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->tableWidgetResults->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    
+    // 日志由数据模型按帧批量插入，视图只绘制可见的行；位于末尾时跟随新消息滚动
+    ui->listViewLog->setModel(m_logModel);
+    connect(m_logModel, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar *bar = ui->listViewLog->verticalScrollBar();
+        m_logFollow = bar->value() == bar->maximum();
+    });
+    connect(m_logModel, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (m_logFollow) ui->listViewLog->scrollToBottom();
+    });
+    
     // 设置窗口标题
     setWindowTitle("精密单点定位程序");
     
@@ -23,6 +46,11 @@ MainWindow::MainWindow(QWidget *parent)
     connect(m_processor, &PPPProcessor::processingFinished, this, &MainWindow::onProcessingFinished);
     connect(m_processor, &PPPProcessor::processingProgress, this, &MainWindow::onProcessingProgress);
     
+    // 结果导出
+    m_exporter = new PPPResultExporter(this);
+    connect(m_exporter, &PPPResultExporter::progress, this, &MainWindow::onExportProgress);
+    connect(m_exporter, &PPPResultExporter::finished, this, &MainWindow::onExportFinished);
+    
     // 创建状态栏组件
     m_statusLabel = new QLabel("就绪");
     m_progressBar = new QProgressBar();
@@ -108,7 +136,7 @@ MainWindow::~MainWindow()
 // 文件选择槽函数
 void MainWindow::on_btnSelectObsFile_clicked()
 {
-    QString file = selectFile("选择观测文件", "观测文件 (*.*o *.obs *.rnx);;所有文件 (*)");
+    QString file = selectFile("选择观测文件", "观测文件 (*.*o *.obs *.rnx *.crx *.*d *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditObsFile->setText(file);
     }
@@ -116,7 +144,7 @@ void MainWindow::on_btnSelectObsFile_clicked()
 
 void MainWindow::on_btnSelectNavFile_clicked()
 {
-    QString file = selectFile("选择导航文件", "导航文件 (*.n *.nav *.rnx);;所有文件 (*)");
+    QString file = selectFile("选择导航文件", "导航文件 (*.n *.nav *.rnx *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditNavFile->setText(file);
     }
@@ -124,7 +152,7 @@ void MainWindow::on_btnSelectNavFile_clicked()
 
 void MainWindow::on_btnSelectSp3File_clicked()
 {
-    QString file = selectFile("选择精密星历文件", "SP3文件 (*.sp3);;所有文件 (*)");
+    QString file = selectFile("选择精密星历文件", "SP3文件 (*.sp3 *.eph *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditSp3File->setText(file);
     }
@@ -132,7 +160,7 @@ void MainWindow::on_btnSelectSp3File_clicked()
 
 void MainWindow::on_btnSelectClkFile_clicked()
 {
-    QString file = selectFile("选择精密钟差文件", "CLK文件 (*.clk);;所有文件 (*)");
+    QString file = selectFile("选择精密钟差文件", "CLK文件 (*.clk *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditClkFile->setText(file);
     }
@@ -140,7 +168,7 @@ void MainWindow::on_btnSelectClkFile_clicked()
 
 void MainWindow::on_btnSelectAtxFile_clicked()
 {
-    QString file = selectFile("选择天线相位中心文件", "ATX文件 (*.atx);;所有文件 (*)");
+    QString file = selectFile("选择天线相位中心文件", "ATX文件 (*.atx *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditAtxFile->setText(file);
     }
@@ -148,7 +176,7 @@ void MainWindow::on_btnSelectAtxFile_clicked()
 
 void MainWindow::on_btnSelectDcbFile_clicked()
 {
-    QString file = selectFile("选择DCB文件", "DCB文件 (*.dcb *.bsx);;所有文件 (*)");
+    QString file = selectFile("选择DCB文件", "DCB文件 (*.dcb *.bsx *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditDcbFile->setText(file);
     }
@@ -156,7 +184,7 @@ void MainWindow::on_btnSelectDcbFile_clicked()
 
 void MainWindow::on_btnSelectErpFile_clicked()
 {
-    QString file = selectFile("选择地球自转参数文件", "ERP文件 (*.erp);;所有文件 (*)");
+    QString file = selectFile("选择地球自转参数文件", "ERP文件 (*.erp *.gz *.Z);;所有文件 (*)");
     if (!file.isEmpty()) {
         ui->lineEditErpFile->setText(file);
     }
@@ -184,11 +212,6 @@ void MainWindow::on_btnStartProcessing_clicked()
         return;
     }
     
-    if (ui->lineEditOutFile->text().isEmpty()) {
-        QMessageBox::warning(this, "缺少文件", "必须指定输出文件");
-        return;
-    }
-    
     // 设置PPP处理器参数
     m_processor->setObsFile(ui->lineEditObsFile->text());
     m_processor->setNavFile(ui->lineEditNavFile->text());
@@ -252,16 +275,41 @@ void MainWindow::on_btnStartProcessing_clicked()
     // 更新卫星系统设置
     updateNavSys();
     
-    // 开始处理
-    m_processor->startProcessing();
+    // 在工作线程中开始处理
+    // 由PPPEngine处理时结果保存在内存中，可以不输出结果文件
+    if (ui->lineEditOutFile->text().isEmpty() && !PPPProcessor::useEngine(&m_processor->paths())) {
+        QMessageBox::warning(this, "缺少文件", "必须指定输出文件");
+        return;
+    }
+    
+    if (!m_processor->startProcessing()) {
+        QMessageBox::warning(this, "无法开始处理", m_processor->getStatusMessage());
+    }
+}
+
+void MainWindow::on_btnCancelProcessing_clicked()
+{
+    m_processor->cancelProcessing();
+    ui->btnCancelProcessing->setEnabled(false);
+    logMessage("正在取消处理，将在当前历元结束后停止...");
 }
 
 void MainWindow::on_btnClearLog_clicked()
 {
-    ui->textEditLog->clear();
+    m_logModel->clear();
     logMessage("日志已清空");
 }
 
+void MainWindow::on_comboBoxLogLevel_currentIndexChanged(int index)
+{
+    m_logModel->setFilter(PPPLogModel::Level(index), ui->lineEditLogSearch->text());
+}
+
+void MainWindow::on_lineEditLogSearch_textChanged(const QString &text)
+{
+    m_logModel->setFilter(PPPLogModel::Level(ui->comboBoxLogLevel->currentIndex()), text);
+}
+
 void MainWindow::onProcessingStarted()
 {
     updateUIState(true);
@@ -273,22 +321,23 @@ void MainWindow::onProcessingFinished(bool success)
     updateUIState(false);    if (success) {
         logMessage("精密单点定位处理成功完成！");
         
-        // 解析结果文件并显示在表格中
-        bool parseSuccess = parseResultFile(ui->lineEditOutFile->text());
-        if (parseSuccess) {
-            displayResults();
-            ui->tabWidget->setCurrentWidget(ui->tabResults);
-            logMessage("结果已加载到结果表格中");
-        }
+        // 在后台线程中整理内存中的结果（没有时解析结果文件），完成后显示在表格中
+        QString outFile = ui->lineEditOutFile->text();
+        loadResults(outFile, m_processor->solutions());
         
         // 询问是否打开结果文件
-        QMessageBox::StandardButton reply = QMessageBox::question(this, 
-                                         "处理完成", 
-                                         "精密单点定位处理已成功完成，是否打开结果文件？",
-                                         QMessageBox::Yes | QMessageBox::No);
-        if (reply == QMessageBox::Yes) {
-            QDesktopServices::openUrl(QUrl::fromLocalFile(ui->lineEditOutFile->text()));
-        }    } else {
+        if (!outFile.isEmpty()) {
+            QMessageBox::StandardButton reply = QMessageBox::question(this, 
+                                             "处理完成", 
+                                             "精密单点定位处理已成功完成，是否打开结果文件？",
+                                             QMessageBox::Yes | QMessageBox::No);
+            if (reply == QMessageBox::Yes) {
+                QDesktopServices::openUrl(QUrl::fromLocalFile(outFile));
+            }
+        }
+    } else if (m_processor->wasCancelled()) {
+        logMessage("精密单点定位处理已取消");
+    } else {
         logMessage("处理失败: " + m_processor->getStatusMessage());
         QMessageBox::critical(this, "处理失败", "精密单点定位处理失败: " + m_processor->getStatusMessage());
     }
@@ -312,6 +361,7 @@ void MainWindow::updateUIState(bool isProcessing)
     ui->groupBoxInput->setEnabled(!isProcessing);
     ui->groupBoxOptions->setEnabled(!isProcessing);
     ui->btnStartProcessing->setEnabled(!isProcessing);
+    ui->btnCancelProcessing->setEnabled(isProcessing);
     
     if (!isProcessing) {
         m_progressBar->setValue(0);
@@ -321,155 +371,156 @@ void MainWindow::updateUIState(bool isProcessing)
 
 void MainWindow::logMessage(const QString &message)
 {
-    ui->textEditLog->append(QDateTime::currentDateTime().toString("[yyyy-MM-dd hh:mm:ss] ") + message);
-}
-
-// 解析结果文件
-bool MainWindow::parseResultFile(const QString &filename)
-{
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        logMessage("无法打开结果文件：" + filename);
-        return false;
-    }
-
-    m_results.clear();
-    QTextStream in(&file);
-    bool dataStarted = false;
-    
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        
-        // 跳过注释行
-        if (line.startsWith("%")) {
-            continue;
-        }
-        
-        // 找到数据行
-        QRegularExpression re("^(\\d{4}/\\d{2}/\\d{2}\\s+\\d{2}:\\d{2}:\\d{2}\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+(\\d+)\\s+(\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+).*$");
-        QRegularExpressionMatch match = re.match(line);
-        
-        if (match.hasMatch()) {
-            PPPResult result;
-            result.timestamp = QDateTime::fromString(match.captured(1), "yyyy/MM/dd hh:mm:ss.zzz");
-            result.latitude = match.captured(2).toDouble();
-            result.longitude = match.captured(3).toDouble();
-            result.height = match.captured(4).toDouble();
-            result.quality = match.captured(5).toInt();
-            result.numSatellites = match.captured(6).toInt();
-            result.sdn = match.captured(7).toDouble();
-            result.sde = match.captured(8).toDouble();
-            result.sdu = match.captured(9).toDouble();
-            result.sdne = match.captured(10).toDouble();
-            result.sdeu = match.captured(11).toDouble();
-            result.sdun = match.captured(12).toDouble();
-            
-            m_results.append(result);
-            dataStarted = true;
-        } else if (dataStarted) {
-            // 如果已经开始解析数据但当前行不匹配，可能是格式变化，跳过
-            logMessage("警告：跳过不匹配的行: " + line);
+    m_logModel->append(message, PPPLogModel::levelOf(message));
+}
+
+// 在工作线程中整理处理器保存的结果，没有时映射并读取二进制结果文件或解析.pos文件，10 Hz全天的结果也不阻塞界面
+void MainWindow::loadResults(const QString &filename, const PPPSolutionStore &solutions)
+{
+    int load = ++m_resultLoad;
+    QPointer<MainWindow> window(this);
+    QThread *thread = QThread::create([window, filename, solutions, load]() {
+        PPPResultColumns results;
+        QString error;
+        int skipped = 0;
+        QElapsedTimer timer;
+        timer.start();
+        if (!solutions.isEmpty()) {
+            results.reserve(solutions.size());
+            for (int i = 0; i < solutions.size(); i++) {
+                results.append(solutions.record(i));
+            }
+        } else if (filename.isEmpty()) {
+            error = "no solution";
+        } else if (PPPSolutionFile::isSolutionFile(filename)) {
+            // 二进制结果文件：按记录转换，与内存中的结果相同
+            PPPSolutionFile file;
+            if (file.open(filename, &error)) {
+                PPPSolutionStore store;
+                store.reserve(file.count());
+                sol_t sol;
+                for (int i = 0; i < file.count(); i++) {
+                    file.read(i, &sol);
+                    store.append(sol);
+                }
+                results.reserve(store.size());
+                for (int i = 0; i < store.size(); i++) {
+                    results.append(store.record(i));
+                }
+            }
+        } else {
+            QVector<PosRecord> records;
+            if (PosFile::load(filename, &records, &skipped, &error)) {
+                results.reserve(records.size());
+                for (const PosRecord &record : records) {
+                    results.append(record);
+                }
+            }
         }
+        double seconds = timer.elapsed() / 1000.0;
+        bool memory = !solutions.isEmpty();
+        QMetaObject::invokeMethod(qApp, [window, filename, memory, load, results, skipped, seconds, error]() {
+            if (window && window->m_resultLoad == load) {
+                window->onResultsLoaded(memory ? QString() : filename, results, skipped, seconds, error);
+            }
+        }, Qt::QueuedConnection);
+    });
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+void MainWindow::onResultsLoaded(const QString &filename, const PPPResultColumns &results, int skipped,
+                                 double seconds, const QString &error)
+{
+    if (!error.isEmpty()) {
+        logMessage(filename.isEmpty() ? QString("没有解算结果") : "无法打开结果文件：" + filename);
+        return;
     }
-    
-    file.close();
-    logMessage(QString("成功解析结果文件，共找到 %1 条数据记录").arg(m_results.size()));
-    return !m_results.isEmpty();
-}
-
-// 在表格中显示结果
-void MainWindow::displayResults()
-{
-    ui->tableWidgetResults->setRowCount(0);
-    
-    for (const PPPResult &result : m_results) {
-        int row = ui->tableWidgetResults->rowCount();
-        ui->tableWidgetResults->insertRow(row);
-        
-        // 添加数据到表格
-        ui->tableWidgetResults->setItem(row, 0, new QTableWidgetItem(result.timestamp.toString("yyyy/MM/dd hh:mm:ss.zzz")));
-        ui->tableWidgetResults->setItem(row, 1, new QTableWidgetItem(QString::number(result.latitude, 'f', 9)));
-        ui->tableWidgetResults->setItem(row, 2, new QTableWidgetItem(QString::number(result.longitude, 'f', 9)));
-        ui->tableWidgetResults->setItem(row, 3, new QTableWidgetItem(QString::number(result.height, 'f', 4)));
-        
-        // 质量指示器说明
-        QString qualityText;
-        switch (result.quality) {
-            case 1: qualityText = "1-固定解"; break;
-            case 2: qualityText = "2-浮点解"; break;
-            case 3: qualityText = "3-SBAS"; break;
-            case 4: qualityText = "4-DGPS"; break;
-            case 5: qualityText = "5-单点定位"; break;
-            case 6: qualityText = "6-PPP"; break;
-            default: qualityText = QString::number(result.quality);
-        }
-        ui->tableWidgetResults->setItem(row, 4, new QTableWidgetItem(qualityText));
-        
-        ui->tableWidgetResults->setItem(row, 5, new QTableWidgetItem(QString::number(result.numSatellites)));
-        ui->tableWidgetResults->setItem(row, 6, new QTableWidgetItem(QString::number(result.sdn, 'f', 4)));
-        ui->tableWidgetResults->setItem(row, 7, new QTableWidgetItem(QString::number(result.sde, 'f', 4)));
-        ui->tableWidgetResults->setItem(row, 8, new QTableWidgetItem(QString::number(result.sdu, 'f', 4)));
-        ui->tableWidgetResults->setItem(row, 9, new QTableWidgetItem(QString::number(result.sdne, 'f', 4)));
-        ui->tableWidgetResults->setItem(row, 10, new QTableWidgetItem(QString::number(result.sdeu, 'f', 4)));
-        ui->tableWidgetResults->setItem(row, 11, new QTableWidgetItem(QString::number(result.sdun, 'f', 4)));
+    if (skipped > 0) {
+        logMessage(QString("警告：跳过 %1 行格式不符的数据").arg(skipped));
+    }
+    if (filename.isEmpty()) {
+        logMessage(QString("直接使用内存中的解算结果，共 %1 条数据记录，耗时 %2 s").arg(results.size()).arg(seconds, 0, 'f', 3));
+    } else {
+        logMessage(QString("成功解析结果文件，共找到 %1 条数据记录，耗时 %2 s").arg(results.size()).arg(seconds, 0, 'f', 3));
+    }
+    if (!results.isEmpty()) {
+        // 表格只格式化可见的单元格，列宽按表头默认的精度（最多1000行）计算
+        m_resultModel->setResults(results);
+        ui->tableWidgetResults->resizeColumnsToContents();
+        ui->tabWidget->setCurrentWidget(ui->tabResults);
+        logMessage("结果已加载到结果表格中");
     }
-    
-    // 自动调整列宽以适应内容
-    ui->tableWidgetResults->resizeColumnsToContents();
 }
 
 // 导出结果按钮槽函数
 void MainWindow::on_btnExportResults_clicked()
 {
-    if (m_results.isEmpty()) {
+    // 导出期间按钮用于取消导出
+    if (m_exporter->isRunning()) {
+        m_exporter->cancel();
+        return;
+    }
+    
+    const PPPResultColumns &results = m_resultModel->results();
+    if (results.isEmpty()) {
         QMessageBox::warning(this, "导出失败", "没有可导出的结果数据");
         return;
     }
     
+    static const QStringList filters = {
+        "CSV文件 (*.csv)", "GeoJSON文件 (*.geojson)", "KML文件 (*.kml)", "二进制文件 (*.bin)"
+    };
+    static const char *const suffixes[] = { "csv", "geojson", "kml", "bin" };
+    QString selectedFilter = filters[0];
     QString exportPath = QFileDialog::getSaveFileName(this, "导出结果数据", 
                                                     QFileInfo(ui->lineEditOutFile->text()).path() + "/结果数据.csv", 
-                                                    "CSV文件 (*.csv);;所有文件 (*)");
+                                                    filters.join(";;"), &selectedFilter);
     
     if (exportPath.isEmpty()) {
         return;
     }
     
-    QFile file(exportPath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "导出失败", "无法创建导出文件：" + exportPath);
-        return;
+    // 文件名没有扩展名时按所选的文件类型添加
+    int type = qMax(0, int(filters.indexOf(selectedFilter)));
+    if (QFileInfo(exportPath).suffix().isEmpty()) {
+        exportPath += QString(".") + suffixes[type];
     }
+    PPPResultExporter::Format format = PPPResultExporter::formatForFile(exportPath);
     
-    QTextStream out(&file);
-    
-    // 写入CSV头
-    out << "时间,纬度(度),经度(度),高程(m),解算质量,卫星数,sdn(m),sde(m),sdu(m),sdne(m),sdeu(m),sdun(m)\n";
-    
-    // 写入数据
-    for (const PPPResult &result : m_results) {
-        out << result.timestamp.toString("yyyy/MM/dd hh:mm:ss.zzz") << ","
-            << QString::number(result.latitude, 'f', 9) << ","
-            << QString::number(result.longitude, 'f', 9) << ","
-            << QString::number(result.height, 'f', 4) << ","
-            << result.quality << ","
-            << result.numSatellites << ","
-            << QString::number(result.sdn, 'f', 4) << ","
-            << QString::number(result.sde, 'f', 4) << ","
-            << QString::number(result.sdu, 'f', 4) << ","
-            << QString::number(result.sdne, 'f', 4) << ","
-            << QString::number(result.sdeu, 'f', 4) << ","
-            << QString::number(result.sdun, 'f', 4) << "\n";
+    // 在工作线程中导出，结果数据隐式共享，导出期间清空或重新加载结果不影响导出
+    m_exportPath = exportPath;
+    m_exporter->start(results, exportPath, format);
+    ui->btnExportResults->setText("取消导出");
+    m_statusLabel->setText("正在导出结果数据...");
+    logMessage("开始导出结果数据到: " + exportPath);
+}
+
+void MainWindow::onExportProgress(int percent)
+{
+    m_progressBar->setValue(percent);
+}
+
+void MainWindow::onExportFinished(bool success, const QString &message)
+{
+    ui->btnExportResults->setText("导出结果");
+    m_progressBar->setValue(0);
+    m_statusLabel->setText("就绪");
+    if (success) {
+        logMessage("结果数据已成功导出到: " + m_exportPath);
+        QMessageBox::information(this, "导出成功", "结果数据已成功导出到: " + m_exportPath);
+    } else if (m_exporter->wasCancelled()) {
+        logMessage("结果导出已取消");
+    } else {
+        logMessage("导出失败: " + message);
+        QMessageBox::critical(this, "导出失败", message);
     }
-    
-    file.close();
-    logMessage("结果数据已成功导出到: " + exportPath);
-    QMessageBox::information(this, "导出成功", "结果数据已成功导出到: " + exportPath);
 }
 
 // 清空结果按钮槽函数
 void MainWindow::on_btnClearResults_clicked()
 {
-    if (m_results.isEmpty() && ui->tableWidgetResults->rowCount() == 0) {
+    if (m_resultModel->rowCount() == 0) {
         return;
     }
     
@@ -478,8 +529,7 @@ void MainWindow::on_btnClearResults_clicked()
                                                            QMessageBox::Yes | QMessageBox::No);
     
     if (reply == QMessageBox::Yes) {
-        m_results.clear();
-        ui->tableWidgetResults->setRowCount(0);
+        m_resultModel->clear();
         logMessage("已清空结果数据");
     }
 }
@@ -6,9 +6,11 @@
 #include <QMessageBox>
 #include <QProgressBar>
 #include <QLabel>
-#include <QTableWidget>
 #include <QDateTime>
+#include "ppplogmodel.h"
 #include "pppprocessor.h"
+#include "pppresultexporter.h"
+#include "pppresultmodel.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -37,7 +39,10 @@ private slots:
     
     // 处理控制槽函数
     void on_btnStartProcessing_clicked();
+    void on_btnCancelProcessing_clicked();
     void on_btnClearLog_clicked();
+    void on_comboBoxLogLevel_currentIndexChanged(int index);
+    void on_lineEditLogSearch_textChanged(const QString &text);
     
     // 结果表格操作槽函数
     void on_btnExportResults_clicked();
@@ -48,6 +53,10 @@ private slots:
     void onProcessingFinished(bool success);
     void onProcessingProgress(int percent, const QString &message);
     
+    // 结果导出事件处理
+    void onExportProgress(int percent);
+    void onExportFinished(bool success, const QString &message);
+    
     // 新增设置选项槽函数
     void on_dateTimeStart_dateTimeChanged(const QDateTime &dateTime);
     void on_dateTimeEnd_dateTimeChanged(const QDateTime &dateTime);
@@ -86,29 +95,23 @@ private:
     QCheckBox *checkBoxIRNSS;
     QCheckBox *checkBoxSBAS;
     
-    // 结果数据结构
-    struct PPPResult {
-        QDateTime timestamp;
-        double latitude;
-        double longitude;
-        double height;
-        int quality;
-        int numSatellites;
-        double sdn;
-        double sde;
-        double sdu;
-        double sdne;
-        double sdeu;
-        double sdun;
-    };
-    QList<PPPResult> m_results;
+    // 日志
+    PPPLogModel *m_logModel;
+    bool m_logFollow;   // 插入新消息前视图位于末尾，插入后继续滚动到末尾
+    
+    // 结果数据
+    PPPResultModel *m_resultModel;
+    PPPResultExporter *m_exporter;
+    QString m_exportPath;
+    int m_resultLoad;   // 结果读取的序号，只显示最近一次读取的结果
     
     // 辅助函数
     QString selectFile(const QString &title, const QString &filter);
     void updateUIState(bool isProcessing);
     void logMessage(const QString &message);
-    bool parseResultFile(const QString &filename);
-    void displayResults();
+    void loadResults(const QString &filename, const PPPSolutionStore &solutions);
+    void onResultsLoaded(const QString &filename, const PPPResultColumns &results, int skipped, double seconds,
+                         const QString &error);
     void setupNavSystemUI(); // 设置卫星系统UI
 };
 #endif // MAINWINDOW_H
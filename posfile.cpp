@@ -0,0 +1,139 @@
+#include "posfile.h"
+#include <QFile>
+#include <charconv>
+#include <climits>
+#include <cstring>
+
+// 读取一个数值字段：与sscanf的%d/%lf一样跳过前导空白并接受正号
+template <typename T>
+static bool field(const char *&p, const char *end, T *value)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p < end && *p == '+') p++;
+    std::from_chars_result result = std::from_chars(p, end, *value);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+static bool separator(const char *&p, const char *end, char c)
+{
+    if (p >= end || *p != c) {
+        return false;
+    }
+    p++;
+    return true;
+}
+
+bool PosFile::parseLine(const char *line, PosRecord *record)
+{
+    return parseLine(line, line + strlen(line), record);
+}
+
+bool PosFile::parseLine(const char *begin, const char *end, PosRecord *record)
+{
+    // 格式与sscanf("%d/%d/%d %d:%d:%lf %lf %lf %lf %d %d %lf ...")相同，至少17个字段，龄期和比值可省略
+    double ep[6] = { 0 };
+    int y, m, d, h, mi;
+    const char *p = begin;
+    if (p >= end || *p == '%') {
+        return false;
+    }
+    if (!field(p, end, &y) || !separator(p, end, '/') || !field(p, end, &m) || !separator(p, end, '/') ||
+        !field(p, end, &d) || !field(p, end, &h) || !separator(p, end, ':') || !field(p, end, &mi) ||
+        !separator(p, end, ':') || !field(p, end, ep + 5) || !field(p, end, &record->lat) ||
+        !field(p, end, &record->lon) || !field(p, end, &record->height) || !field(p, end, &record->quality) ||
+        !field(p, end, &record->ns) || !field(p, end, &record->sdn) || !field(p, end, &record->sde) ||
+        !field(p, end, &record->sdu) || !field(p, end, &record->sdne) || !field(p, end, &record->sdeu) ||
+        !field(p, end, &record->sdun)) {
+        return false;
+    }
+    if (!field(p, end, &record->age) || !field(p, end, &record->ratio)) {
+        record->age = record->ratio = 0.0;
+    }
+    ep[0] = y; ep[1] = m; ep[2] = d; ep[3] = h; ep[4] = mi;
+    record->time = epoch2time(ep);
+    return true;
+}
+
+bool PosFile::read(const QString &path, PosFileData *data, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QString("无法打开结果文件: %1").arg(path);
+        return false;
+    }
+    data->header.clear();
+    data->lines.clear();
+    data->records.clear();
+
+    PosRecord record;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (line.startsWith('%')) {
+            // 数据开始后的注释行（如终止记录）不属于头部
+            if (data->lines.isEmpty()) data->header.append(line);
+            continue;
+        }
+        if (parseLine(line.constData(), &record)) {
+            data->lines.append(line);
+            data->records.append(record);
+        }
+    }
+    return true;
+}
+
+bool PosFile::load(const QString &path, QVector<PosRecord> *records, int *skipped, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开结果文件: %1").arg(path);
+        return false;
+    }
+    records->clear();
+    *skipped = 0;
+    qint64 size = file.size();
+    if (size <= 0) {
+        return true;
+    }
+    // 无法映射时（如管道）读入内存
+    QByteArray buffer;
+    const char *p = reinterpret_cast<const char *>(file.map(0, size));
+    if (!p) {
+        buffer = file.readAll();
+        p = buffer.constData();
+        size = buffer.size();
+    }
+    const char *end = p + size;
+
+    // 每行约130字节，预先分配避免逐行扩展
+    records->reserve(int(qMin(size / 128 + 1, qint64(INT_MAX / int(sizeof(PosRecord))))));
+    PosRecord record;
+    while (p < end) {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', size_t(end - p)));
+        if (!eol) eol = end;
+        const char *last = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+        if (parseLine(p, last, &record)) {
+            records->append(record);
+        } else if (!records->isEmpty() && p < last && *p != '%') {
+            (*skipped)++;
+        }
+        p = eol + 1;
+    }
+    return true;
+}
+
+QString PosFile::timeText(const PosRecord &record)
+{
+    char buff[64];
+    time2str(record.time, buff, 3);
+    return QString::fromLatin1(buff);
+}
+
+void PosFile::toEcef(const PosRecord &record, double *xyz)
+{
+    double pos[3] = { record.lat * D2R, record.lon * D2R, record.height };
+    pos2ecef(pos, xyz);
+}
@@ -0,0 +1,52 @@
+#ifndef POSFILE_H
+#define POSFILE_H
+
+#include "rtklib.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+// .pos结果文件中的一个历元（solopt默认的 yyyy/mm/dd hh:mm:ss 时间与经纬度/高程格式）
+struct PosRecord {
+    gtime_t time;          // 历元时间
+    double lat, lon;       // 纬度/经度 (deg)
+    double height;         // 高程 (m)
+    int quality;           // 解算质量 (SOLQ_???)
+    int ns;                // 卫星数
+    double sdn, sde, sdu;  // 标准差 (m)
+    double sdne, sdeu, sdun; // 协方差的符号平方根 (m)
+    double age, ratio;     // 差分龄期 (s)、模糊度检验比值
+};
+
+// .pos文件内容：头部注释行与数据行（保留原始文本以便原样写回）
+struct PosFileData {
+    QList<QByteArray> header;
+    QList<QByteArray> lines;
+    QList<PosRecord> records;
+};
+
+class PosFile
+{
+public:
+    // 解析一行数据，注释行或格式不符返回false
+    static bool parseLine(const char *line, PosRecord *record);
+
+    // 解析[begin, end)中的一行，用std::from_chars逐字段转换，不分配内存
+    static bool parseLine(const char *begin, const char *end, PosRecord *record);
+
+    // 读取整个文件
+    static bool read(const QString &path, PosFileData *data, QString *error);
+
+    // 映射文件并解析全部数据行，只保留解算结果（不保存原始文本），可在工作线程中调用
+    // skipped为数据开始后格式不符的非注释行数
+    static bool load(const QString &path, QVector<PosRecord> *records, int *skipped, QString *error);
+
+    // 历元时间的文本 (yyyy/mm/dd hh:mm:ss.sss)
+    static QString timeText(const PosRecord &record);
+
+    // 历元的ECEF坐标 (m)
+    static void toEcef(const PosRecord &record, double *xyz);
+};
+
+#endif // POSFILE_H
@@ -0,0 +1,218 @@
+#include "pppantexindex.h"
+#include "pppdecompress.h"
+#include "pppproductcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <climits>
+#include <cstring>
+
+static const char ANTEX_INDEX_MAGIC[8] = { 'P', 'P', 'P', 'A', 'T', 'X', 'I', '1' };
+
+// 索引文件头，其后为count个索引表项和count个pcv_t
+struct AntexIndexHeader {
+    char magic[8];
+    quint32 keySize;       // sizeof(Key)
+    quint32 pcvSize;       // sizeof(pcv_t)
+    qint64 count;          // 条目数
+    quint8 source[16];     // ANTEX文件路径、修改时间和大小的MD5
+    quint8 digest[16];     // 文件头之后全部数据的MD5
+};
+
+// 索引表项：查找时只访问索引表，选中的条目才复制pcv_t
+struct PPPAntexIndex::Key {
+    char type[MAXANT];     // 天线类型
+    char code[MAXANT];     // 序列号或卫星代码
+    qint32 sat;            // 卫星号，0为接收机天线
+    qint32 reserved;
+    qint64 ts, te;         // 有效期 (time_t)，0为不限
+    double tsSec, teSec;
+};
+
+PPPAntexIndex::PPPAntexIndex()
+    : m_keys(nullptr), m_pcv(nullptr), m_count(0), m_rebuilt(false), m_openMs(0.0)
+{
+}
+
+PPPAntexIndex::~PPPAntexIndex()
+{
+}
+
+bool PPPAntexIndex::rebuilt() const
+{
+    return m_rebuilt;
+}
+
+double PPPAntexIndex::openMs() const
+{
+    return m_openMs;
+}
+
+int PPPAntexIndex::count() const
+{
+    return m_count;
+}
+
+qint64 PPPAntexIndex::bytes() const
+{
+    return qint64(m_count) * qint64(sizeof(Key) + sizeof(pcv_t));
+}
+
+QString PPPAntexIndex::indexDir()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    if (dir.isEmpty()) {
+        dir = QDir::tempPath();
+    }
+    return QDir(dir).filePath("ppp_app/antex");
+}
+
+bool PPPAntexIndex::open(const char *file, QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_rebuilt = false;
+
+    // 索引文件名为ANTEX文件规范路径的MD5（进程内解压的管道按原压缩文件）
+    QByteArray source = PPPProductCache::fileKey(file);
+    QString path;
+    if (!source.isEmpty()) {
+        QString name = PPPDecompressor::sourceFile(file);
+        QFileInfo info(name.isEmpty() ? QString::fromLocal8Bit(file) : name);
+        QByteArray hash = QCryptographicHash::hash(info.canonicalFilePath().toUtf8(), QCryptographicHash::Md5);
+        path = QDir(indexDir()).filePath(QString::fromLatin1(hash.toHex()) + ".atxi");
+        source = QCryptographicHash::hash(source, QCryptographicHash::Md5);
+    }
+    bool ok = (!path.isEmpty() && load(path, source)) || build(file, path, source, error);
+    m_openMs = timer.nsecsElapsed() / 1e6;
+    return ok;
+}
+
+bool PPPAntexIndex::load(const QString &path, const QByteArray &source)
+{
+    m_file.close();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    AntexIndexHeader header;
+    if (m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        memcmp(header.magic, ANTEX_INDEX_MAGIC, sizeof(header.magic)) || header.keySize != sizeof(Key) ||
+        header.pcvSize != sizeof(pcv_t) || memcmp(header.source, source.constData(), sizeof(header.source)) ||
+        header.count <= 0 || header.count > INT_MAX) {
+        m_file.close();
+        return false;
+    }
+    qint64 size = header.count * qint64(sizeof(Key) + sizeof(pcv_t));
+    const uchar *data = m_file.size() == qint64(sizeof(header)) + size ? m_file.map(sizeof(header), size) : nullptr;
+    if (!data || QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size)),
+                                          QCryptographicHash::Md5) !=
+                     QByteArray::fromRawData(reinterpret_cast<const char *>(header.digest), sizeof(header.digest))) {
+        m_file.close();
+        return false;
+    }
+    m_count = int(header.count);
+    m_keys = reinterpret_cast<const Key *>(data);
+    m_pcv = reinterpret_cast<const pcv_t *>(data + qint64(m_count) * sizeof(Key));
+    return true;
+}
+
+bool PPPAntexIndex::build(const char *file, const QString &path, const QByteArray &source, QString *error)
+{
+    pcvs_t pcvs = {};
+    if (!readpcv(file, &pcvs) || pcvs.n <= 0) {
+        free(pcvs.pcv);
+        *error = QString("error : no ant pcv in %1").arg(file);
+        return false;
+    }
+    m_rebuilt = true;
+
+    // 索引表与各条目的pcv_t
+    QByteArray data(int(pcvs.n * qint64(sizeof(Key) + sizeof(pcv_t))), '\0');
+    Key *keys = reinterpret_cast<Key *>(data.data());
+    for (int i = 0; i < pcvs.n; i++) {
+        const pcv_t &pcv = pcvs.pcv[i];
+        memcpy(keys[i].type, pcv.type, MAXANT);
+        memcpy(keys[i].code, pcv.code, MAXANT);
+        keys[i].sat = pcv.sat;
+        keys[i].ts = qint64(pcv.ts.time);
+        keys[i].te = qint64(pcv.te.time);
+        keys[i].tsSec = pcv.ts.sec;
+        keys[i].teSec = pcv.te.sec;
+    }
+    memcpy(data.data() + qint64(pcvs.n) * sizeof(Key), pcvs.pcv, size_t(pcvs.n) * sizeof(pcv_t));
+    int n = pcvs.n;
+    free(pcvs.pcv);
+
+    // 写入索引文件后映射，写入失败时使用内存中的数据
+    if (!path.isEmpty() && QDir().mkpath(QFileInfo(path).path())) {
+        AntexIndexHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, ANTEX_INDEX_MAGIC, sizeof(header.magic));
+        header.keySize = sizeof(Key);
+        header.pcvSize = sizeof(pcv_t);
+        header.count = n;
+        memcpy(header.source, source.constData(), sizeof(header.source));
+        memcpy(header.digest, QCryptographicHash::hash(data, QCryptographicHash::Md5).constData(),
+               sizeof(header.digest));
+        QSaveFile out(path);
+        if (out.open(QIODevice::WriteOnly) &&
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header)) &&
+            out.write(data) == data.size() && out.commit() && load(path, source)) {
+            return true;
+        }
+    }
+    m_file.close();
+    m_memory = data;
+    m_count = n;
+    m_keys = reinterpret_cast<const Key *>(m_memory.constData());
+    m_pcv = reinterpret_cast<const pcv_t *>(m_memory.constData() + qint64(n) * sizeof(Key));
+    return true;
+}
+
+bool PPPAntexIndex::append(int index, pcvs_t *pcvs) const
+{
+    // 与RTKLIB的addpcv相同的扩展方式
+    if (pcvs->nmax <= pcvs->n) {
+        int nmax = pcvs->nmax + 256;
+        pcv_t *pcv = static_cast<pcv_t *>(realloc(pcvs->pcv, sizeof(pcv_t) * nmax));
+        if (!pcv) {
+            return false;
+        }
+        pcvs->pcv = pcv;
+        pcvs->nmax = nmax;
+    }
+    pcvs->pcv[pcvs->n++] = m_pcv[index];
+    return true;
+}
+
+bool PPPAntexIndex::selectSatellites(int navsys, gtime_t time, pcvs_t *pcvs) const
+{
+    // 有效期的判断与searchpcv相同
+    for (int i = 0; i < m_count; i++) {
+        const Key &key = m_keys[i];
+        if (key.sat <= 0 || !(satsys(key.sat, nullptr) & navsys)) continue;
+        gtime_t ts = { time_t(key.ts), key.tsSec }, te = { time_t(key.te), key.teSec };
+        if (ts.time != 0 && timediff(ts, time) > 0.0) continue;
+        if (te.time != 0 && timediff(te, time) < 0.0) continue;
+        if (!append(i, pcvs)) return false;
+    }
+    return true;
+}
+
+bool PPPAntexIndex::selectReceiver(const char *type, pcvs_t *pcvs) const
+{
+    // searchpcv先查找包含型号和天线罩的类型，再查找以型号开头的类型，两者都包含型号
+    char model[MAXANT] = "";
+    sscanf(type, "%63s", model);
+    if (!*model) {
+        return true;
+    }
+    for (int i = 0; i < m_count; i++) {
+        if (strstr(m_keys[i].type, model) && !append(i, pcvs)) return false;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef PPPANTEXINDEX_H
+#define PPPANTEXINDEX_H
+
+#include "rtklib.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <memory>
+
+// ANTEX文件的持久索引
+// IGS的ANTEX文件有数千个天线条目，而一个任务只用到约一百颗卫星的天线和一个接收机天线。
+// 第一次使用某个ANTEX文件时由readpcv读取全部条目，把按天线类型、序列号（卫星代码）和有效期
+// 组织的索引表以及各条目的pcv_t写入索引文件；之后映射索引文件，只复制需要的条目，
+// 选出的条目保持原文件中的顺序，searchpcv的查找结果与使用完整的天线表相同。
+// 索引文件按ANTEX文件的路径命名，文件修改（大小或修改时间变化）后自动重建；
+// 索引目录不可写时在内存中保存读取结果。
+class PPPAntexIndex
+{
+public:
+    PPPAntexIndex();
+    ~PPPAntexIndex();
+
+    // 打开file的索引，不存在、过期或损坏时重建
+    bool open(const char *file, QString *error);
+
+    // 本次打开是否重新读取了ANTEX文件，以及打开的耗时 (ms)
+    bool rebuilt() const;
+    double openMs() const;
+
+    int count() const;      // 条目数
+    qint64 bytes() const;   // 索引占用的内存（映射或读取的数据）(byte)
+
+    // 卫星天线：navsys中各卫星在time有效的条目，追加到pcvs
+    bool selectSatellites(int navsys, gtime_t time, pcvs_t *pcvs) const;
+
+    // 接收机天线：类型中包含type第一部分（天线型号，不含天线罩）的条目，追加到pcvs
+    bool selectReceiver(const char *type, pcvs_t *pcvs) const;
+
+    // 索引文件所在目录
+    static QString indexDir();
+
+private:
+    struct Key;
+
+    bool load(const QString &path, const QByteArray &source);
+    bool build(const char *file, const QString &path, const QByteArray &source, QString *error);
+    bool append(int index, pcvs_t *pcvs) const;
+
+    QFile m_file;             // 映射的索引文件
+    QByteArray m_memory;      // 索引目录不可写时在内存中的索引数据
+    const Key *m_keys;
+    const pcv_t *m_pcv;
+    int m_count;
+    bool m_rebuilt;
+    double m_openMs;
+
+    Q_DISABLE_COPY(PPPAntexIndex)
+};
+
+#endif // PPPANTEXINDEX_H
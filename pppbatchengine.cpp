@@ -0,0 +1,225 @@
+#include "pppbatchengine.h"
+#include "pppjobfile.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QProcess>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+// 取消时等待工作进程自行退出的时间 (ms)
+static const int WORKER_KILL_TIMEOUT = 5000;
+
+PPPBatchEngine::PPPBatchEngine(QObject *parent)
+    : QObject(parent), m_workerCount(QThread::idealThreadCount()), m_elapsed(0.0),
+      m_running(0), m_completed(0), m_cancelled(false)
+{
+    if (QCoreApplication::instance()) {
+        m_program = QCoreApplication::applicationFilePath();
+    }
+}
+
+PPPBatchEngine::~PPPBatchEngine()
+{
+    for (Worker &worker : m_workers) {
+        if (worker.process) {
+            worker.process->disconnect(this);
+            worker.process->kill();
+            worker.process->waitForFinished();
+        }
+    }
+}
+
+void PPPBatchEngine::setWorkerProgram(const QString &program)
+{
+    m_program = program;
+}
+
+void PPPBatchEngine::setWorkerCount(int count)
+{
+    m_workerCount = qMax(1, count);
+}
+
+int PPPBatchEngine::workerCount() const
+{
+    return m_workerCount;
+}
+
+void PPPBatchEngine::addJob(const ppp_paths_t &job)
+{
+    m_jobs.append(job);
+}
+
+void PPPBatchEngine::addJobs(const QList<ppp_paths_t> &jobs)
+{
+    m_jobs.append(jobs);
+}
+
+int PPPBatchEngine::jobCount() const
+{
+    return m_jobs.size();
+}
+
+bool PPPBatchEngine::isRunning() const
+{
+    return m_running > 0;
+}
+
+const QVector<PPPBatchResult> &PPPBatchEngine::results() const
+{
+    return m_results;
+}
+
+double PPPBatchEngine::elapsedSeconds() const
+{
+    return m_timer.isValid() && m_running > 0 ? m_timer.elapsed() / 1000.0 : m_elapsed;
+}
+
+double PPPBatchEngine::stationsPerHour() const
+{
+    double elapsed = elapsedSeconds();
+    return elapsed > 0.0 ? m_completed * 3600.0 / elapsed : 0.0;
+}
+
+void PPPBatchEngine::scheduleJobs()
+{
+    // 大文件优先调度，避免最后只剩一个长任务在运行
+    QVector<qint64> sizes(m_jobs.size());
+    m_queue.clear();
+    for (int i = 0; i < m_jobs.size(); i++) {
+        sizes[i] = QFileInfo(QString::fromLocal8Bit(m_jobs[i].obs_file)).size();
+        m_queue.append(i);
+    }
+    std::stable_sort(m_queue.begin(), m_queue.end(), [&sizes](int a, int b) {
+        return sizes[a] > sizes[b];
+    });
+}
+
+bool PPPBatchEngine::start()
+{
+    if (m_running > 0 || m_jobs.isEmpty() || m_program.isEmpty()) {
+        return false;
+    }
+
+    m_results = QVector<PPPBatchResult>(m_jobs.size());
+    for (int i = 0; i < m_jobs.size(); i++) {
+        m_results[i] = PPPBatchResult{ QString::fromLocal8Bit(m_jobs[i].obs_file), false, false, -1, 0.0, QString() };
+    }
+    m_completed = 0;
+    m_cancelled = false;
+    scheduleJobs();
+
+    m_workers = QVector<Worker>(qMin(m_workerCount, m_jobs.size()));
+    m_timer.start();
+    for (Worker &worker : m_workers) {
+        worker.process = nullptr;
+        worker.job = -1;
+        startNext(&worker);
+    }
+    return true;
+}
+
+void PPPBatchEngine::startNext(Worker *worker)
+{
+    if (m_cancelled || m_queue.isEmpty()) {
+        return;
+    }
+    worker->job = m_queue.takeFirst();
+    worker->process = new QProcess(this);
+    worker->process->setProcessChannelMode(QProcess::SeparateChannels);
+    worker->process->setStandardOutputFile(QProcess::nullDevice());
+
+    QProcess *process = worker->process;
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, process]() { onWorkerFinished(process); });
+    connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+        // 程序无法启动时不会发出finished信号
+        if (error == QProcess::FailedToStart) {
+            onWorkerFinished(process);
+        }
+    });
+
+    m_running++;
+    worker->timer.start();
+    emit jobStarted(worker->job, m_results[worker->job].obsFile);
+
+    // 任务参数通过标准输入传给工作进程，以结束行结束，标准输入保持打开以便发送取消请求
+    process->start(m_program, QStringList() << "-");
+    process->write(PPPJobFile::format(m_jobs[worker->job]));
+    process->write(QByteArray(PPPJobFile::END_LINE) + '\n');
+}
+
+void PPPBatchEngine::onWorkerFinished(QProcess *process)
+{
+    Worker *worker = nullptr;
+    for (Worker &w : m_workers) {
+        if (w.process == process) {
+            worker = &w;
+        }
+    }
+    if (!worker) {
+        return;
+    }
+
+    PPPBatchResult &result = m_results[worker->job];
+    result.wallTime = worker->timer.elapsed() / 1000.0;
+    result.crashed = process->error() == QProcess::FailedToStart || process->exitStatus() == QProcess::CrashExit;
+    result.exitCode = result.crashed ? -1 : process->exitCode();
+    result.success = !result.crashed && result.exitCode == 0;
+
+    // 工作进程的最后一行输出为处理状态
+    const QList<QByteArray> lines = process->readAllStandardError().trimmed().split('\n');
+    result.message = QString::fromLocal8Bit(lines.last()).trimmed();
+    if (process->error() == QProcess::FailedToStart) {
+        result.message = QString("无法启动工作进程: %1").arg(m_program);
+    } else if (result.crashed) {
+        result.message = "工作进程异常退出";
+    }
+
+    m_running--;
+    m_completed++;
+    int index = worker->job;
+    worker->process = nullptr;
+    worker->job = -1;
+    process->deleteLater();
+
+    emit jobFinished(index, result);
+    startNext(worker);
+
+    if (m_running == 0) {
+        finish();
+    }
+}
+
+void PPPBatchEngine::finish()
+{
+    if (m_timer.isValid()) {
+        m_elapsed = m_timer.elapsed() / 1000.0;
+    }
+    int succeeded = 0;
+    for (const PPPBatchResult &r : m_results) {
+        if (r.success) succeeded++;
+    }
+    emit finished(succeeded, m_results.size() - succeeded);
+}
+
+void PPPBatchEngine::cancel()
+{
+    m_cancelled = true;
+    for (int index : m_queue) {
+        m_results[index].message = "已取消";
+    }
+    m_queue.clear();
+    if (m_running == 0) {
+        // 不会再有工作进程结束，在返回后发出finished
+        QTimer::singleShot(0, this, [this]() { finish(); });
+        return;
+    }
+    for (Worker &worker : m_workers) {
+        if (QProcess *process = worker.process) {
+            // ppp_cli从标准输入收到取消请求后在下一历元退出，超时后强制结束
+            process->write(QByteArray(CANCEL_LINE) + '\n');
+            process->closeWriteChannel();
+            QTimer::singleShot(WORKER_KILL_TIMEOUT, process, [process]() { process->kill(); });
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef PPPBATCHENGINE_H
+#define PPPBATCHENGINE_H
+
+#include "pppprocessor.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QProcess;
+
+// 单个批处理任务的结果
+struct PPPBatchResult {
+    QString obsFile;       // 观测文件
+    bool success;          // 是否成功
+    bool crashed;          // 工作进程是否崩溃
+    int exitCode;          // 工作进程退出码
+    double wallTime;       // 任务墙钟时间 (s)
+    QString message;       // 工作进程最后输出的状态信息
+};
+Q_DECLARE_METATYPE(PPPBatchResult)
+
+// 多进程批处理引擎
+// RTKLIB使用全局状态（traceopen、postpos内部静态缓冲区），任务无法在线程间安全共享，
+// 因此每个任务在独立的 ppp_cli 工作进程中运行，任务参数通过标准输入传递。
+// 工作进程崩溃只会导致其自身的任务失败。
+// 标准输入在任务之后保持打开，取消时发送CANCEL_LINE：Windows上QProcess::terminate()只发送WM_CLOSE，
+// 控制台程序收不到，工作进程由标准输入得知取消请求并在下一历元退出。
+class PPPBatchEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 发送给工作进程的取消请求
+    static constexpr const char *CANCEL_LINE = "cancel";
+
+    explicit PPPBatchEngine(QObject *parent = nullptr);
+    ~PPPBatchEngine();
+
+    // 工作进程程序（ppp_cli）路径
+    void setWorkerProgram(const QString &program);
+
+    // 并行工作进程数，默认为逻辑核心数
+    void setWorkerCount(int count);
+    int workerCount() const;
+
+    // 添加任务
+    void addJob(const ppp_paths_t &job);
+    void addJobs(const QList<ppp_paths_t> &jobs);
+    int jobCount() const;
+
+    // 开始处理（异步，需要事件循环）
+    bool start();
+
+    // 取消尚未开始的任务并请求正在运行的工作进程退出，没有运行中的工作进程时也发出finished
+    void cancel();
+
+    bool isRunning() const;
+    const QVector<PPPBatchResult> &results() const;
+
+    // 统计信息
+    double elapsedSeconds() const;
+    double stationsPerHour() const;
+
+signals:
+    void jobStarted(int index, const QString &obsFile);
+    void jobFinished(int index, const PPPBatchResult &result);
+    void finished(int succeeded, int failed);
+
+private slots:
+    void onWorkerFinished(QProcess *process);
+
+private:
+    struct Worker {
+        QProcess *process;
+        int job;
+        QElapsedTimer timer;
+    };
+
+    void scheduleJobs();
+    void startNext(Worker *worker);
+    void finish();
+
+    QString m_program;
+    int m_workerCount;
+    QList<ppp_paths_t> m_jobs;
+    QList<int> m_queue;                 // 待处理任务（按观测文件大小降序）
+    QVector<Worker> m_workers;
+    QVector<PPPBatchResult> m_results;
+    QElapsedTimer m_timer;
+    double m_elapsed;
+    int m_running;
+    int m_completed;
+    bool m_cancelled;
+};
+
+#endif // PPPBATCHENGINE_H
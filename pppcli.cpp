@@ -0,0 +1,489 @@
+#include "pppbatchengine.h"
+#include "pppcombinedrunner.h"
+#include "pppjobfile.h"
+#include "ppppipeline.h"
+#include "pppproductcache.h"
+#include "pppprocessor.h"
+#include "pppshardrunner.h"
+#include "pppsolutionfile.h"
+#include "pppsweep.h"
+#include "ppptracer.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+// 退出码
+enum {
+    EXIT_OK = 0,          // 处理成功
+    EXIT_FAILED = 1,      // 处理失败
+    EXIT_USAGE = 2,       // 参数或任务文件错误
+    EXIT_CANCELLED = 3,   // 被中断信号取消
+    EXIT_SEAM = 4         // 分片处理已拼接，但有接缝未通过连续性检查
+};
+
+static PPPProcessor *s_processor = nullptr;
+static std::atomic<bool> s_interrupted{false};
+
+static void onSignal(int)
+{
+    // 只设置原子标志，postpos在下一历元返回
+    s_interrupted = true;
+    if (s_processor) {
+        s_processor->cancelProcessing();
+    }
+}
+
+// 从标准输入读取任务时，继续读取批处理引擎发送的取消请求（Windows上控制台程序收不到terminate()）
+// 读取线程一直阻塞在标准输入上，不等待其结束，进程退出时随之结束
+static void watchCancelRequest()
+{
+    QThread *watcher = QThread::create([]() {
+        char line[256];
+        while (fgets(line, sizeof(line), stdin)) {
+            if (QByteArray(line).trimmed() == PPPBatchEngine::CANCEL_LINE) {
+                onSignal(SIGTERM);
+                return;
+            }
+        }
+    });
+    watcher->start();
+}
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "用法: ppp_cli [-v] <任务文件>\n"
+            "      ppp_cli --batch <批处理任务文件> [-j 进程数 | --pipeline]\n"
+            "      ppp_cli --sweep <参数扫描文件> [-j 线程数] <任务文件>\n"
+            "      ppp_cli --sol2pos <二进制结果文件> <输出文件>\n"
+            "      ppp_cli --trace2txt <跟踪文件> <输出文件>\n"
+            "      以上处理均可加 --product-cache <MB>\n"
+            "  -v          输出处理进度信息\n"
+            "  -j          并行工作进程数（默认为逻辑核心数），也用于分片处理和参数扫描\n"
+            "  --pipeline  在单个进程中依次处理，读取下一个任务的文件与当前任务的解算重叠\n"
+            "  --sol2pos   把二进制结果文件（solformat = binary）转换为.pos文本\n"
+            "  --trace2txt 把二进制日志（ppp_log_*.trc）转换为RTKLIB的文本日志\n"
+            "  --product-cache 进程内各任务共享的精密产品、星历和天线参数缓存的内存预算（MB，0为不缓存），\n"
+            "              --pipeline和--sweep默认512，其他方式每个进程只处理一个任务，默认不缓存\n"
+            "  任务文件    为 '-' 时从标准输入读取\n"
+            "性能测试见 ppp_bench\n"
+            "退出码: 0 成功, 1 处理失败, 2 参数错误, 3 已取消, 4 分片接缝未通过检查\n");
+}
+
+// 批处理：每个任务在独立的工作进程中运行
+static int runBatch(int &argc, char *argv[], const QString &batchPath, int workers)
+{
+    QList<ppp_paths_t> jobs;
+    QString error;
+    if (!PPPJobFile::loadBatch(batchPath, &jobs, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+
+    QCoreApplication app(argc, argv);
+    PPPBatchEngine engine;
+    if (workers > 0) {
+        engine.setWorkerCount(workers);
+    }
+    engine.addJobs(jobs);
+
+    QObject::connect(&engine, &PPPBatchEngine::jobFinished, [](int index, const PPPBatchResult &result) {
+        fprintf(stdout, "%-4d %-6s %8.1f s  %s  %s\n", index + 1, result.success ? "成功" : "失败", result.wallTime,
+                QFileInfo(result.obsFile).fileName().toLocal8Bit().constData(),
+                result.message.toLocal8Bit().constData());
+        fflush(stdout);
+    });
+    QObject::connect(&engine, &PPPBatchEngine::finished, &app, [&app](int, int failed) {
+        app.exit(failed > 0 ? EXIT_FAILED : EXIT_OK);
+    });
+
+    // 信号处理函数中不能调用Qt，由定时器轮询中断标志
+    QTimer interruptTimer;
+    QObject::connect(&interruptTimer, &QTimer::timeout, [&engine, &interruptTimer]() {
+        if (s_interrupted) {
+            interruptTimer.stop();
+            engine.cancel();
+        }
+    });
+    interruptTimer.start(200);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    fprintf(stdout, "共 %d 个任务，%d 个工作进程\n", engine.jobCount(), engine.workerCount());
+    if (!engine.start()) {
+        fprintf(stderr, "错误: 无法启动批处理\n");
+        return EXIT_FAILED;
+    }
+    int ret = app.exec();
+
+    // 统计信息
+    double total = 0.0, longest = 0.0;
+    int succeeded = 0;
+    for (const PPPBatchResult &result : engine.results()) {
+        total += result.wallTime;
+        longest = qMax(longest, result.wallTime);
+        if (result.success) succeeded++;
+    }
+    int n = engine.results().size();
+    fprintf(stdout, "完成 %d/%d，总耗时 %.1f s，%.1f 站/小时，单任务平均 %.1f s，最长 %.1f s\n",
+            succeeded, n, engine.elapsedSeconds(), engine.stationsPerHour(), n > 0 ? total / n : 0.0, longest);
+    return s_interrupted ? EXIT_CANCELLED : ret;
+}
+
+// 流水线批处理：I/O线程预读下一个任务，解算线程处理当前任务
+static int runPipeline(int &argc, char *argv[], const QString &batchPath)
+{
+    QList<ppp_paths_t> jobs;
+    QString error;
+    if (!PPPJobFile::loadBatch(batchPath, &jobs, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+
+    QCoreApplication app(argc, argv);
+    PPPPipeline pipeline;
+    pipeline.addJobs(jobs);
+
+    QObject::connect(&pipeline, &PPPPipeline::jobFinished, [](int index, const PPPBatchResult &result) {
+        fprintf(stdout, "%-4d %-6s %8.1f s  %s  %s\n", index + 1, result.success ? "成功" : "失败", result.wallTime,
+                QFileInfo(result.obsFile).fileName().toLocal8Bit().constData(),
+                result.message.toLocal8Bit().constData());
+        fflush(stdout);
+    });
+    QObject::connect(&pipeline, &PPPPipeline::finished, &app, [&app](int, int failed) {
+        app.exit(failed > 0 ? EXIT_FAILED : EXIT_OK);
+    });
+
+    QTimer interruptTimer;
+    QObject::connect(&interruptTimer, &QTimer::timeout, [&pipeline, &interruptTimer]() {
+        if (s_interrupted) {
+            interruptTimer.stop();
+            pipeline.cancel();
+        }
+    });
+    interruptTimer.start(200);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    fprintf(stdout, "共 %d 个任务，流水线处理\n", pipeline.jobCount());
+    if (!pipeline.start()) {
+        fprintf(stderr, "错误: 无法启动批处理\n");
+        return EXIT_FAILED;
+    }
+    int ret = app.exec();
+    pipeline.wait();
+
+    // 各阶段统计：等待时间长的一方不是瓶颈
+    PPPStageStats read = pipeline.readStats();
+    PPPStageStats solve = pipeline.solveStats();
+    fprintf(stdout, "读取: %d 个任务，工作 %.1f s，等待 %.1f s，%.1f MB/s\n", read.jobs, read.busySeconds,
+            read.waitSeconds, read.busySeconds > 0.0 ? read.bytes / 1048576.0 / read.busySeconds : 0.0);
+    fprintf(stdout, "解算: %d 个任务，工作 %.1f s，等待 %.1f s，%.0f 历元/s\n", solve.jobs, solve.busySeconds,
+            solve.waitSeconds, solve.busySeconds > 0.0 ? solve.epochs / solve.busySeconds : 0.0);
+    fprintf(stdout, "总耗时 %.1f s，瓶颈: %s\n", pipeline.elapsedSeconds(),
+            solve.waitSeconds > read.waitSeconds ? "文件读取" : "滤波解算");
+    PPPProductCache &cache = PPPProductCache::instance();
+    fprintf(stdout, "产品缓存: 命中 %d 次，未命中 %d 次，占用 %.1f MB\n", cache.hits(), cache.misses(),
+            cache.bytes() / 1048576.0);
+    return s_interrupted ? EXIT_CANCELLED : ret;
+}
+
+// 参数扫描：输入读取一次，各参数组合在多个线程中处理，输出综合排名
+static int runSweep(int &argc, char *argv[], const ppp_paths_t &paths, const QString &gridPath, int threads)
+{
+    QList<ppp_paths_t> variants;
+    QStringList labels;
+    QString error;
+    if (!PPPJobFile::loadSweep(gridPath, paths, &variants, &labels, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+
+    QCoreApplication app(argc, argv);
+    PPPSweep sweep;
+    if (threads > 0) {
+        sweep.setThreadCount(threads);
+    }
+    auto seconds = [](double t) { return t < 0.0 ? QByteArray("-") : QByteArray::number(t, 'f', 0); };
+    auto meters = [](double v) { return v < 0.0 ? QByteArray("-") : QByteArray::number(v, 'f', 4); };
+
+    QObject::connect(&sweep, &PPPSweep::loaded, [](bool, const QString &message) {
+        fprintf(stdout, "%s\n", message.toLocal8Bit().constData());
+        fflush(stdout);
+    });
+    QObject::connect(&sweep, &PPPSweep::variantFinished, [&](int index, const PPPSweepResult &result) {
+        fprintf(stdout, "%-4d %-6s %8.1f s  收敛 %s s  %s\n", index + 1, result.success ? "成功" : "失败",
+                result.wallTime, seconds(result.convergence).constData(), result.label.toLocal8Bit().constData());
+        fflush(stdout);
+    });
+    QString status;
+    QObject::connect(&sweep, &PPPSweep::finished, &app, [&app, &status](bool success, const QString &message) {
+        status = message;
+        app.exit(success ? EXIT_OK : EXIT_FAILED);
+    });
+
+    QTimer interruptTimer;
+    QObject::connect(&interruptTimer, &QTimer::timeout, [&sweep, &interruptTimer]() {
+        if (s_interrupted) {
+            interruptTimer.stop();
+            sweep.cancel();
+        }
+    });
+    interruptTimer.start(200);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    fprintf(stdout, "共 %d 个参数组合，%d 个线程\n", variants.size(), sweep.threadCount());
+    if (!sweep.start(variants, labels, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+    int ret = app.exec();
+    sweep.wait();
+
+    // 综合排名
+    double total = 0.0;
+    fprintf(stdout, "\n%-4s %10s %10s %10s %8s  %s\n", "排名", "收敛(s)", "最终σ(m)", "离散度(m)", "历元", "参数");
+    for (const PPPSweepResult &result : sweep.ranking()) {
+        total += result.wallTime;
+        fprintf(stdout, "%-4d %10s %10s %10s %8d  %s\n", result.rank, seconds(result.convergence).constData(),
+                meters(result.finalSigma).constData(), meters(result.repeatability).constData(), result.epochs,
+                result.label.toLocal8Bit().constData());
+    }
+    fprintf(stdout, "%s，读取输入 %.1f s，各组合处理时间合计 %.1f s\n", status.toLocal8Bit().constData(),
+            sweep.loadSeconds(), total);
+    return s_interrupted ? EXIT_CANCELLED : ret;
+}
+
+// 二进制结果文件转换为.pos文本
+static int runSolConvert(const char *file, const char *outfile)
+{
+    ppp_paths_t paths;
+    PPPProcessor::initPaths(&paths);
+    solopt_t sopt;
+    PPPProcessor::initSolutionOptions(&paths, &sopt);
+    QString error;
+    if (!PPPSolutionFile::toText(QString::fromLocal8Bit(file), QString::fromLocal8Bit(outfile), &sopt, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    return EXIT_OK;
+}
+
+// 跟踪日志转换为文本
+static int runTraceConvert(const char *file, const char *outfile)
+{
+    QString error;
+    if (!PPPTracer::decode(QString::fromLocal8Bit(file), QString::fromLocal8Bit(outfile), &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    return EXIT_OK;
+}
+
+// 分片处理：时间窗在独立的工作进程中并行处理后拼接
+static int runSharded(int &argc, char *argv[], const ppp_paths_t &paths, int workers, bool verbose)
+{
+    QCoreApplication app(argc, argv);
+    PPPShardRunner runner;
+    if (workers > 0) {
+        runner.setWorkerCount(workers);
+    }
+    if (verbose) {
+        QObject::connect(&runner, &PPPShardRunner::shardFinished, [](int index, const PPPBatchResult &result) {
+            fprintf(stderr, "分片 %d %s %.1f s  %s\n", index + 1, result.success ? "成功" : "失败", result.wallTime,
+                    result.message.toLocal8Bit().constData());
+        });
+    }
+    QString status;
+    QObject::connect(&runner, &PPPShardRunner::finished, &app, [&app, &status](bool success, const QString &message) {
+        status = message;
+        app.exit(success ? EXIT_OK : EXIT_FAILED);
+    });
+
+    QTimer interruptTimer;
+    QObject::connect(&interruptTimer, &QTimer::timeout, [&runner, &interruptTimer]() {
+        if (s_interrupted) {
+            interruptTimer.stop();
+            runner.cancel();
+        }
+    });
+    interruptTimer.start(200);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    QString error;
+    if (!runner.start(paths, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+    int ret = app.exec();
+
+    for (const QString &line : runner.seamReport()) {
+        fprintf(stderr, "%s\n", line.toLocal8Bit().constData());
+    }
+    fprintf(stderr, "%s\n", status.toLocal8Bit().constData());
+    if (s_interrupted) {
+        return EXIT_CANCELLED;
+    }
+    return ret == EXIT_OK && runner.seamFailures() > 0 ? EXIT_SEAM : ret;
+}
+
+// 组合解：前向和后向滤波在两个工作进程中同时运行
+static int runCombined(int &argc, char *argv[], const ppp_paths_t &paths, bool verbose)
+{
+    QCoreApplication app(argc, argv);
+    PPPCombinedRunner runner;
+    if (verbose) {
+        QObject::connect(&runner, &PPPCombinedRunner::passFinished, [&runner](bool backward, const PPPBatchResult &result) {
+            fprintf(stderr, "%s滤波%s %.1f s，已合并 %d 个历元\n", backward ? "后向" : "前向",
+                    result.success ? "完成" : "失败", result.wallTime, runner.mergedCount());
+        });
+    }
+    QString status;
+    QObject::connect(&runner, &PPPCombinedRunner::finished, &app, [&app, &status](bool success, const QString &message) {
+        status = message;
+        app.exit(success ? EXIT_OK : EXIT_FAILED);
+    });
+
+    QTimer interruptTimer;
+    QObject::connect(&interruptTimer, &QTimer::timeout, [&runner, &interruptTimer]() {
+        if (s_interrupted) {
+            interruptTimer.stop();
+            runner.cancel();
+        }
+    });
+    interruptTimer.start(200);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    QString error;
+    if (!runner.start(paths, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    int ret = app.exec();
+    fprintf(stderr, "%s\n", status.toLocal8Bit().constData());
+    return s_interrupted ? EXIT_CANCELLED : ret;
+}
+
+int main(int argc, char *argv[])
+{
+    // 命令行版本不创建QApplication，避免GUI初始化开销
+    const char *jobPath = nullptr;
+    const char *batchPath = nullptr;
+    const char *sweepPath = nullptr;
+    const char *solPath = nullptr;
+    const char *solOutPath = nullptr;
+    const char *tracePath = nullptr;
+    const char *traceOutPath = nullptr;
+    bool verbose = false;
+    bool pipeline = false;
+    int workers = 0;
+    double productCache = -1.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else if (!strcmp(argv[i], "--batch") && i + 1 < argc) {
+            batchPath = argv[++i];
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--sweep") && i + 1 < argc) {
+            sweepPath = argv[++i];
+        } else if (!strcmp(argv[i], "--trace2txt") && i + 2 < argc) {
+            tracePath = argv[++i];
+            traceOutPath = argv[++i];
+        } else if (!strcmp(argv[i], "--sol2pos") && i + 2 < argc) {
+            solPath = argv[++i];
+            solOutPath = argv[++i];
+        } else if (!strcmp(argv[i], "--product-cache") && i + 1 < argc) {
+            productCache = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "--pipeline")) {
+            pipeline = true;
+        } else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            printUsage();
+            return EXIT_OK;
+        } else if (!jobPath) {
+            jobPath = argv[i];
+        } else {
+            printUsage();
+            return EXIT_USAGE;
+        }
+    }
+    // 产品缓存只在一个进程处理多个任务时有用，单任务和批处理的工作进程缺省不缓存
+    if (productCache >= 0.0) {
+        PPPProductCache::instance().setBudget(qint64(productCache * 1048576.0));
+    } else if (!(batchPath && pipeline) && !sweepPath) {
+        PPPProductCache::instance().setBudget(0);
+    }
+    if (solPath) {
+        return runSolConvert(solPath, solOutPath);
+    }
+    if (tracePath) {
+        return runTraceConvert(tracePath, traceOutPath);
+    }
+    if (batchPath && pipeline) {
+        return runPipeline(argc, argv, QString::fromLocal8Bit(batchPath));
+    }
+    if (batchPath) {
+        return runBatch(argc, argv, QString::fromLocal8Bit(batchPath), workers);
+    }
+    if (!jobPath) {
+        printUsage();
+        return EXIT_USAGE;
+    }
+
+    ppp_paths_t paths;
+    QString error;
+    if (!PPPJobFile::load(QString::fromLocal8Bit(jobPath), &paths, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+
+    if (!strcmp(jobPath, "-")) {
+        watchCancelRequest();
+    }
+    if (sweepPath) {
+        return runSweep(argc, argv, paths, QString::fromLocal8Bit(sweepPath), workers);
+    }
+    if (paths.shards > 1) {
+        return runSharded(argc, argv, paths, workers, verbose);
+    }
+    if (paths.soltype == SOLTYPE_COMBINED) {
+        return runCombined(argc, argv, paths, verbose);
+    }
+
+    PPPProcessor processor;
+    processor.setPaths(paths);
+    if (verbose) {
+        QObject::connect(&processor, &PPPProcessor::processingProgress, [](int percent, const QString &message) {
+            fprintf(stderr, "[%3d%%] %s\n", percent, message.toLocal8Bit().constData());
+        });
+    }
+
+    s_processor = &processor;
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    if (s_interrupted) {
+        return EXIT_CANCELLED; // 开始处理前已收到取消请求
+    }
+
+    bool success = processor.execute();
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    s_processor = nullptr;
+
+    fprintf(stderr, "%s\n", processor.getStatusMessage().toLocal8Bit().constData());
+    if (processor.wasCancelled()) {
+        return EXIT_CANCELLED;
+    }
+    return success ? EXIT_OK : EXIT_FAILED;
+}
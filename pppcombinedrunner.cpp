@@ -0,0 +1,276 @@
+#include "pppcombinedrunner.h"
+#include "pppengine.h"
+#include "pppsolutionfile.h"
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <cmath>
+
+// 读取工作进程输出的间隔 (ms)
+static const int POLL_INTERVAL = 500;
+
+// 历元时间转为毫秒整数，作为排序和查找的键
+static qint64 timeKey(gtime_t time)
+{
+    return qint64(time.time) * 1000 + qRound64(time.sec * 1000.0);
+}
+
+// 在另一方向尚未配对的历元中查找与time相差小于DTTOL的最近历元，与RTKLIB的combres相同的容差
+static QMap<qint64, sol_t>::iterator findPair(QMap<qint64, sol_t> &pending, gtime_t time)
+{
+    qint64 key = timeKey(time);
+    qint64 tolerance = qint64(DTTOL * 1000.0) + 1; // 键已四舍五入到毫秒
+    auto best = pending.end();
+    for (auto it = pending.lowerBound(key - tolerance); it != pending.end() && it.key() <= key + tolerance; ++it) {
+        double dt = fabs(timediff(it.value().time, time));
+        if (dt < DTTOL && (best == pending.end() || dt < fabs(timediff(best.value().time, time)))) {
+            best = it;
+        }
+    }
+    return best;
+}
+
+// sol_t中的位置协方差展开为3x3矩阵
+static void solutionCovariance(const sol_t &sol, double *P)
+{
+    P[0] = sol.qr[0];
+    P[4] = sol.qr[1];
+    P[8] = sol.qr[2];
+    P[1] = P[3] = sol.qr[3];
+    P[5] = P[7] = sol.qr[4];
+    P[2] = P[6] = sol.qr[5];
+}
+
+PPPCombinedRunner::PPPCombinedRunner(QObject *parent)
+    : QObject(parent)
+{
+    PPPProcessor::initPaths(&m_job);
+    PPPProcessor::initSolutionOptions(&m_job, &m_solopt);
+    m_engine.setWorkerCount(2);
+    connect(&m_engine, &PPPBatchEngine::jobFinished, this, &PPPCombinedRunner::onPassFinished);
+    connect(&m_engine, &PPPBatchEngine::finished, this, &PPPCombinedRunner::onBatchFinished);
+    connect(&m_pollTimer, &QTimer::timeout, this, &PPPCombinedRunner::pollOutputs);
+}
+
+void PPPCombinedRunner::setWorkerProgram(const QString &program)
+{
+    m_engine.setWorkerProgram(program);
+}
+
+int PPPCombinedRunner::mergedCount() const
+{
+    return m_combined.size();
+}
+
+bool PPPCombinedRunner::start(const ppp_paths_t &job, QString *error)
+{
+    if (m_engine.isRunning()) {
+        *error = "组合解处理正在进行中";
+        return false;
+    }
+
+    m_job = job;
+    PPPProcessor::initSolutionOptions(&m_job, &m_solopt);
+    m_combined.clear();
+
+    QString out = QString::fromLocal8Bit(job.out_file);
+    Pass *passes[2] = { &m_forward, &m_backward };
+    const char *suffix[2] = { ".fwd", ".bwd" };
+    for (int i = 0; i < 2; i++) {
+        Pass *pass = passes[i];
+        pass->path = out + suffix[i];
+        pass->offset = 0;
+        pass->pending.clear();
+        QFile::remove(pass->path);
+
+        // 单向结果由PPPEngine写成不带索引的二进制记录，处理完全部历元，不从检查点恢复
+        ppp_paths_t single = job;
+        single.soltype = i == 0 ? SOLTYPE_FORWARD : SOLTYPE_BACKWARD;
+        single.solformat = SOLFORMAT_RECORDS;
+        single.shards = 0;
+        single.checkpoint = false;
+        single.early_stop = false;
+        qstrncpy(single.out_file, pass->path.toLocal8Bit().constData(), sizeof(single.out_file));
+        m_engine.addJob(single);
+    }
+
+    if (!m_engine.start()) {
+        *error = "无法启动前后向工作进程";
+        return false;
+    }
+    m_pollTimer.start(POLL_INTERVAL);
+    return true;
+}
+
+void PPPCombinedRunner::cancel()
+{
+    m_engine.cancel();
+}
+
+void PPPCombinedRunner::pollOutputs()
+{
+    readPass(&m_forward, &m_backward, false);
+    readPass(&m_backward, &m_forward, true);
+}
+
+void PPPCombinedRunner::readPass(Pass *pass, Pass *other, bool backward)
+{
+    QFile file(pass->path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return; // 工作进程尚未创建输出文件
+    }
+    if (pass->offset == 0) {
+        QByteArray header = file.read(PPPSolutionFile::headerSize());
+        if (header.size() < PPPSolutionFile::headerSize() || !PPPSolutionFile::checkHeader(header.constData())) {
+            return; // 尚未写出文件头
+        }
+        pass->offset = header.size();
+    }
+
+    // 只读取完整的记录，写了一半的记录留到下次读取
+    const int size = PPPSolutionFile::recordSize();
+    qint64 count = (file.size() - pass->offset) / size;
+    if (count <= 0 || !file.seek(pass->offset)) {
+        return;
+    }
+    QByteArray data = file.read(count * size);
+    count = data.size() / size;
+    pass->offset += count * size;
+
+    sol_t sol;
+    for (qint64 i = 0; i < count; i++) {
+        PPPSolutionFile::decode(data.constData() + i * size, &sol);
+        if (sol.stat == SOLQ_NONE) {
+            continue; // 结束记录
+        }
+        auto match = findPair(other->pending, sol.time);
+        if (match == other->pending.end()) {
+            pass->pending.insert(timeKey(sol.time), sol);
+            continue;
+        }
+        // 两个方向都已得到该历元，组合解取前向历元的时间；平滑失败的历元与combres一样不输出
+        const sol_t &forward = backward ? match.value() : sol;
+        const sol_t &reverse = backward ? sol : match.value();
+        sol_t combined;
+        if (merge(forward, reverse, &combined)) {
+            m_combined.insert(timeKey(forward.time), combined);
+        }
+        other->pending.erase(match);
+    }
+}
+
+bool PPPCombinedRunner::merge(const sol_t &forward, const sol_t &backward, sol_t *combined) const
+{
+    // 与RTKLIB的combres一致：解算质量不同时取较好的一方，相同时平滑
+    if (forward.stat < backward.stat) {
+        *combined = forward;
+        return true;
+    }
+    if (forward.stat > backward.stat) {
+        *combined = backward;
+        return true;
+    }
+    double Qf[9], Qb[9], xs[3], Qs[9];
+    solutionCovariance(forward, Qf);
+    solutionCovariance(backward, Qb);
+    *combined = forward;
+    if (smoother(forward.rr, Qf, backward.rr, Qb, 3, xs, Qs)) {
+        return false; // 协方差奇异，跳过该历元
+    }
+    for (int i = 0; i < 3; i++) {
+        combined->rr[i] = xs[i];
+    }
+    combined->qr[0] = float(Qs[0]);
+    combined->qr[1] = float(Qs[4]);
+    combined->qr[2] = float(Qs[8]);
+    combined->qr[3] = float(Qs[1]);
+    combined->qr[4] = float(Qs[5]);
+    combined->qr[5] = float(Qs[2]);
+    return true;
+}
+
+void PPPCombinedRunner::onPassFinished(int index, const PPPBatchResult &result)
+{
+    emit passFinished(index == 1, result);
+}
+
+void PPPCombinedRunner::onBatchFinished(int succeeded, int failed)
+{
+    Q_UNUSED(succeeded);
+    m_pollTimer.stop();
+    if (failed > 0) {
+        emit finished(false, QString("%1 个方向处理失败").arg(failed));
+        return;
+    }
+    pollOutputs();
+
+    QString message;
+    bool success = writeOutput(&message);
+    if (success) {
+        removePassFiles();
+    }
+    emit finished(success, message);
+}
+
+bool PPPCombinedRunner::writeOutput(QString *message)
+{
+    if (m_forward.offset == 0 || m_backward.offset == 0) {
+        *message = "无法读取单向结果文件";
+        return false;
+    }
+
+    // 只有一个方向有结果的历元（如一侧的数据中断）原样输出
+    int merged = m_combined.size();
+    for (auto it = m_forward.pending.cbegin(); it != m_forward.pending.cend(); ++it) {
+        m_combined.insert(it.key(), it.value());
+    }
+    for (auto it = m_backward.pending.cbegin(); it != m_backward.pending.cend(); ++it) {
+        m_combined.insert(it.key(), it.value());
+    }
+
+    FILE *fp = fopen(m_job.out_file, "w");
+    if (!fp) {
+        *message = QString("无法创建输出文件: %1").arg(QString::fromLocal8Bit(m_job.out_file));
+        return false;
+    }
+
+    // 头部与postpos的组合解相同（solution : combined），观测起止时间取第一个和最后一个解的时间
+    prcopt_t popt;
+    solopt_t sopt;
+    filopt_t fopt;
+    PPPProcessor::initOptions(&m_job, &popt, &sopt, &fopt);
+    char *infiles[4];
+    int n = PPPProcessor::inputFiles(&m_job, infiles);
+    QList<QByteArray> files;
+    for (int i = 0; i < n; i++) files.append(QByteArray(infiles[i]));
+    gtime_t ts = { 0 }, te = { 0 };
+    if (!m_combined.isEmpty()) {
+        ts = m_combined.first().time;
+        te = m_combined.last().time;
+    }
+    PPPEngine::outputHeader(fp, files, ts, te, &popt, &m_solopt);
+
+    const double rb[3] = { 0.0 };
+    for (const sol_t &sol : m_combined) {
+        outsol(fp, &sol, rb, &m_solopt);
+    }
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0 || !ok) {
+        *message = QString("无法写入输出文件: %1").arg(QString::fromLocal8Bit(m_job.out_file));
+        return false;
+    }
+
+    *message = QString("组合解完成: %1 个历元，其中 %2 个为前后向平滑").arg(m_combined.size()).arg(merged);
+    return true;
+}
+
+void PPPCombinedRunner::removePassFiles()
+{
+    // 保留前向的状态文件作为组合解的残差输出
+    QString stat = QString::fromLocal8Bit(m_job.out_file) + ".stat";
+    QFile::remove(stat);
+    QFile::rename(m_forward.path + ".stat", stat);
+    QFile::remove(m_forward.path);
+    QFile::remove(m_backward.path);
+    QFile::remove(m_backward.path + ".stat");
+}
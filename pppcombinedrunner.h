@@ -0,0 +1,62 @@
+#ifndef PPPCOMBINEDRUNNER_H
+#define PPPCOMBINEDRUNNER_H
+
+#include "pppbatchengine.h"
+#include <QMap>
+#include <QObject>
+#include <QTimer>
+
+// 前后向组合解
+// 前向和后向滤波在两个工作进程中同时运行（RTKLIB的postpos只能先后执行），
+// 两个方向由PPPEngine写出不带索引的二进制结果（solformat = records），保留sol_t的全部精度，
+// 运行期间持续读取两个方向新写出的记录，同一历元两个方向都有结果后立即按协方差加权合并，
+// 全部完成后按时间顺序写出组合解，耗时接近单向处理。
+class PPPCombinedRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PPPCombinedRunner(QObject *parent = nullptr);
+
+    void setWorkerProgram(const QString &program);
+
+    // 开始处理（异步，需要事件循环）
+    bool start(const ppp_paths_t &job, QString *error);
+    void cancel();
+
+    // 已合并的历元数
+    int mergedCount() const;
+
+signals:
+    void passFinished(bool backward, const PPPBatchResult &result);
+    void finished(bool success, const QString &message);
+
+private slots:
+    void onPassFinished(int index, const PPPBatchResult &result);
+    void onBatchFinished(int succeeded, int failed);
+    void pollOutputs();
+
+private:
+    // 正在写出的单向结果文件
+    struct Pass {
+        QString path;
+        qint64 offset;             // 已读取的字节数（文件头和完整的记录），0为尚未读到文件头
+        QMap<qint64, sol_t> pending; // 尚未与另一方向配对的历元
+    };
+
+    void readPass(Pass *pass, Pass *other, bool backward);
+    // 合并同一历元的前后向解，平滑失败返回false
+    bool merge(const sol_t &forward, const sol_t &backward, sol_t *combined) const;
+    bool writeOutput(QString *message);
+    void removePassFiles();
+
+    PPPBatchEngine m_engine;
+    ppp_paths_t m_job;
+    solopt_t m_solopt;
+    Pass m_forward;
+    Pass m_backward;
+    QMap<qint64, sol_t> m_combined;
+    QTimer m_pollTimer;
+};
+
+#endif // PPPCOMBINEDRUNNER_H
@@ -0,0 +1,927 @@
+#include "pppdecompress.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QThread>
+#include <atomic>
+#include <cstring>
+#ifdef PPP_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 每次读取和写入管道的字节数
+static const qint64 BLOCK_BYTES = 1 << 16;
+
+// 各解压器当前提供的管道路径及其原文件，供产品缓存按原文件识别
+static QMutex s_sourceMutex;
+static QHash<QByteArray, QString> s_sources;
+
+// 解压数据源：read返回读取的字节数，0为结束，-1为错误（错误信息在error中）
+class ByteSource
+{
+public:
+    virtual ~ByteSource() {}
+    virtual qint64 read(char *data, qint64 max) = 0;
+    QString error;
+};
+
+class FileSource : public ByteSource
+{
+public:
+    explicit FileSource(const QString &path) : m_file(path) {}
+    bool open()
+    {
+        if (!m_file.open(QIODevice::ReadOnly)) {
+            error = QString("cannot open %1").arg(m_file.fileName());
+            return false;
+        }
+        return true;
+    }
+    QByteArray peek(qint64 max) { return m_file.peek(max); }
+    qint64 read(char *data, qint64 max) override
+    {
+        qint64 n = m_file.read(data, max);
+        if (n < 0) error = QString("read error %1").arg(m_file.fileName());
+        return n;
+    }
+
+private:
+    QFile m_file;
+};
+
+#ifdef PPP_WITH_ZLIB
+// gzip (.gz)，支持多个成员首尾相接的文件
+class GzipSource : public ByteSource
+{
+public:
+    explicit GzipSource(std::unique_ptr<ByteSource> in) : m_in(std::move(in)), m_buf(BLOCK_BYTES, 0), m_eof(false),
+        m_member(false), m_members(0)
+    {
+        memset(&m_zs, 0, sizeof(m_zs));
+        m_ok = inflateInit2(&m_zs, 15 + 16) == Z_OK;
+    }
+    ~GzipSource() override
+    {
+        if (m_ok) inflateEnd(&m_zs);
+    }
+    qint64 read(char *data, qint64 max) override
+    {
+        if (!m_ok) {
+            error = "gzip init error";
+            return -1;
+        }
+        m_zs.next_out = reinterpret_cast<Bytef *>(data);
+        m_zs.avail_out = uInt(max);
+        while (m_zs.avail_out == uInt(max)) {
+            if (m_zs.avail_in == 0 && !m_eof) {
+                qint64 n = m_in->read(m_buf.data(), m_buf.size());
+                if (n < 0) {
+                    error = m_in->error;
+                    return -1;
+                }
+                m_eof = n == 0;
+                m_zs.next_in = reinterpret_cast<Bytef *>(m_buf.data());
+                m_zs.avail_in = uInt(n);
+            }
+            if (m_zs.avail_in == 0 && m_eof) {
+                if (m_member) {
+                    error = "gzip unexpected end of file";
+                    return -1;
+                }
+                break;
+            }
+            int ret = inflate(&m_zs, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                // 下一个成员
+                inflateReset(&m_zs);
+                m_member = false;
+                m_members++;
+            } else if (ret == Z_OK || ret == Z_BUF_ERROR) {
+                m_member = true;
+            } else if (!m_member && m_members > 0) {
+                // 文件末尾的填充字节，与gzip一样忽略
+                m_zs.avail_in = 0;
+                m_eof = true;
+            } else {
+                error = QString("gzip data error (%1)").arg(m_zs.msg ? m_zs.msg : "");
+                return -1;
+            }
+        }
+        return max - m_zs.avail_out;
+    }
+
+private:
+    std::unique_ptr<ByteSource> m_in;
+    QByteArray m_buf;
+    z_stream m_zs;
+    bool m_ok;
+    bool m_eof;
+    bool m_member;  // 正在解压一个成员
+    int m_members;  // 已解压的成员数
+};
+#endif
+
+// compress (.Z)，LZW编码，与gzip的unlzw相同：码长变化或清表时跳到当前码长的码组（8个码）边界
+class LzwSource : public ByteSource
+{
+public:
+    explicit LzwSource(std::unique_ptr<ByteSource> in) : m_in(std::move(in)), m_pos(0), m_segment(0), m_eof(false),
+        m_header(false), m_end(false), m_prefix(1 << 16), m_suffix(1 << 16)
+    {
+        for (int i = 0; i < 256; i++) m_suffix[i] = quint8(i);
+    }
+    qint64 read(char *data, qint64 max) override
+    {
+        if (!m_header && !readHeader()) {
+            return -1;
+        }
+        qint64 n = 0;
+        while (n < max) {
+            if (!m_stack.empty()) {
+                data[n++] = char(m_stack.back());
+                m_stack.pop_back();
+                continue;
+            }
+            if (m_end || !decodeCode()) {
+                break;
+            }
+        }
+        return error.isEmpty() ? n : -1;
+    }
+
+private:
+    // 缓冲区中至少有bits位可读
+    bool fill(qint64 bits)
+    {
+        while (m_pos + bits > qint64(m_buf.size()) * 8 && !m_eof) {
+            if (m_pos >= 8 * BLOCK_BYTES) {
+                m_buf.remove(0, int(m_pos >> 3));
+                m_segment -= m_pos & ~qint64(7);
+                m_pos &= 7;
+            }
+            char block[BLOCK_BYTES];
+            qint64 n = m_in->read(block, BLOCK_BYTES);
+            if (n < 0) {
+                error = m_in->error;
+                return false;
+            }
+            m_eof = n == 0;
+            m_buf.append(block, int(n));
+        }
+        return m_pos + bits <= qint64(m_buf.size()) * 8;
+    }
+    bool readHeader()
+    {
+        m_header = true;
+        if (!fill(24) || quint8(m_buf[0]) != 0x1F || quint8(m_buf[1]) != 0x9D) {
+            error = error.isEmpty() ? QString("not a compress (.Z) file") : error;
+            return false;
+        }
+        m_maxbits = quint8(m_buf[2]) & 0x1F;
+        m_block = (quint8(m_buf[2]) & 0x80) != 0;
+        if (m_maxbits < 9 || m_maxbits > 16) {
+            error = QString("compress (.Z) %1 bits not supported").arg(m_maxbits);
+            return false;
+        }
+        m_pos = m_segment = 24;
+        m_bits = 9;
+        m_maxcode = (1 << m_bits) - 1;
+        m_free = m_block ? 257 : 256;
+        m_old = -1;
+        m_fin = 0;
+        return true;
+    }
+    // 跳到码组边界，码组长度为当前码长的字节数
+    void align()
+    {
+        qint64 group = qint64(m_bits) * 8, used = m_pos - m_segment;
+        m_pos = m_segment + (used + group - 1) / group * group;
+        m_segment = m_pos;
+    }
+    // 解码一个码，结果压入m_stack（逆序），结束返回false
+    bool decodeCode()
+    {
+        if (m_free > m_maxcode) {
+            align();
+            m_bits++;
+            m_maxcode = m_bits == m_maxbits ? (1 << m_maxbits) : (1 << m_bits) - 1;
+        }
+        if (!fill(m_bits)) {
+            m_end = true;
+            return false;
+        }
+        const quint8 *p = reinterpret_cast<const quint8 *>(m_buf.constData()) + (m_pos >> 3);
+        quint32 word = p[0] | (quint32(p[1]) << 8) | (m_pos + m_bits > ((m_pos >> 3) + 2) * 8 ? quint32(p[2]) << 16 : 0);
+        int code = int((word >> (m_pos & 7)) & ((1u << m_bits) - 1));
+        m_pos += m_bits;
+
+        if (m_old < 0) {
+            if (code >= 256) {
+                error = "compress (.Z) data error";
+                return false;
+            }
+            m_old = m_fin = code;
+            m_stack.push_back(quint8(code));
+            return true;
+        }
+        if (code == 256 && m_block) {
+            m_free = 256;
+            align();
+            m_bits = 9;
+            m_maxcode = (1 << m_bits) - 1;
+            return true;
+        }
+        int in = code;
+        if (code >= m_free) {
+            if (code > m_free) {
+                error = "compress (.Z) data error";
+                return false;
+            }
+            m_stack.push_back(quint8(m_fin));
+            code = m_old;
+        }
+        while (code >= 256) {
+            m_stack.push_back(m_suffix[code]);
+            code = m_prefix[code];
+        }
+        m_fin = m_suffix[code];
+        m_stack.push_back(quint8(m_fin));
+        if (m_free < (1 << m_maxbits)) {
+            m_prefix[m_free] = quint16(m_old);
+            m_suffix[m_free] = quint8(m_fin);
+            m_free++;
+        }
+        m_old = in;
+        return true;
+    }
+
+    std::unique_ptr<ByteSource> m_in;
+    QByteArray m_buf;
+    qint64 m_pos;      // 缓冲区中的位位置
+    qint64 m_segment;  // 当前码长开始的位位置
+    bool m_eof;
+    bool m_header;
+    bool m_end;
+    int m_maxbits;
+    bool m_block;
+    int m_bits;
+    int m_maxcode;
+    int m_free;
+    int m_old;
+    int m_fin;
+    std::vector<quint16> m_prefix;
+    std::vector<quint8> m_suffix;
+    std::vector<quint8> m_stack;
+};
+
+// Hatanaka压缩的观测文件（CRINEX 1.0/3.0）还原为RINEX 2/3，输出与crx2rnx相同
+// 历元行和LLI/SSI标志为相对上一历元的文本差分（' '不变，'&'为空格），观测值为k阶差分的整数（0.001单位）
+class CrxSource : public ByteSource
+{
+public:
+    explicit CrxSource(std::unique_ptr<ByteSource> in) : m_in(std::move(in)), m_bufPos(0), m_eof(false), m_outPos(0),
+        m_version(0), m_state(CRX_HEADER), m_ntype(0)
+    {
+        memset(m_types, 0, sizeof(m_types));
+        m_clock.order = -1;
+    }
+    qint64 read(char *data, qint64 max) override
+    {
+        while (m_outPos >= m_out.size()) {
+            m_out.clear();
+            m_outPos = 0;
+            QByteArray line;
+            if (!getLine(&line)) {
+                return error.isEmpty() ? 0 : -1;
+            }
+            if (!decodeLine(line)) {
+                return -1;
+            }
+        }
+        qint64 n = qMin(max, qint64(m_out.size() - m_outPos));
+        memcpy(data, m_out.constData() + m_outPos, size_t(n));
+        m_outPos += int(n);
+        return n;
+    }
+
+private:
+    enum State { CRX_HEADER, RNX_HEADER, BODY };
+
+    // 差分阶数不超过5
+    struct Arc {
+        int order;     // 当前阶数，-1为无数据
+        int arcOrder;  // 弧段的差分阶数
+        qint64 u[6];
+    };
+    struct Sat {
+        QVector<Arc> arcs;
+        QByteArray flags;
+    };
+
+    bool getLine(QByteArray *line)
+    {
+        for (;;) {
+            int end = m_buf.indexOf('\n', m_bufPos);
+            if (end >= 0 || (m_eof && m_bufPos < m_buf.size())) {
+                if (end < 0) end = m_buf.size();
+                *line = m_buf.mid(m_bufPos, end - m_bufPos);
+                if (line->endsWith('\r')) line->chop(1);
+                m_bufPos = end + 1;
+                return true;
+            }
+            if (m_eof) {
+                return false;
+            }
+            m_buf.remove(0, m_bufPos);
+            m_bufPos = 0;
+            char block[BLOCK_BYTES];
+            qint64 n = m_in->read(block, BLOCK_BYTES);
+            if (n < 0) {
+                error = m_in->error;
+                return false;
+            }
+            m_eof = n == 0;
+            m_buf.append(block, int(n));
+        }
+    }
+    bool nextLine(QByteArray *line)
+    {
+        if (getLine(line)) {
+            return true;
+        }
+        if (error.isEmpty()) error = "CRINEX unexpected end of file";
+        return false;
+    }
+    bool fail(const char *msg)
+    {
+        error = QString("CRINEX %1").arg(msg);
+        return false;
+    }
+
+    // 文本差分：' '不变，'&'为空格，其他字符替换
+    static void applyDiff(QByteArray *text, const QByteArray &diff)
+    {
+        if (text->size() < diff.size()) {
+            text->append(QByteArray(diff.size() - text->size(), ' '));
+        }
+        for (int i = 0; i < diff.size(); i++) {
+            if (diff[i] == '&') (*text)[i] = ' ';
+            else if (diff[i] != ' ') (*text)[i] = diff[i];
+        }
+    }
+    static void rtrim(QByteArray *text)
+    {
+        int n = text->size();
+        while (n > 0 && (*text)[n - 1] == ' ') n--;
+        text->truncate(n);
+    }
+    // 整数value/10^decimals格式化为width宽的定点数
+    static void appendFixed(QByteArray *out, qint64 value, int decimals, int width)
+    {
+        qint64 scale = 1;
+        for (int i = 0; i < decimals; i++) scale *= 10;
+        qint64 a = value < 0 ? -value : value;
+        char buff[64];
+        snprintf(buff, sizeof(buff), "%s%lld.%0*lld", value < 0 ? "-" : "", (long long)(a / scale), decimals,
+                 (long long)(a % scale));
+        int len = int(strlen(buff));
+        if (len < width) out->append(QByteArray(width - len, ' '));
+        out->append(buff, len);
+    }
+    // 差分数据"k&值"（新弧段）或k阶差分
+    bool decodeField(const QByteArray &field, Arc *arc)
+    {
+        int amp = field.indexOf('&');
+        bool ok = false;
+        if (amp >= 0) {
+            arc->arcOrder = field.left(amp).toInt(&ok);
+            arc->order = 0;
+            arc->u[0] = field.mid(amp + 1).toLongLong(&ok);
+            if (arc->arcOrder < 0 || arc->arcOrder > 5) ok = false;
+        } else {
+            qint64 value = field.toLongLong(&ok);
+            if (arc->order < 0) ok = false;
+            if (ok) {
+                if (arc->order < arc->arcOrder) arc->order++;
+                arc->u[arc->order] = value;
+                for (int k = arc->order; k > 0; k--) arc->u[k - 1] += arc->u[k];
+            }
+        }
+        return ok || fail("data error");
+    }
+
+    bool decodeLine(const QByteArray &line)
+    {
+        switch (m_state) {
+        case CRX_HEADER:
+            if (!line.mid(60).startsWith("CRINEX VERS")) {
+                return fail("header error");
+            }
+            m_version = line.left(9).trimmed().toDouble() >= 3.0 ? 3 : 1;
+            m_state = RNX_HEADER;
+            return nextLine(&m_epoch); // CRINEX PROG / DATE
+        case RNX_HEADER:
+            m_out.append(line).append('\n');
+            if (line.mid(60).startsWith("SYS / # / OBS TYPES") && !line.startsWith(' ')) {
+                m_types[quint8(line[0]) & 0x7F] = line.mid(3, 3).trimmed().toInt();
+            } else if (line.mid(60).startsWith("# / TYPES OF OBSERV") && !line.left(6).trimmed().isEmpty()) {
+                m_ntype = line.left(6).trimmed().toInt();
+            } else if (line.mid(60).startsWith("END OF HEADER")) {
+                m_epoch.clear();
+                m_state = BODY;
+            }
+            return true;
+        case BODY:
+            return decodeEpoch(line);
+        }
+        return true;
+    }
+
+    bool decodeEpoch(const QByteArray &line)
+    {
+        // 新历元行以'>'（CRINEX 3）或'&'（CRINEX 1）开始，否则为差分
+        if (m_version == 3 && line.startsWith('>')) {
+            m_epoch = line;
+        } else if (m_version == 1 && line.startsWith('&')) {
+            m_epoch = line;
+            m_epoch[0] = ' ';
+        } else {
+            applyDiff(&m_epoch, line);
+        }
+        int head = m_version == 3 ? 35 : 32, list = m_version == 3 ? 41 : 32;
+        char flag = m_epoch.size() > head - 4 ? m_epoch[head - 4] : ' ';
+        int nsat = m_epoch.mid(head - 3, 3).trimmed().toInt();
+
+        // 事件记录：之后nsat行为原样的文件头记录
+        if (flag >= '2' && flag <= '5') {
+            QByteArray epoch = m_epoch.left(head);
+            rtrim(&epoch);
+            m_out.append(epoch).append('\n');
+            for (int i = 0; i < nsat; i++) {
+                QByteArray text;
+                if (!nextLine(&text)) return false;
+                m_out.append(text).append('\n');
+            }
+            return true;
+        }
+
+        // 接收机钟差，空行为无钟差
+        QByteArray text;
+        if (!nextLine(&text)) return false;
+        if (text.isEmpty()) m_clock.order = -1;
+        else if (!decodeField(text, &m_clock)) return false;
+
+        QByteArray epoch = m_epoch.left(head);
+        epoch.append(QByteArray(head - epoch.size(), ' '));
+        if (m_version == 3) {
+            if (m_clock.order >= 0) {
+                epoch.append(QByteArray(list - head, ' '));
+                appendFixed(&epoch, m_clock.u[0], 12, 15);
+            }
+            rtrim(&epoch);
+            m_out.append(epoch).append('\n');
+        } else {
+            // RINEX 2：每行12颗卫星，钟差在第一行第69列
+            for (int i = 0; i < nsat || i == 0; i += 12) {
+                QByteArray row = i == 0 ? epoch : QByteArray(32, ' ');
+                row.append(m_epoch.mid(list + 3 * i, 3 * qMin(12, nsat - i)));
+                if (i == 0 && m_clock.order >= 0) {
+                    row.append(QByteArray(qMax(0, 68 - row.size()), ' '));
+                    appendFixed(&row, m_clock.u[0], 9, 12);
+                }
+                rtrim(&row);
+                m_out.append(row).append('\n');
+            }
+        }
+
+        // 各卫星的观测值，状态按卫星号对应上一历元
+        QHash<QByteArray, Sat> sats;
+        for (int i = 0; i < nsat; i++) {
+            QByteArray id = m_epoch.mid(list + 3 * i, 3);
+            id.append(QByteArray(3 - id.size(), ' '));
+            int ntype = m_version == 3 ? m_types[quint8(id[0]) & 0x7F] : m_ntype;
+            Sat sat = m_sats.take(id);
+            if (sat.arcs.size() != ntype) {
+                sat.arcs = QVector<Arc>(ntype);
+                for (Arc &arc : sat.arcs) arc.order = -1;
+                sat.flags = QByteArray(2 * ntype, ' ');
+            }
+            if (!nextLine(&text)) return false;
+            int pos = 0;
+            for (int j = 0; j < ntype; j++) {
+                int sp = pos > text.size() ? -1 : text.indexOf(' ', pos);
+                QByteArray field = pos > text.size() ? QByteArray() : text.mid(pos, (sp < 0 ? text.size() : sp) - pos);
+                pos = sp < 0 ? text.size() + 1 : sp + 1;
+                if (field.isEmpty()) sat.arcs[j].order = -1;
+                else if (!decodeField(field, &sat.arcs[j])) return false;
+            }
+            if (pos <= text.size()) {
+                applyDiff(&sat.flags, text.mid(pos));
+            }
+            sat.flags.truncate(2 * ntype);
+            QByteArray row = m_version == 3 ? id : QByteArray();
+            for (int j = 0; j < ntype; j++) {
+                if (sat.arcs[j].order < 0) {
+                    sat.flags[2 * j] = sat.flags[2 * j + 1] = ' ';
+                    row.append(QByteArray(16, ' '));
+                } else {
+                    appendFixed(&row, sat.arcs[j].u[0], 3, 14);
+                    row.append(sat.flags.mid(2 * j, 2));
+                }
+                // RINEX 2：每行5个观测值
+                if (m_version == 1 && (j % 5 == 4 || j == ntype - 1)) {
+                    rtrim(&row);
+                    m_out.append(row).append('\n');
+                    row.clear();
+                }
+            }
+            if (m_version == 3) {
+                rtrim(&row);
+                m_out.append(row).append('\n');
+            }
+            sats.insert(id, sat);
+        }
+        m_sats.swap(sats);
+        return true;
+    }
+
+    std::unique_ptr<ByteSource> m_in;
+    QByteArray m_buf;
+    int m_bufPos;
+    bool m_eof;
+    QByteArray m_out;
+    int m_outPos;
+    int m_version;                // 1: CRINEX 1 (RINEX 2)，3: CRINEX 3
+    State m_state;
+    int m_types[128];             // RINEX 3各系统的观测值类型数
+    int m_ntype;                  // RINEX 2的观测值类型数
+    QByteArray m_epoch;           // 上一历元行
+    Arc m_clock;
+    QHash<QByteArray, Sat> m_sats;
+};
+
+// 外层压缩（.gz/.Z）的扩展名
+static const QRegularExpression &outerSuffix()
+{
+    static const QRegularExpression re("\\.(gz|z)$", QRegularExpression::CaseInsensitiveOption);
+    return re;
+}
+
+// Hatanaka压缩的观测文件的扩展名（去掉外层压缩后）
+static const QRegularExpression &crxSuffix()
+{
+    static const QRegularExpression re("(\\.crx|\\.\\d\\dd)$", QRegularExpression::CaseInsensitiveOption);
+    return re;
+}
+
+static std::unique_ptr<ByteSource> openSource(const QString &path, QString *error)
+{
+    std::unique_ptr<FileSource> file(new FileSource(path));
+    if (!file->open()) {
+        *error = file->error;
+        return nullptr;
+    }
+    QByteArray magic = file->peek(2);
+    std::unique_ptr<ByteSource> source(file.release());
+    if (magic == QByteArray("\x1F\x9D", 2)) {
+        source.reset(new LzwSource(std::move(source)));
+    } else if (magic == QByteArray("\x1F\x8B", 2)) {
+#ifdef PPP_WITH_ZLIB
+        source.reset(new GzipSource(std::move(source)));
+#else
+        *error = QString("gzip not supported (built without zlib) %1").arg(path);
+        return nullptr;
+#endif
+    }
+    QString name = QFileInfo(path).fileName();
+    name.remove(outerSuffix());
+    if (crxSuffix().match(name).hasMatch()) {
+        source.reset(new CrxSource(std::move(source)));
+    }
+    return source;
+}
+
+// 为一个压缩文件提供解压数据的管道
+// 每次有读取方打开管道时从头解压一遍，读取方提前关闭时停止本次解压。
+// Windows为命名管道，每个连接是一个独立的管道实例；其他系统为FIFO，
+// 每次连接后立即用新的FIFO替换路径，后续的打开不会读到上一次连接中未读取的数据。
+class PPPDecompressPipe
+{
+public:
+    PPPDecompressPipe(const QString &source, const QByteArray &path)
+        : m_source(source), m_path(path), m_thread(nullptr), m_stop(false)
+    {
+    }
+    ~PPPDecompressPipe() { stop(); }
+
+    bool start(QString *error);
+    void stop();
+    QString error() const;
+
+private:
+    void serve();
+    void session(const std::function<bool(const char *, qint64)> &sink);
+
+    QString m_source;
+    QByteArray m_path;
+    QThread *m_thread;
+    std::atomic<bool> m_stop;
+    mutable QMutex m_mutex;
+    QString m_error;  // 解压出错的信息（读取方提前关闭不是错误）
+#ifdef WIN32
+    HANDLE create() const;
+    HANDLE m_next;
+#else
+    bool replace() const;
+#endif
+};
+
+QString PPPDecompressPipe::error() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_error;
+}
+
+void PPPDecompressPipe::session(const std::function<bool(const char *, qint64)> &sink)
+{
+    QString message;
+    if (!PPPDecompressor::decompress(m_source, sink, &message) && !message.isEmpty()) {
+        QMutexLocker lock(&m_mutex);
+        m_error = message;
+    }
+}
+
+#ifdef WIN32
+HANDLE PPPDecompressPipe::create() const
+{
+    return CreateNamedPipeA(m_path.constData(), PIPE_ACCESS_OUTBOUND, PIPE_TYPE_BYTE | PIPE_WAIT,
+                            PIPE_UNLIMITED_INSTANCES, DWORD(BLOCK_BYTES), 0, 0, NULL);
+}
+
+bool PPPDecompressPipe::start(QString *error)
+{
+    // 第一个实例在返回前创建，之后RTKLIB即可打开
+    if ((m_next = create()) == INVALID_HANDLE_VALUE) {
+        *error = QString("cannot create pipe %1").arg(m_path.constData());
+        return false;
+    }
+    m_thread = QThread::create([this]() { serve(); });
+    m_thread->start();
+    return true;
+}
+
+void PPPDecompressPipe::serve()
+{
+    while (m_next != INVALID_HANDLE_VALUE) {
+        HANDLE pipe = m_next;
+        m_next = INVALID_HANDLE_VALUE;
+        bool connected = ConnectNamedPipe(pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED;
+        if (connected && !m_stop) {
+            // 先创建下一个实例，本次解压期间的打开连接到新实例
+            m_next = create();
+            session([pipe](const char *data, qint64 size) {
+                DWORD written = 0;
+                return WriteFile(pipe, data, DWORD(size), &written, NULL) && written == DWORD(size);
+            });
+            FlushFileBuffers(pipe);
+        }
+        DisconnectNamedPipe(pipe);
+        CloseHandle(pipe);
+    }
+}
+
+void PPPDecompressPipe::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    // 连接一次，使等待连接的实例返回
+    m_stop = true;
+    HANDLE client = CreateFileA(m_path.constData(), GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    m_thread->wait();
+    if (client != INVALID_HANDLE_VALUE) CloseHandle(client);
+    delete m_thread;
+    m_thread = nullptr;
+}
+#else
+bool PPPDecompressPipe::replace() const
+{
+    QByteArray next = m_path + ".next";
+    unlink(next.constData());
+    return !mkfifo(next.constData(), 0600) && !rename(next.constData(), m_path.constData());
+}
+
+bool PPPDecompressPipe::start(QString *error)
+{
+    if (!replace()) {
+        *error = QString("cannot create fifo %1 (%2)").arg(m_path.constData(), strerror(errno));
+        return false;
+    }
+    m_thread = QThread::create([this]() { serve(); });
+    m_thread->start();
+    return true;
+}
+
+void PPPDecompressPipe::serve()
+{
+    // 读取方提前关闭时write返回EPIPE，不产生SIGPIPE信号
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    for (;;) {
+        int fd = open(m_path.constData(), O_WRONLY);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (m_stop) {
+            close(fd);
+            break;
+        }
+        replace();
+        session([fd](const char *data, qint64 size) {
+            while (size > 0) {
+                ssize_t n = write(fd, data, size_t(size));
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                data += n;
+                size -= n;
+            }
+            return true;
+        });
+        close(fd);
+    }
+}
+
+void PPPDecompressPipe::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    // 以读方式打开一次，使等待读取方的open返回
+    m_stop = true;
+    int fd = open(m_path.constData(), O_RDONLY | O_NONBLOCK);
+    m_thread->wait();
+    if (fd >= 0) close(fd);
+    unlink(m_path.constData());
+    delete m_thread;
+    m_thread = nullptr;
+}
+#endif
+
+PPPDecompressor::PPPDecompressor()
+{
+}
+
+PPPDecompressor::~PPPDecompressor()
+{
+    m_pipes.clear();
+    QMutexLocker lock(&s_sourceMutex);
+    for (const QByteArray &pipe : m_paths) s_sources.remove(pipe);
+}
+
+bool PPPDecompressor::isCompressed(const QString &path)
+{
+    QString name = QFileInfo(path).fileName();
+#ifndef PPP_WITH_ZLIB
+    // 没有zlib时.gz文件仍由RTKLIB调用外部程序解压
+    if (name.endsWith(".gz", Qt::CaseInsensitive)) {
+        return false;
+    }
+#endif
+    return outerSuffix().match(name).hasMatch() || crxSuffix().match(name).hasMatch();
+}
+
+QString PPPDecompressor::decompressedName(const QString &path)
+{
+    QString name = QFileInfo(path).fileName();
+    name.remove(outerSuffix());
+    QRegularExpressionMatch match = crxSuffix().match(name);
+    if (match.hasMatch()) {
+        QString ext = match.captured(1);
+        bool upper = ext.at(ext.size() - 1).isUpper();
+        name.chop(ext.size());
+        name += ext.compare(".crx", Qt::CaseInsensitive) == 0 ? (upper ? ".RNX" : ".rnx")
+                                                               : ext.left(3) + (upper ? "O" : "o");
+    }
+    return name;
+}
+
+bool PPPDecompressor::decompress(const QString &path, const std::function<bool(const char *, qint64)> &sink,
+                                 QString *error)
+{
+    QString message;
+    std::unique_ptr<ByteSource> source = openSource(path, &message);
+    std::vector<char> block(BLOCK_BYTES);
+    qint64 n = -1;
+    while (source && (n = source->read(block.data(), BLOCK_BYTES)) > 0) {
+        if (!sink(block.data(), n)) {
+            return false;
+        }
+    }
+    if (source && n < 0) {
+        message = QString("%1 : %2").arg(source->error, path);
+    }
+    if (error) {
+        *error = message;
+    }
+    return message.isEmpty();
+}
+
+bool PPPDecompressor::prepare(ppp_paths_t *paths, filopt_t *filopt, QString *error)
+{
+    return replace(paths->obs_file, sizeof(paths->obs_file), error) &&
+           replace(paths->nav_file, sizeof(paths->nav_file), error) &&
+           replace(paths->sp3_file, sizeof(paths->sp3_file), error) &&
+           replace(paths->clk_file, sizeof(paths->clk_file), error) &&
+           replace(filopt->rcvantp, sizeof(filopt->rcvantp), error) &&
+           replace(filopt->satantp, sizeof(filopt->satantp), error) &&
+           replace(filopt->dcb, sizeof(filopt->dcb), error) &&
+           replace(filopt->eop, sizeof(filopt->eop), error);
+}
+
+QString PPPDecompressor::sourceFile(const char *path)
+{
+    QMutexLocker lock(&s_sourceMutex);
+    return s_sources.value(QByteArray(path));
+}
+
+const QStringList &PPPDecompressor::files() const
+{
+    return m_files;
+}
+
+QStringList PPPDecompressor::errors() const
+{
+    QStringList errors;
+    for (const std::unique_ptr<PPPDecompressPipe> &pipe : m_pipes) {
+        QString error = pipe->error();
+        if (!error.isEmpty()) errors.append(error);
+    }
+    return errors;
+}
+
+bool PPPDecompressor::replace(char *path, size_t size, QString *error)
+{
+    // 通配符和时间关键字路径由RTKLIB展开，仍按原方式处理
+    QString source = QString::fromLocal8Bit(path);
+    if (source.isEmpty() || source.contains('*') || source.contains('%') || !isCompressed(source) ||
+        !QFileInfo(source).isFile()) {
+        return true;
+    }
+    // 管道名保留解压后的文件名：RTKLIB按扩展名识别文件类型，测站名缺省时取文件名的前4个字符
+    QString name = decompressedName(source);
+    static QAtomicInt counter;
+    int id = counter.fetchAndAddRelaxed(1);
+#ifdef WIN32
+    QFileInfo info(name);
+    QByteArray pipe = QString("\\\\.\\pipe\\%1-%2-%3.%4").arg(info.completeBaseName())
+                          .arg(QCoreApplication::applicationPid()).arg(id).arg(info.suffix()).toLocal8Bit();
+#else
+    if (!m_dir) {
+        m_dir.reset(new QTemporaryDir);
+        if (!m_dir->isValid()) {
+            *error = QString("cannot create fifo directory %1").arg(m_dir->path());
+            return false;
+        }
+    }
+    QString dir = m_dir->filePath(QString::number(id));
+    QDir().mkpath(dir);
+    QByteArray pipe = QFile::encodeName(QDir(dir).filePath(name));
+#endif
+    if (size_t(pipe.size()) >= size) {
+        *error = QString("pipe path too long %1").arg(pipe.constData());
+        return false;
+    }
+    std::unique_ptr<PPPDecompressPipe> server(new PPPDecompressPipe(source, pipe));
+    if (!server->start(error)) {
+        return false;
+    }
+    m_pipes.push_back(std::move(server));
+    m_files.append(source);
+    m_paths.append(pipe);
+    {
+        QMutexLocker lock(&s_sourceMutex);
+        s_sources.insert(pipe, source);
+    }
+    strcpy(path, pipe.constData());
+    return true;
+}
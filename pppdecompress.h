@@ -0,0 +1,60 @@
+#ifndef PPPDECOMPRESS_H
+#define PPPDECOMPRESS_H
+
+#include "pppprocessor.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class PPPDecompressPipe;
+class QTemporaryDir;
+
+// 压缩输入文件的进程内解压
+// IGS数据中心提供的gzip (.gz)、compress (.Z) 文件和Hatanaka压缩的观测文件（.crx/.yyd，可再经gzip或compress压缩）
+// 由进程内的解码器边读边解压，通过命名管道（Windows）或FIFO（其他系统）提供给RTKLIB的读取函数，
+// 不调用外部程序，也不写出解压后的临时文件。RTKLIB可能多次打开同一输入文件，每次打开都从头解压。
+// 对象析构时关闭管道，须在RTKLIB读取完输入文件之后。
+class PPPDecompressor
+{
+public:
+    PPPDecompressor();
+    ~PPPDecompressor();
+
+    // 是否为可在进程内解压的文件（按扩展名判断）
+    static bool isCompressed(const QString &path);
+
+    // 解压后的文件名：去掉.gz/.Z，.crx改为.rnx，.yyd改为.yyo（与RTKLIB的rtk_uncompress相同）
+    static QString decompressedName(const QString &path);
+
+    // 解压整个文件，解压后的数据分块交给sink，sink返回false时停止
+    static bool decompress(const QString &path, const std::function<bool(const char *, qint64)> &sink,
+                           QString *error);
+
+    // 把任务和文件选项中的压缩文件替换为管道路径
+    bool prepare(ppp_paths_t *paths, filopt_t *filopt, QString *error);
+
+    // 管道路径对应的原压缩文件，不是本进程的管道时为空
+    static QString sourceFile(const char *path);
+
+    // 已替换的文件（原路径）
+    const QStringList &files() const;
+
+    // 解压出错的文件和原因（文件损坏时RTKLIB读到的数据不完整），在读取输入文件之后检查
+    QStringList errors() const;
+
+private:
+    bool replace(char *path, size_t size, QString *error);
+
+    std::unique_ptr<QTemporaryDir> m_dir;  // FIFO所在目录（Windows使用命名管道，不需要）
+    std::vector<std::unique_ptr<PPPDecompressPipe>> m_pipes;
+    QStringList m_files;
+    QList<QByteArray> m_paths;  // 管道路径
+
+    Q_DISABLE_COPY(PPPDecompressor)
+};
+
+#endif // PPPDECOMPRESS_H
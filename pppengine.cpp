@@ -0,0 +1,1298 @@
+#include "pppengine.h"
+#include "pppobscache.h"
+#include "pppobsreader.h"
+#include "pppobsstream.h"
+#include "pppresidualstore.h"
+#include "pppsolutionfile.h"
+#include "pppsolutionstore.h"
+#include "pppstationdb.h"
+#include "ppptracer.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include <memory>
+
+// 检查点文件标识
+static const char CHECKPOINT_MAGIC[8] = { 'P', 'P', 'P', 'C', 'K', 'P', 'T', '3' };
+
+// 写检查点的耗时占处理时间的比例上限，以及两次检查点之间默认的最短间隔 (s)
+static const double CHECKPOINT_MAX_OVERHEAD = 0.01;
+static const double CHECKPOINT_MIN_INTERVAL = 30.0;
+
+// 收敛判据：位置三维标准差 (m)
+static const double CONVERGENCE_SIGMA = 0.10;
+
+// 热启动坐标标准差的下限 (m)，容许测站日间的微小变化
+static const double WARM_START_POS_FLOOR = 0.01;
+
+// 数据库坐标与观测文件头概略坐标的最大差异 (m)，超过则认为测站已搬迁或重名，冷启动
+static const double WARM_START_MAX_OFFSET = 100.0;
+
+// 外推后的ZTD方差超过RTKLIB的初始方差 (0.6^2) 时不使用数据库中的ZTD
+static const double WARM_START_MAX_ZTD_VAR = 0.36;
+
+// 对流层梯度的初始值和方差，与RTKLIB ppp.c一致
+static const double GRADIENT_INIT = 1E-6;
+static const double GRADIENT_VAR = 1E-4;
+
+// 检查点序列化
+template <typename T>
+static void put(QByteArray *buff, const T &value)
+{
+    buff->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+class CheckpointReader
+{
+public:
+    explicit CheckpointReader(const QByteArray &data) : m_data(data), m_pos(0) {}
+
+    template <typename T>
+    bool get(T *value)
+    {
+        if (m_pos + int(sizeof(T)) > m_data.size()) return false;
+        memcpy(value, m_data.constData() + m_pos, sizeof(T));
+        m_pos += sizeof(T);
+        return true;
+    }
+
+    bool atEnd() const { return m_pos == m_data.size(); }
+
+private:
+    const QByteArray &m_data;
+    int m_pos;
+};
+
+// 状态向量和协方差只保存有效状态（未使用的状态及其协方差行列均为0）
+static void putSparse(QByteArray *buff, const double *x, const double *P, int n)
+{
+    QVector<int> active;
+    for (int i = 0; i < n; i++) {
+        bool used = x[i] != 0.0;
+        for (int j = 0; j < n && !used; j++) {
+            used = P[i + j * n] != 0.0 || P[j + i * n] != 0.0;
+        }
+        if (used) active.append(i);
+    }
+    put(buff, qint32(active.size()));
+    for (int i : active) put(buff, qint32(i));
+    for (int i : active) put(buff, x[i]);
+    for (int j : active) {
+        for (int i : active) put(buff, P[i + j * n]);
+    }
+}
+
+static bool getSparse(CheckpointReader *reader, double *x, double *P, int n)
+{
+    qint32 count;
+    if (!reader->get(&count) || count < 0 || count > n) return false;
+    QVector<int> active(count);
+    for (int k = 0; k < count; k++) {
+        qint32 i;
+        if (!reader->get(&i) || i < 0 || i >= n) return false;
+        active[k] = i;
+    }
+    memset(x, 0, sizeof(double) * n);
+    memset(P, 0, sizeof(double) * n * n);
+    for (int i : active) {
+        if (!reader->get(x + i)) return false;
+    }
+    for (int j : active) {
+        for (int i : active) {
+            if (!reader->get(P + i + j * n)) return false;
+        }
+    }
+    return true;
+}
+
+// 卫星状态只保存非初始值的卫星
+template <typename T>
+static void putSatellites(QByteArray *buff, const T *data)
+{
+    static const T zero = {};
+    qint32 count = 0;
+    for (int i = 0; i < MAXSAT; i++) {
+        if (memcmp(data + i, &zero, sizeof(T))) count++;
+    }
+    put(buff, count);
+    for (int i = 0; i < MAXSAT; i++) {
+        if (memcmp(data + i, &zero, sizeof(T))) {
+            put(buff, qint32(i));
+            put(buff, data[i]);
+        }
+    }
+}
+
+template <typename T>
+static bool getSatellites(CheckpointReader *reader, T *data)
+{
+    qint32 count, index;
+    if (!reader->get(&count) || count < 0 || count > MAXSAT) return false;
+    for (int k = 0; k < count; k++) {
+        if (!reader->get(&index) || index < 0 || index >= MAXSAT || !reader->get(data + index)) return false;
+    }
+    return true;
+}
+
+PPPInputs::PPPInputs()
+    : m_nav(new nav_t()), m_spanFromObs(false), m_firstTime({ 0 }), m_lastTime({ 0 }), m_bytes(0),
+      m_loadSeconds(0.0), m_obsCacheHit(false), m_stream(false), m_streamTs({ 0 }), m_streamTe({ 0 }),
+      m_streamTi(0.0)
+{
+    m_popt = prcopt_default;
+    memset(&m_obs, 0, sizeof(obs_t));
+    memset(m_sta, 0, sizeof(m_sta));
+    memset(&m_pcvs, 0, sizeof(pcvs_t));
+    memset(&m_pcvr, 0, sizeof(pcvs_t));
+}
+
+PPPInputs::~PPPInputs()
+{
+    clear();
+    delete m_nav;
+}
+
+void PPPInputs::setObsCache(const QString &dir)
+{
+    m_obsCacheDir = dir;
+}
+
+bool PPPInputs::obsCacheHit() const
+{
+    return m_obsCacheHit;
+}
+
+void PPPInputs::setStreaming(bool stream)
+{
+    m_stream = stream;
+}
+
+bool PPPInputs::streaming() const
+{
+    return !m_streamFile.isEmpty();
+}
+
+const QString &PPPInputs::error() const
+{
+    return m_error;
+}
+
+const QStringList &PPPInputs::messages() const
+{
+    return m_messages;
+}
+
+qint64 PPPInputs::bytes() const
+{
+    return m_bytes;
+}
+
+qint64 PPPInputs::productBytes() const
+{
+    return m_products ? m_products->bytes() : 0;
+}
+
+double PPPInputs::loadSeconds() const
+{
+    return m_loadSeconds;
+}
+
+bool PPPInputs::fail(const QString &message)
+{
+    m_error = message;
+    m_messages.append(message);
+    clear();
+    return false;
+}
+
+bool PPPInputs::load(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt, const filopt_t *fopt, char **infile, int n)
+{
+    QElapsedTimer timer;
+    timer.start();
+    char path[1024];
+
+    clear();
+    m_popt = *popt;
+    m_error.clear();
+    m_messages.clear();
+    m_bytes = 0;
+    m_obsCacheHit = false;
+    for (int i = 0; i < n; i++) {
+        m_files.append(QByteArray(infile[i]));
+        m_bytes += QFileInfo(QString::fromLocal8Bit(infile[i])).size();
+    }
+    for (const char *file : { fopt->satantp, fopt->rcvantp, fopt->eop, fopt->dcb }) {
+        if (*file) m_bytes += QFileInfo(QString::fromLocal8Bit(file)).size();
+    }
+
+    // 天线参数（postpos的openses），读取观测文件头后由ANTEX索引选出需要的条目
+    PPPProductCache &cache = PPPProductCache::instance();
+    QStringList hits;
+    QString reason;
+    bool hit = false;
+    for (int rcv = 0; rcv < 2; rcv++) {
+        const char *file = rcv ? fopt->rcvantp : fopt->satantp;
+        std::shared_ptr<const PPPAntexIndex> &index = rcv ? m_rcvAntex : m_satAntex;
+        if (!*file) continue;
+        if (!(index = cache.antennas(file, &reason, &hit))) {
+            return fail(QString("error : no %1 ant pcv in %2").arg(rcv ? "rec" : "sat").arg(file));
+        }
+        if (hit) {
+            hits.append(file);
+        } else if (!rcv || m_rcvAntex != m_satAntex) {
+            m_messages.append(QString("antex index : %1 entries, %2 ms%3").arg(index->count())
+                                  .arg(index->openMs(), 0, 'f', 1).arg(index->rebuilt() ? " (rebuilt)" : ""));
+        }
+    }
+
+    // 输入文件按文件头分类：精密星历和钟差只从其余文件读取（postpos对所有输入文件调用readsp3/readrnxc），
+    // 只有一个导航文件且没有无法识别的文件时，其星历由缓存共享（共享的数组不能再追加星历）
+    QVector<char> types(n);
+    QList<QByteArray> productFiles;
+    int navFile = -1, navCount = 0;
+    for (int i = 0; i < n; i++) {
+        types[i] = PPPProductCache::fileType(infile[i]);
+        if (types[i] == 'N') {
+            navFile = i;
+            navCount++;
+        } else if (types[i] != 'O') {
+            productFiles.append(QByteArray(infile[i]));
+            if (!types[i]) navCount++;
+        }
+    }
+    if (!productFiles.isEmpty()) {
+        m_products = cache.products(productFiles, &hit);
+        if (hit) hits.append(QString::fromLocal8Bit(productFiles.join(' ')));
+    }
+
+    // 地球自转参数，数据量小，复制到本任务的nav中
+    if (*fopt->eop) {
+        reppath(fopt->eop, path, ts, "", "");
+        std::shared_ptr<const PPPErpTable> erp = cache.erp(path, &hit);
+        if (!erp) {
+            m_messages.append(QString("error : no erp data %1").arg(path));
+        } else if (erp->erp.n > 0) {
+            if (hit) hits.append(path);
+            m_nav->erp.data = static_cast<erpd_t *>(malloc(sizeof(erpd_t) * erp->erp.n));
+            if (!m_nav->erp.data) {
+                return fail("error : insufficient memory");
+            }
+            memcpy(m_nav->erp.data, erp->erp.data, sizeof(erpd_t) * erp->erp.n);
+            m_nav->erp.n = m_nav->erp.nmax = erp->erp.n;
+        }
+    }
+
+    // 观测数据和广播星历，流式处理时第一个RINEX 3观测文件只读取文件头和历元时间
+    for (int i = 0; i < n; i++) {
+        if (types[i] == 'P' || types[i] == 'C') {
+            continue;
+        }
+        std::shared_ptr<const PPPNavigation> navigation;
+        if (i == navFile && navCount == 1 && (navigation = cache.navigation(infile[i], m_popt.rnxopt[0], &hit))) {
+            if (hit) hits.append(infile[i]);
+            shareNavigation(navigation);
+        } else if (m_stream && m_streamFile.isEmpty() && PPPObsStream::isStreamable(infile[i])) {
+            if (!openStream(infile[i], ts, te, ti)) {
+                return fail("error : no obs data");
+            }
+        } else if (!readObs(infile[i], ts, te, ti)) {
+            return fail("error : insufficient memory");
+        }
+    }
+    if (!m_streamFile.isEmpty() && m_obs.n > 0) {
+        return fail("error : stream mode supports only one obs file");
+    }
+    if (m_stream && m_streamFile.isEmpty()) {
+        m_messages.append("obs stream : no uncompressed RINEX 3 obs file, obs data loaded into memory");
+    }
+    if (m_obs.n <= 0 && m_streamFile.isEmpty()) {
+        return fail("error : no obs data");
+    }
+    if (m_nav->n <= 0 && m_nav->ng <= 0 && m_nav->ns <= 0) {
+        return fail("error : no nav data");
+    }
+    if (m_obs.n > 0) {
+        sortobs(&m_obs);
+        m_firstTime = m_obs.data[0].time;
+        m_lastTime = m_obs.data[m_obs.n - 1].time;
+    }
+    if (!m_sharedNav) {
+        uniqnav(m_nav);
+    }
+    m_spanFromObs = ts.time == 0 || te.time == 0;
+
+    // DCB
+    if (*fopt->dcb) {
+        reppath(fopt->dcb, path, ts, "", "");
+        readdcb(path, m_nav, m_sta);
+    }
+    if (!setAntennas(m_firstTime)) {
+        return fail("error : insufficient memory");
+    }
+
+    // 精密星历和钟差已转为只含产品中卫星的紧凑存储
+    if (m_products && !m_products->isEmpty()) {
+        m_messages.append(QString("precise products : %1 sats, %2 eph / %3 clk epochs, %4 MB -> %5 MB")
+                              .arg(m_products->satCount()).arg(m_products->ephCount()).arg(m_products->clkCount())
+                              .arg(m_products->sourceBytes() / 1048576.0, 0, 'f', 1)
+                              .arg(m_products->bytes() / 1048576.0, 0, 'f', 1));
+    }
+    for (const QString &file : hits) {
+        m_messages.append(QString("product cache hit : %1").arg(file));
+    }
+
+    m_loadSeconds = timer.elapsed() / 1000.0;
+    return true;
+}
+
+bool PPPInputs::readObs(char *file, gtime_t ts, gtime_t te, double ti)
+{
+    // 只缓存第一个观测文件：缓存的是读取该文件后的全部观测数据
+    PPPObsCache cache(m_obsCacheDir);
+    bool cached = !m_obsCacheDir.isEmpty() && m_obs.n == 0 && cache.setSource(file, ts, te, ti, m_popt.rnxopt[0]);
+    QString reason;
+    if (cached && cache.load(&m_obs, m_sta, m_nav->glo_fcn, &reason)) {
+        m_obsCacheHit = true;
+        m_messages.append(QString("obs cache hit : %1").arg(cache.path()));
+        return true;
+    }
+    if (!reason.isEmpty()) {
+        m_messages.append(QString("obs cache invalid (%1), parsing %2").arg(reason, file));
+    }
+
+    // RINEX 3观测文件按历元分段多线程解码
+    int neph = m_nav->n + m_nav->ng + m_nav->ns;
+    PPPObsReader reader;
+    if (reader.read(file, 1, ts, te, ti, m_popt.rnxopt[0], &m_obs, m_nav, m_sta) < 0) {
+        return false;
+    }
+    if (reader.chunkCount() > 0) {
+        m_messages.append(QString("obs read : %1 chunks in parallel").arg(reader.chunkCount()));
+    }
+    // 含星历的文件（如混合RINEX）不缓存，缓存中只有观测数据
+    if (cached && m_obs.n > 0 && m_nav->n + m_nav->ng + m_nav->ns == neph) {
+        QString error;
+        if (!cache.store(&m_obs, m_sta, m_nav->glo_fcn, &error)) {
+            m_messages.append(error);
+        }
+    }
+    return true;
+}
+
+bool PPPInputs::openStream(char *file, gtime_t ts, gtime_t te, double ti)
+{
+    // 只读取文件头（测站信息和GLONASS频率号）和各历元的时间，观测数据由引擎按历元读取
+    PPPObsStream stream;
+    if (!stream.open(file, ts, te, ti, m_popt.rnxopt[0], m_sta, m_nav->glo_fcn) ||
+        !stream.scanSpan(&m_firstTime, &m_lastTime)) {
+        return false;
+    }
+    m_streamFile = QByteArray(file);
+    m_streamTs = ts;
+    m_streamTe = te;
+    m_streamTi = ti;
+    m_messages.append(QString("obs stream : %1").arg(file));
+    return true;
+}
+
+bool PPPInputs::setAntennas(gtime_t time)
+{
+    pcv_t *pcv, pcv0 = {};
+
+    // 卫星天线
+    if (m_satAntex && !m_satAntex->selectSatellites(m_popt.navsys, time, &m_pcvs)) {
+        return false;
+    }
+    for (int i = 0; i < MAXSAT; i++) {
+        if (!(satsys(i + 1, nullptr) & m_popt.navsys)) continue;
+        if ((pcv = searchpcv(i + 1, "", time, &m_pcvs))) m_nav->pcvs[i] = *pcv;
+    }
+
+    // 流动站接收机天线，"*"表示使用观测文件头中的天线
+    m_popt.pcvr[0] = pcv0;
+    if (!strcmp(m_popt.anttype[0], "*")) {
+        strcpy(m_popt.anttype[0], m_sta[0].antdes);
+        if (m_sta[0].deltype == 1) {
+            if (norm(m_sta[0].pos, 3) > 0.0) {
+                double pos[3], del[3];
+                ecef2pos(m_sta[0].pos, pos);
+                ecef2enu(pos, m_sta[0].del, del);
+                for (int j = 0; j < 3; j++) m_popt.antdel[0][j] = del[j];
+            }
+        } else {
+            for (int j = 0; j < 3; j++) m_popt.antdel[0][j] = m_sta[0].del[j];
+        }
+    }
+    if (m_rcvAntex && !m_rcvAntex->selectReceiver(m_popt.anttype[0], &m_pcvr)) {
+        return false;
+    }
+    if (!(pcv = searchpcv(0, m_popt.anttype[0], time, &m_pcvr))) {
+        *m_popt.anttype[0] = '\0';
+        return true;
+    }
+    strcpy(m_popt.anttype[0], pcv->type);
+    m_popt.pcvr[0] = *pcv;
+    return true;
+}
+
+void PPPInputs::shareNavigation(const std::shared_ptr<const PPPNavigation> &navigation)
+{
+    // 星历数组只读共享，文件头的电离层和UTC参数及GLONASS频率号复制到本任务的nav
+    const nav_t *src = navigation->nav;
+    m_sharedNav = navigation;
+    m_nav->eph = src->eph;
+    m_nav->n = m_nav->nmax = src->n;
+    m_nav->geph = src->geph;
+    m_nav->ng = m_nav->ngmax = src->ng;
+    m_nav->seph = src->seph;
+    m_nav->ns = m_nav->nsmax = src->ns;
+    memcpy(m_nav->utc_gps, src->utc_gps, sizeof(src->utc_gps));
+    memcpy(m_nav->utc_glo, src->utc_glo, sizeof(src->utc_glo));
+    memcpy(m_nav->utc_gal, src->utc_gal, sizeof(src->utc_gal));
+    memcpy(m_nav->utc_qzs, src->utc_qzs, sizeof(src->utc_qzs));
+    memcpy(m_nav->utc_cmp, src->utc_cmp, sizeof(src->utc_cmp));
+    memcpy(m_nav->utc_irn, src->utc_irn, sizeof(src->utc_irn));
+    memcpy(m_nav->utc_sbs, src->utc_sbs, sizeof(src->utc_sbs));
+    memcpy(m_nav->ion_gps, src->ion_gps, sizeof(src->ion_gps));
+    memcpy(m_nav->ion_gal, src->ion_gal, sizeof(src->ion_gal));
+    memcpy(m_nav->ion_qzs, src->ion_qzs, sizeof(src->ion_qzs));
+    memcpy(m_nav->ion_cmp, src->ion_cmp, sizeof(src->ion_cmp));
+    memcpy(m_nav->ion_irn, src->ion_irn, sizeof(src->ion_irn));
+    for (int i = 0; i < int(sizeof(m_nav->glo_fcn) / sizeof(int)); i++) {
+        if (!m_nav->glo_fcn[i]) m_nav->glo_fcn[i] = src->glo_fcn[i];
+    }
+}
+
+void PPPInputs::clear()
+{
+    freeobs(&m_obs);
+    if (m_sharedNav) {
+        m_nav->eph = nullptr;
+        m_nav->geph = nullptr;
+        m_nav->seph = nullptr;
+        m_sharedNav.reset();
+    }
+    freenav(m_nav, 0xFF);
+    free(m_pcvs.pcv);
+    free(m_pcvr.pcv);
+    memset(&m_obs, 0, sizeof(obs_t));
+    memset(m_nav, 0, sizeof(nav_t));
+    memset(m_sta, 0, sizeof(m_sta));
+    memset(&m_pcvs, 0, sizeof(pcvs_t));
+    memset(&m_pcvr, 0, sizeof(pcvs_t));
+    m_satAntex.reset();
+    m_rcvAntex.reset();
+    m_products.reset();
+    m_files.clear();
+    m_streamFile.clear();
+    m_firstTime = m_lastTime = gtime_t{ 0, 0.0 };
+}
+
+PPPEngine::PPPEngine()
+    : m_in(nullptr), m_cancel(nullptr), m_solutions(nullptr), m_residuals(nullptr), m_tracer(nullptr), m_binary(false), m_indexed(true), m_backward(false), m_epochs(0), m_checkpointInterval(CHECKPOINT_MIN_INTERVAL), m_checkpointCost(0.0), m_checkpointTotal(0.0),
+      m_checkpointCount(0), m_resumed(false), m_warmStarted(false), m_startTime({ 0 }), m_convergence(-1.0),
+      m_coldConvergence(-1.0), m_stopSigma(0.0), m_stopChange(0.0), m_stopWindow(0.0), m_stableStart({ 0 }),
+      m_stableRef(), m_stoppedEarly(false), m_skipped(0.0), m_finalSigma(-1.0), m_spreadRef(), m_spreadSum(),
+      m_spreadSumSq(), m_spreadCount(0)
+{
+    m_nav = new nav_t();
+    m_popt = m_options = prcopt_default;
+    m_hasOptions = false;
+    m_streaming = false;
+    m_sopt = solopt_default;
+    memset(&m_rtk, 0, sizeof(rtk_t));
+}
+
+PPPEngine::~PPPEngine()
+{
+    // 数组属于输入或展开窗口，不调用freenav
+    delete m_nav;
+}
+
+void PPPEngine::setCheckpoint(const QString &path, const QByteArray &jobId)
+{
+    m_checkpointPath = path;
+    m_jobId = jobId;
+}
+
+void PPPEngine::setCheckpointInterval(double seconds)
+{
+    m_checkpointInterval = seconds;
+}
+
+void PPPEngine::setCancelFlag(const std::atomic<bool> *cancel)
+{
+    m_cancel = cancel;
+}
+
+void PPPEngine::setSolutionStore(PPPSolutionStore *store)
+{
+    m_solutions = store;
+}
+
+void PPPEngine::setResidualStore(PPPResidualStore *store)
+{
+    m_residuals = store;
+}
+
+void PPPEngine::setTracer(PPPTracer *tracer)
+{
+    m_tracer = tracer;
+}
+
+void PPPEngine::setBinaryOutput(bool binary, bool indexed)
+{
+    m_binary = binary;
+    m_indexed = indexed;
+}
+
+void PPPEngine::setObsCache(const QString &dir)
+{
+    m_obsCacheDir = dir;
+}
+
+void PPPEngine::setStreaming(bool stream)
+{
+    m_streaming = stream;
+}
+
+void PPPEngine::setStationDatabase(const QString &path)
+{
+    m_stationDb = path;
+}
+
+void PPPEngine::setOptions(const prcopt_t *popt)
+{
+    m_options = *popt;
+    m_hasOptions = true;
+}
+
+void PPPEngine::setEarlyStop(double sigma, double change, double window)
+{
+    m_stopSigma = sigma;
+    m_stopChange = change;
+    m_stopWindow = window;
+}
+
+bool PPPEngine::resumed() const
+{
+    return m_resumed;
+}
+
+int PPPEngine::epochCount() const
+{
+    return m_epochs;
+}
+
+int PPPEngine::checkpointCount() const
+{
+    return m_checkpointCount;
+}
+
+double PPPEngine::checkpointSeconds() const
+{
+    return m_checkpointTotal;
+}
+
+const QString &PPPEngine::stationName() const
+{
+    return m_station;
+}
+
+bool PPPEngine::warmStarted() const
+{
+    return m_warmStarted;
+}
+
+double PPPEngine::convergenceSeconds() const
+{
+    return m_convergence;
+}
+
+double PPPEngine::coldConvergenceSeconds() const
+{
+    return m_coldConvergence;
+}
+
+bool PPPEngine::stoppedEarly() const
+{
+    return m_stoppedEarly;
+}
+
+double PPPEngine::skippedSeconds() const
+{
+    return m_skipped;
+}
+
+double PPPEngine::finalSigma() const
+{
+    return m_finalSigma;
+}
+
+double PPPEngine::repeatability() const
+{
+    if (m_spreadCount < 2) {
+        return -1.0;
+    }
+    double var = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double mean = m_spreadSum[i] / m_spreadCount;
+        var += qMax(0.0, m_spreadSumSq[i] / m_spreadCount - mean * mean);
+    }
+    return sqrt(var);
+}
+
+int PPPEngine::run(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt, const solopt_t *sopt,
+                   const filopt_t *fopt, char **infile, int n, const char *outfile)
+{
+    std::unique_ptr<PPPInputs> inputs(new PPPInputs);
+    inputs->setObsCache(m_obsCacheDir);
+    inputs->setStreaming(m_streaming);
+    bool loaded = inputs->load(ts, te, ti, popt, fopt, infile, n);
+    for (const QString &message : inputs->messages()) {
+        showmsg("%s", message.toLocal8Bit().constData());
+    }
+    if (!loaded) {
+        return -1;
+    }
+    return process(inputs.get(), sopt, outfile);
+}
+
+int PPPEngine::process(PPPInputs *inputs, const solopt_t *sopt, const char *outfile)
+{
+    m_in = inputs;
+    m_popt = inputs->m_popt;
+    if (m_hasOptions) {
+        // 接收机天线由读取时的观测文件头确定
+        prcopt_t popt = m_options;
+        memcpy(popt.anttype, m_popt.anttype, sizeof(popt.anttype));
+        memcpy(popt.antdel, m_popt.antdel, sizeof(popt.antdel));
+        memcpy(popt.pcvr, m_popt.pcvr, sizeof(popt.pcvr));
+        m_popt = popt;
+    }
+    m_sopt = *sopt;
+    if (!outfile) {
+        m_sopt.sstat = 0;
+    }
+    m_backward = m_popt.soltype == 1; // 后向滤波，取值与postpos相同
+    if (m_backward && m_in->streaming()) {
+        showmsg("error : backward solution of streamed obs data");
+        m_in = nullptr;
+        return -1;
+    }
+    m_resumed = false;
+    m_epochs = 0;
+    m_checkpointCost = m_checkpointTotal = 0.0;
+    m_checkpointCount = 0;
+    *m_nav = *m_in->m_nav;
+    m_window.reset();
+    if (m_in->m_spanFromObs) {
+        settspan(m_in->m_firstTime, m_in->m_lastTime);
+    }
+    rtkinit(&m_rtk, &m_popt);
+
+    m_station = PPPStationDb::stationName(m_in->m_sta[0]);
+    m_startTime = m_backward ? m_in->m_lastTime : m_in->m_firstTime;
+    m_stoppedEarly = false;
+    m_skipped = 0.0;
+
+    // 写检查点时状态文件先写到.part文件，每个检查点关闭后追加到状态文件并记录状态文件的长度
+    m_statFile = m_statPart = QString();
+    if (outfile && m_sopt.sstat > 0 && !m_backward && !m_checkpointPath.isEmpty()) {
+        m_statFile = QString::fromLocal8Bit(outfile) + ".stat";
+        m_statPart = m_statFile + ".part";
+    }
+
+    // 从检查点恢复
+    qint64 offset = 0, statOffset = 0;
+    int index = 0;
+    m_resumed = outfile && !m_backward && !m_checkpointPath.isEmpty() && readCheckpoint(&offset, &statOffset, &index) &&
+                QFileInfo(QString::fromLocal8Bit(outfile)).size() >= offset &&
+                (m_statFile.isEmpty() || QFileInfo(m_statFile).size() >= statOffset);
+    if (m_resumed && m_in->streaming()) {
+        m_resumed = openStream(index);
+    }
+    if (!m_resumed) {
+        // 收敛和提前结束的统计，从检查点恢复时由检查点给出
+        rtkfree(&m_rtk);
+        rtkinit(&m_rtk, &m_popt);
+        index = m_backward ? m_in->m_obs.n - 1 : 0;
+        m_warmStarted = false;
+        m_convergence = m_coldConvergence = -1.0;
+        m_stableStart = gtime_t{ 0, 0.0 };
+        m_finalSigma = -1.0;
+        m_spreadCount = 0;
+    }
+    if (m_in->streaming() && !m_resumed && !openStream(0)) {
+        showmsg("error : open obs file %s", m_in->m_streamFile.constData());
+        rtkfree(&m_rtk);
+        m_in = nullptr;
+        return -1;
+    }
+
+    // 热启动，从检查点恢复时滤波器状态已包含收敛后的坐标
+    if (!m_resumed && !m_backward && !m_stationDb.isEmpty()) {
+        warmStart();
+    }
+
+    if (m_resumed) {
+        // 丢弃检查点之后的输出：结果文件和状态文件截断到检查点记录的长度，中断时未追加的.part文件丢弃
+        QFile::resize(QString::fromLocal8Bit(outfile), offset);
+        if (!m_statFile.isEmpty()) {
+            QFile::remove(m_statPart);
+            QFile::resize(m_statFile, statOffset);
+            rtkopenstat(m_statPart.toLocal8Bit().constData(), m_sopt.sstat);
+        }
+    } else if (outfile) {
+        if (!writeHeader(outfile)) {
+            rtkfree(&m_rtk);
+            m_in = nullptr;
+            return -1;
+        }
+        if (!m_statFile.isEmpty()) {
+            QFile::remove(m_statPart);
+            QFile(m_statFile).open(QIODevice::WriteOnly); // 清空上次处理的状态文件
+            rtkopenstat(m_statPart.toLocal8Bit().constData(), m_sopt.sstat);
+        } else if (m_sopt.sstat > 0) {
+            rtkopenstat((QString::fromLocal8Bit(outfile) + ".stat").toLocal8Bit().constData(), m_sopt.sstat);
+        }
+    }
+
+    int ret = -1;
+    if (!outfile) {
+        ret = processEpochs(nullptr, index);
+    } else if (FILE *fp = fopen(outfile, m_binary ? "ab" : "a")) {
+        m_checkpointTimer.start();
+        ret = processEpochs(fp, index);
+        fclose(fp);
+    } else {
+        showmsg("error : open output file %s", outfile);
+    }
+    if (m_sopt.sstat > 0) {
+        rtkclosestat();
+        if (!m_statFile.isEmpty()) appendFile(m_statFile, m_statPart);
+    }
+    if (ret == 0) {
+        if (outfile) removeCheckpoint();
+        if (outfile && m_binary && m_indexed && !PPPSolutionFile::writeIndex(outfile)) {
+            showmsg("error : write solution index %s", outfile);
+        }
+        if (!m_backward && !m_stationDb.isEmpty()) updateStation();
+    }
+    m_stream.reset();
+    rtkfree(&m_rtk);
+    m_in = nullptr;
+    return ret;
+}
+
+bool PPPEngine::writeHeader(const char *outfile) const
+{
+    createdir(outfile);
+    if (m_binary) {
+        FILE *fp = fopen(outfile, "wb");
+        bool ok = fp && PPPSolutionFile::writeHeader(fp);
+        if (fp) fclose(fp);
+        if (!ok) showmsg("error : open output file %s", outfile);
+        return ok;
+    }
+    FILE *fp = fopen(outfile, "w");
+    if (!fp) {
+        showmsg("error : open output file %s", outfile);
+        return false;
+    }
+    outputHeader(fp, m_in->m_files, m_in->m_firstTime, m_in->m_lastTime, &m_popt, &m_sopt);
+    fclose(fp);
+    return true;
+}
+
+void PPPEngine::outputHeader(FILE *fp, const QList<QByteArray> &files, gtime_t ts, gtime_t te, const prcopt_t *popt,
+                             const solopt_t *sopt)
+{
+    // 与postpos的outheader相同，处理选项由RTKLIB的outprcopt输出
+    static const char *const timesys[] = { "GPST", "UTC", "JST" };
+    if (sopt->posf == SOLF_NMEA || sopt->posf == SOLF_STAT) {
+        return;
+    }
+    if (sopt->outhead) {
+        if (!*sopt->prog) {
+            fprintf(fp, "%s program   : RTKLIB ver.%s %s\n", COMMENTH, VER_RTKLIB, PATCH_LEVEL);
+        } else {
+            fprintf(fp, "%s program   : %s\n", COMMENTH, sopt->prog);
+        }
+        for (const QByteArray &file : files) {
+            fprintf(fp, "%s inp file  : %s\n", COMMENTH, file.constData());
+        }
+        if (ts.time == 0) {
+            fprintf(fp, "\n%s no rover obs data\n", COMMENTH);
+            return;
+        }
+        int w1, w2;
+        double t1 = time2gpst(ts, &w1), t2 = time2gpst(te, &w2);
+        if (sopt->times >= 1) {
+            ts = gpst2utc(ts);
+            te = gpst2utc(te);
+        }
+        if (sopt->times == 2) {
+            ts = timeadd(ts, 9 * 3600.0);
+            te = timeadd(te, 9 * 3600.0);
+        }
+        char s1[64], s2[64];
+        time2str(ts, s1, 1);
+        time2str(te, s2, 1);
+        fprintf(fp, "%s obs start : %s %s (week%04d %8.1fs)\n", COMMENTH, s1, timesys[sopt->times], w1, t1);
+        fprintf(fp, "%s obs end   : %s %s (week%04d %8.1fs)\n", COMMENTH, s2, timesys[sopt->times], w2, t2);
+    }
+    if (sopt->outopt) {
+        outprcopt(fp, popt);
+    }
+    if (sopt->outhead || sopt->outopt) {
+        fprintf(fp, "%s\n", COMMENTH);
+    }
+    outsolhead(fp, sopt);
+}
+
+int PPPEngine::nextEpoch(int *index) const
+{
+    // 与postpos的nextobsf一致：同一历元（时间差在DTTOL内）的流动站观测
+    for (; *index < m_in->m_obs.n; (*index)++) {
+        if (m_in->m_obs.data[*index].rcv == 1) break;
+    }
+    int n = 0;
+    for (; *index + n < m_in->m_obs.n; n++) {
+        const obsd_t &obs = m_in->m_obs.data[*index + n];
+        if (obs.rcv != 1 || timediff(obs.time, m_in->m_obs.data[*index].time) > DTTOL) break;
+    }
+    return n;
+}
+
+int PPPEngine::prevEpoch(int *index) const
+{
+    // 与postpos的nextobsb一致：从*index向前同一历元的流动站观测
+    for (; *index >= 0; (*index)--) {
+        if (m_in->m_obs.data[*index].rcv == 1) break;
+    }
+    int n = 0;
+    for (; *index - n >= 0; n++) {
+        const obsd_t &obs = m_in->m_obs.data[*index - n];
+        if (obs.rcv != 1 || timediff(obs.time, m_in->m_obs.data[*index].time) < -DTTOL) break;
+    }
+    return n;
+}
+
+int PPPEngine::readEpoch(int *index, obsd_t *obs)
+{
+    if (m_stream) {
+        int n = m_stream->next(obs);
+        *index = m_stream->count();
+        return n;
+    }
+    if (m_backward) {
+        // 与postpos的inputobs相同，一个历元内的观测仍按原顺序
+        int nu = prevEpoch(index);
+        int n = 0;
+        for (int i = 0; i < nu && n < MAXOBS * 2; i++) {
+            obs[n++] = m_in->m_obs.data[*index - nu + 1 + i];
+        }
+        *index -= nu;
+        return n;
+    }
+    int nu = nextEpoch(index);
+    int n = 0;
+    for (int i = 0; i < nu && n < MAXOBS * 2; i++) {
+        obs[n++] = m_in->m_obs.data[*index + i];
+    }
+    *index += nu;
+    return n;
+}
+
+bool PPPEngine::openStream(int skip)
+{
+    // 从检查点恢复时跳过已处理的观测记录，记录数与读取全部观测数据时的序号一致
+    m_stream.reset(new PPPObsStream);
+    if (!m_stream->open(m_in->m_streamFile.constData(), m_in->m_streamTs, m_in->m_streamTe, m_in->m_streamTi,
+                        m_in->m_popt.rnxopt[0], nullptr, nullptr)) {
+        m_stream.reset();
+        return false;
+    }
+    std::unique_ptr<obsd_t[]> obs(new obsd_t[MAXOBS]);
+    while (m_stream->count() < skip && m_stream->next(obs.get()) > 0) {
+    }
+    return m_stream->count() == skip;
+}
+
+int PPPEngine::processEpochs(FILE *fp, int index)
+{
+    std::unique_ptr<obsd_t[]> obs(new obsd_t[MAXOBS * 2]);
+
+    while (true) {
+        int n = readEpoch(&index, obs.get());
+        if (n <= 0) {
+            break;
+        }
+
+        // 进度和中断检查，与postpos的inputobs一致
+        settime(obs[0].time);
+        char str[64]; // time_str的静态缓冲区不能在多个线程中同时使用
+        time2str(obs[0].time, str, 0);
+        if (showmsg("processing : %s Q=%d", str, m_rtk.sol.stat) || (m_cancel && *m_cancel)) {
+            showmsg("aborted");
+            return 1;
+        }
+
+        // 排除的卫星
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            if ((satsys(obs[i].sat, nullptr) & m_popt.navsys) && m_popt.exsats[obs[i].sat - 1] != 1) {
+                obs[m++] = obs[i];
+            }
+        }
+        bool stop = false;
+        if (m > 0) {
+            if (m_in->m_products) m_in->m_products->update(obs[0].time, &m_window, m_nav);
+        }
+        QElapsedTimer epochTimer;
+        if (m_tracer) epochTimer.start();
+        bool solved = m > 0 && rtkpos(&m_rtk, obs.get(), m, m_nav);
+        if (m_tracer && m > 0) {
+            m_tracer->epoch(obs[0].time, m_rtk.sol.stat, m_rtk.sol.ns, epochTimer.nsecsElapsed() / 1000.0);
+        }
+        if (solved) {
+            if (fp && m_binary) PPPSolutionFile::writeRecord(fp, m_rtk.sol);
+            else if (fp) outsol(fp, &m_rtk.sol, m_rtk.rb, &m_sopt);
+            if (m_solutions) m_solutions->append(m_rtk.sol);
+            if (m_residuals) m_residuals->append(m_rtk);
+
+            const sol_t &sol = m_rtk.sol;
+            if (sol.stat == SOLQ_PPP || sol.stat == SOLQ_FIX) {
+                m_finalSigma = sqrt(sol.qr[0] + sol.qr[1] + sol.qr[2]);
+                if (m_convergence < 0.0 && m_finalSigma < CONVERGENCE_SIGMA) {
+                    m_convergence = timediff(sol.time, m_startTime);
+                    for (int i = 0; i < 3; i++) m_spreadRef[i] = sol.rr[i];
+                }
+                if (m_convergence >= 0.0) {
+                    accumulateSpread(sol);
+                }
+            }
+            stop = checkEarlyStop(fp);
+        }
+        m_epochs++;
+        if (stop) {
+            break;
+        }
+
+        // 检查点间隔随写入耗时调整，使其占处理时间的比例不超过上限
+        if (fp && !m_backward && !m_checkpointPath.isEmpty() &&
+            m_checkpointTimer.elapsed() / 1000.0 >= qMax(m_checkpointInterval, m_checkpointCost / CHECKPOINT_MAX_OVERHEAD)) {
+            writeCheckpoint(fp, index);
+        }
+    }
+    return 0;
+}
+
+void PPPEngine::accumulateSpread(const sol_t &sol)
+{
+    if (m_spreadCount == 0) {
+        for (int i = 0; i < 3; i++) m_spreadSum[i] = m_spreadSumSq[i] = 0.0;
+    }
+    for (int i = 0; i < 3; i++) {
+        double d = sol.rr[i] - m_spreadRef[i];
+        m_spreadSum[i] += d;
+        m_spreadSumSq[i] += d * d;
+    }
+    m_spreadCount++;
+}
+
+bool PPPEngine::checkEarlyStop(FILE *fp)
+{
+    if (m_stopWindow <= 0.0 || m_popt.mode != PMODE_PPP_STATIC || m_backward) {
+        return false;
+    }
+    const sol_t &sol = m_rtk.sol;
+    double sigma = sqrt(sol.qr[0] + sol.qr[1] + sol.qr[2]);
+    if ((sol.stat != SOLQ_PPP && sol.stat != SOLQ_FIX) || sigma >= m_stopSigma) {
+        m_stableStart = gtime_t{ 0, 0.0 };
+        return false;
+    }
+    double d[3];
+    for (int i = 0; i < 3; i++) d[i] = sol.rr[i] - m_stableRef[i];
+    if (m_stableStart.time == 0 || norm(d, 3) >= m_stopChange) {
+        // 重新开始计时，坐标变化相对于窗口起点计算，避免缓慢漂移逐历元累积
+        m_stableStart = sol.time;
+        for (int i = 0; i < 3; i++) m_stableRef[i] = sol.rr[i];
+        return false;
+    }
+    if (timediff(sol.time, m_stableStart) < m_stopWindow) {
+        return false;
+    }
+
+    // 结束记录（文本和二进制格式都写出）：之前的最后一条解算结果即为最终坐标
+    m_stoppedEarly = true;
+    m_skipped = timediff(m_in->m_lastTime, sol.time);
+    PPPSolutionFile::Stop record = { sol.time, sigma, m_stopChange, m_stopWindow, m_skipped };
+    if (fp && m_binary) {
+        PPPSolutionFile::writeStop(fp, record);
+    } else if (fp) {
+        PPPSolutionFile::outputStop(fp, record);
+    }
+    char str[64];
+    time2str(sol.time, str, 1);
+    showmsg("early stop : %s sigma=%.4fm", str, sigma);
+    return true;
+}
+
+bool PPPEngine::writeCheckpoint(FILE *fp, int index)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    fflush(fp);
+    qint64 offset = ftell(fp);
+
+    // RTKLIB的状态文件只能由rtkclosestat刷新：关闭后追加到状态文件，记录长度后重新打开
+    qint64 statOffset = 0;
+    if (!m_statFile.isEmpty()) {
+        rtkclosestat();
+        bool appended = appendFile(m_statFile, m_statPart);
+        statOffset = QFileInfo(m_statFile).size();
+        rtkopenstat(m_statPart.toLocal8Bit().constData(), m_sopt.sstat);
+        if (!appended) {
+            return false; // 状态文件不完整，保留上一个检查点
+        }
+    }
+
+    QByteArray buff;
+    buff.append(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    put(&buff, quint32(sizeof(rtk_t)));
+    put(&buff, quint32(sizeof(ssat_t)));
+    put(&buff, quint32(sizeof(ambc_t)));
+    put(&buff, qint32(m_jobId.size()));
+    buff.append(m_jobId);
+    put(&buff, offset);
+    put(&buff, statOffset);
+    put(&buff, qint32(index));
+
+    // 滤波器状态
+    put(&buff, qint32(m_rtk.nx));
+    put(&buff, qint32(m_rtk.na));
+    put(&buff, m_rtk.tt);
+    put(&buff, qint32(m_rtk.nfix));
+    put(&buff, m_rtk.rb);
+    put(&buff, m_rtk.sol);
+    putSparse(&buff, m_rtk.x, m_rtk.P, m_rtk.nx);
+    putSparse(&buff, m_rtk.xa, m_rtk.Pa, m_rtk.na);
+    putSatellites(&buff, m_rtk.ssat);
+    putSatellites(&buff, m_rtk.ambc);
+
+    // 热启动、收敛时间、提前结束窗口和坐标离散度的统计，恢复后与不中断的处理相同
+    put(&buff, quint8(m_warmStarted));
+    put(&buff, m_coldConvergence);
+    put(&buff, m_convergence);
+    put(&buff, m_stableStart);
+    put(&buff, m_stableRef);
+    put(&buff, m_finalSigma);
+    put(&buff, m_spreadRef);
+    put(&buff, m_spreadSum);
+    put(&buff, m_spreadSumSq);
+    put(&buff, qint32(m_spreadCount));
+
+    // 先写临时文件再替换，写入中断不会破坏上一个检查点
+    QSaveFile file(m_checkpointPath);
+    bool ok = file.open(QIODevice::WriteOnly) && file.write(buff) == buff.size() && file.commit();
+
+    m_checkpointCost = timer.elapsed() / 1000.0;
+    m_checkpointTotal += m_checkpointCost;
+    m_checkpointCount++;
+    m_checkpointTimer.restart();
+    return ok;
+}
+
+bool PPPEngine::readCheckpoint(qint64 *offset, qint64 *statOffset, int *index)
+{
+    QFile file(m_checkpointPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    CheckpointReader reader(data);
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    quint32 rtkSize, ssatSize, ambcSize;
+    qint32 idSize;
+    if (!reader.get(&magic) || memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) ||
+        !reader.get(&rtkSize) || !reader.get(&ssatSize) || !reader.get(&ambcSize) ||
+        rtkSize != sizeof(rtk_t) || ssatSize != sizeof(ssat_t) || ambcSize != sizeof(ambc_t)) {
+        return false; // 不同版本的程序写出的检查点
+    }
+    if (!reader.get(&idSize) || idSize != m_jobId.size()) {
+        return false;
+    }
+    QByteArray jobId(idSize, '\0');
+    for (int i = 0; i < idSize; i++) {
+        if (!reader.get(jobId.data() + i)) return false;
+    }
+    if (jobId != m_jobId) {
+        return false; // 处理参数或输入文件已改变
+    }
+
+    qint32 next, nx, na, nfix;
+    if (!reader.get(offset) || !reader.get(statOffset) || !reader.get(&next) ||
+        !reader.get(&nx) || !reader.get(&na) || nx != m_rtk.nx || na != m_rtk.na ||
+        next < 0 || (!m_in->streaming() && next > m_in->m_obs.n)) {
+        return false;
+    }
+    if (!reader.get(&m_rtk.tt) || !reader.get(&nfix) || !reader.get(&m_rtk.rb) || !reader.get(&m_rtk.sol) ||
+        !getSparse(&reader, m_rtk.x, m_rtk.P, m_rtk.nx) || !getSparse(&reader, m_rtk.xa, m_rtk.Pa, m_rtk.na) ||
+        !getSatellites(&reader, m_rtk.ssat) || !getSatellites(&reader, m_rtk.ambc)) {
+        return false;
+    }
+
+    // 统计只在检查点完整时使用，否则保持process()中的初始值
+    quint8 warmStarted;
+    double coldConvergence, convergence, stableRef[3], finalSigma, spreadRef[3], spreadSum[3], spreadSumSq[3];
+    gtime_t stableStart;
+    qint32 spreadCount;
+    if (!reader.get(&warmStarted) || !reader.get(&coldConvergence) || !reader.get(&convergence) ||
+        !reader.get(&stableStart) || !reader.get(&stableRef) || !reader.get(&finalSigma) || !reader.get(&spreadRef) ||
+        !reader.get(&spreadSum) || !reader.get(&spreadSumSq) || !reader.get(&spreadCount) || spreadCount < 0 ||
+        !reader.atEnd()) {
+        return false;
+    }
+    m_warmStarted = warmStarted != 0;
+    m_coldConvergence = coldConvergence;
+    m_convergence = convergence;
+    m_stableStart = stableStart;
+    m_finalSigma = finalSigma;
+    m_spreadCount = spreadCount;
+    for (int i = 0; i < 3; i++) {
+        m_stableRef[i] = stableRef[i];
+        m_spreadRef[i] = spreadRef[i];
+        m_spreadSum[i] = spreadSum[i];
+        m_spreadSumSq[i] = spreadSumSq[i];
+    }
+    m_rtk.nfix = nfix;
+    *index = next;
+    return true;
+}
+
+void PPPEngine::removeCheckpoint()
+{
+    if (!m_checkpointPath.isEmpty()) {
+        QFile::remove(m_checkpointPath);
+    }
+}
+
+bool PPPEngine::appendFile(const QString &path, const QString &part)
+{
+    QFile in(part);
+    if (!in.exists()) {
+        return true;
+    }
+    QFile out(path);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::Append)) {
+        return false;
+    }
+    while (!in.atEnd()) {
+        out.write(in.read(1 << 20));
+    }
+    in.close();
+    out.close();
+    return QFile::remove(part);
+}
+
+int PPPEngine::tropIndex() const
+{
+    // 与RTKLIB ppp.c的状态向量排列一致：位置（动态为位置、速度、加速度）、各系统接收机钟差、对流层
+    if (m_popt.tropopt < TROPOPT_EST) {
+        return -1;
+    }
+    return (m_popt.dynamics ? 9 : 3) + NSYS;
+}
+
+void PPPEngine::warmStart()
+{
+    if (m_popt.mode != PMODE_PPP_STATIC || m_station.isEmpty()) {
+        return;
+    }
+    PPPStationRecord record;
+    QByteArray name = m_station.toLatin1();
+    if (!PPPStationDb::lookup(m_stationDb, m_station, &record)) {
+        showmsg("warm start : station %s not in database, cold start", name.constData());
+        return;
+    }
+    m_coldConvergence = record.coldConvergence;
+
+    const sta_t &sta = m_in->m_sta[0];
+    if (norm(sta.pos, 3) > 0.0) {
+        double d[3];
+        for (int i = 0; i < 3; i++) d[i] = record.pos[i] - sta.pos[i];
+        if (norm(d, 3) > WARM_START_MAX_OFFSET) {
+            showmsg("warm start : station %s moved %.1f m from database position, cold start", name.constData(),
+                    norm(d, 3));
+            return;
+        }
+    }
+
+    // 位置参数非零时RTKLIB不再用单点定位结果初始化，静态模式下保持数据库坐标及其方差
+    int nx = m_rtk.nx;
+    for (int i = 0; i < 3; i++) {
+        m_rtk.x[i] = record.pos[i];
+        m_rtk.P[i * (nx + 1)] = record.std[i] * record.std[i] + WARM_START_POS_FLOOR * WARM_START_POS_FLOOR;
+    }
+
+    // ZTD按RTKLIB的对流层过程噪声（随机游走）外推到本次开始时刻
+    int it = tropIndex();
+    if (it >= 0 && record.ztd > 0.0) {
+        double dt = fabs(timediff(m_startTime, record.time));
+        double var = record.ztdStd * record.ztdStd + m_popt.prn[2] * m_popt.prn[2] * dt;
+        if (var < WARM_START_MAX_ZTD_VAR) {
+            m_rtk.x[it] = record.ztd;
+            m_rtk.P[it * (nx + 1)] = var;
+            // ZTD非零时RTKLIB也不再初始化梯度
+            if (m_popt.tropopt >= TROPOPT_ESTG) {
+                for (int j = it + 1; j < it + 3; j++) {
+                    m_rtk.x[j] = GRADIENT_INIT;
+                    m_rtk.P[j * (nx + 1)] = GRADIENT_VAR;
+                }
+            }
+        }
+    }
+    m_warmStarted = true;
+}
+
+void PPPEngine::updateStation()
+{
+    if (m_popt.mode != PMODE_PPP_STATIC || m_station.isEmpty()) {
+        return;
+    }
+    int nx = m_rtk.nx;
+    double var = m_rtk.P[0] + m_rtk.P[nx + 1] + m_rtk.P[2 * (nx + 1)];
+    if (norm(m_rtk.x, 3) <= 0.0 || sqrt(var) >= CONVERGENCE_SIGMA) {
+        showmsg("warm start : solution not converged, station database not updated");
+        return;
+    }
+
+    PPPStationRecord record;
+    if (!PPPStationDb::lookup(m_stationDb, m_station, &record)) {
+        record.runs = 0;
+        record.coldConvergence = record.warmConvergence = -1.0;
+    }
+    record.name = m_station;
+    record.time = m_rtk.sol.time;
+    for (int i = 0; i < 3; i++) {
+        record.pos[i] = m_rtk.x[i];
+        record.std[i] = sqrt(m_rtk.P[i * (nx + 1)]);
+    }
+    int it = tropIndex();
+    record.ztd = it >= 0 ? m_rtk.x[it] : 0.0;
+    record.ztdStd = it >= 0 ? sqrt(m_rtk.P[it * (nx + 1)]) : 0.0;
+    record.runs++;
+    if (m_convergence >= 0.0) {
+        (m_warmStarted ? record.warmConvergence : record.coldConvergence) = m_convergence;
+    }
+
+    QString error;
+    if (!PPPStationDb::update(m_stationDb, record, &error)) {
+        showmsg("%s", error.toLocal8Bit().constData());
+    }
+}
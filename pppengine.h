@@ -0,0 +1,253 @@
+#ifndef PPPENGINE_H
+#define PPPENGINE_H
+
+#include "pppproductcache.h"
+#include "pppproducts.h"
+#include "rtklib.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+class PPPObsStream;
+class PPPResidualStore;
+class PPPSolutionStore;
+class PPPTracer;
+
+// 一个任务的输入数据：观测、星历、精密产品、地球自转参数、DCB和天线参数
+// 读取流程与postpos一致。读取只调用RTKLIB的文件读取函数，不涉及滤波的全局状态，
+// 因此可以在I/O线程中预先读取下一个任务，同时在另一线程中处理当前任务。
+// 精密星历和钟差读取后转为紧凑存储（PPPPreciseProducts），处理时由引擎展开当前历元附近的部分。
+// 精密产品、天线参数、ERP和单个导航文件的星历由PPPProductCache在同一进程的各任务间共享。
+class PPPInputs
+{
+public:
+    PPPInputs();
+    ~PPPInputs();
+
+    // 观测数据缓存目录（为空不缓存），第一个观测文件解码后的数据按内容缓存，再次读取时直接映射
+    void setObsCache(const QString &dir);
+
+    // 流式处理：RINEX 3观测文件只读取文件头和历元时间，处理时由引擎按历元读取
+    // 只支持一个未压缩的观测文件，其他观测文件仍全部读入内存
+    void setStreaming(bool stream);
+
+    bool load(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt, const filopt_t *fopt, char **infile, int n);
+    void clear();
+
+    // 读取过程中的错误和警告（读取可能在I/O线程中进行，不直接调用showmsg）
+    const QString &error() const;
+    const QStringList &messages() const;
+    qint64 bytes() const;          // 读取的文件总字节数
+    qint64 productBytes() const;   // 精密星历和钟差占用的内存 (byte)
+    double loadSeconds() const;    // 读取耗时 (s)
+    bool obsCacheHit() const;      // 观测数据是否由缓存读取
+    bool streaming() const;        // 观测数据是否在处理时按历元读取
+
+private:
+    friend class PPPEngine;
+
+    bool fail(const QString &message);
+    bool readObs(char *file, gtime_t ts, gtime_t te, double ti);
+    bool openStream(char *file, gtime_t ts, gtime_t te, double ti);
+    bool setAntennas(gtime_t time);
+    void shareNavigation(const std::shared_ptr<const PPPNavigation> &navigation);
+
+    prcopt_t m_popt;      // 处理选项（已设置天线参数）
+    obs_t m_obs;
+    nav_t *m_nav;         // 导航数据，不含精密星历和钟差
+    std::shared_ptr<const PPPPreciseProducts> m_products;  // 由产品缓存共享
+    std::shared_ptr<const PPPNavigation> m_sharedNav;     // m_nav的广播星历数组指向其中，不由本类释放
+    sta_t m_sta[MAXRCV];
+    std::shared_ptr<const PPPAntexIndex> m_satAntex;  // 卫星和接收机天线的ANTEX索引，由产品缓存共享
+    std::shared_ptr<const PPPAntexIndex> m_rcvAntex;
+    pcvs_t m_pcvs;        // 卫星天线参数（索引中选出的条目）
+    pcvs_t m_pcvr;        // 接收机天线参数（索引中选出的条目）
+    QList<QByteArray> m_files;
+    QString m_error;
+    QStringList m_messages;
+    bool m_spanFromObs;   // 未指定处理时间范围，由观测数据确定
+    gtime_t m_firstTime;  // 第一个和最后一个历元的时间
+    gtime_t m_lastTime;
+    qint64 m_bytes;
+    double m_loadSeconds;
+    QString m_obsCacheDir;
+    bool m_obsCacheHit;
+    bool m_stream;
+    QByteArray m_streamFile; // 按历元读取的观测文件，为空则观测数据在m_obs中
+    gtime_t m_streamTs;      // 按历元读取的时间范围和间隔
+    gtime_t m_streamTe;
+    double m_streamTi;
+
+    Q_DISABLE_COPY(PPPInputs)
+};
+
+// PPP单向滤波处理引擎
+// 与RTKLIB的postpos（前向或后向，单个流动站）处理流程一致：按历元调用rtkpos并输出结果，
+// 但滤波器状态由本类持有，因此可以周期性写检查点，中断后从最近的检查点恢复，
+// 恢复后的输出与不中断的处理结果相同。
+// 后向滤波（处理选项的soltype为1）只用于输出二进制结果，不支持检查点、流式处理、热启动和提前结束。
+// rtkpos的状态文件输出使用全局状态，同一进程内同一时刻只能有一个引擎在处理。
+class PPPEngine
+{
+public:
+    PPPEngine();
+    ~PPPEngine();
+
+    // 观测数据缓存目录和流式处理，用于run()读取输入
+    void setObsCache(const QString &dir);
+    void setStreaming(bool stream);
+
+    // 设置检查点文件，jobId用于识别检查点是否属于当前任务（为空则不写检查点）
+    void setCheckpoint(const QString &path, const QByteArray &jobId);
+
+    // 检查点的最短间隔 (s)，默认30；写入耗时仍限制在处理时间的1%以内（回归测试用0以尽快写出检查点）
+    void setCheckpointInterval(double seconds);
+
+    // 取消标志，除showmsg的返回值外每个历元也检查该标志
+    void setCancelFlag(const std::atomic<bool> *cancel);
+
+    // 测站数据库（为空则不使用）：静态PPP从数据库中的坐标和对流层延迟热启动，处理完成后更新数据库
+    void setStationDatabase(const QString &path);
+
+    // 使用不同于读取输入时的处理选项（如参数扫描），天线参数仍取自输入
+    void setOptions(const prcopt_t *popt);
+
+    // 静态PPP提前结束：位置三维标准差小于sigma且坐标变化小于change并保持window秒后结束处理
+    // window<=0则处理全部历元
+    void setEarlyStop(double sigma, double change, double window);
+
+    // 解算结果同时追加到store（为空则不保存），处理开始时不清空store
+    void setSolutionStore(PPPSolutionStore *store);
+
+    // 各卫星的残差和状态追加到store（为空则不保存），与状态文件的$SAT行相同，处理开始时不清空store
+    void setResidualStore(PPPResidualStore *store);
+
+    // 每个历元的时间、解算质量、卫星数和rtkpos耗时记录到跟踪器（为空则不记录）
+    void setTracer(PPPTracer *tracer);
+
+    // 结果文件使用二进制格式（PPPSolutionFile），indexed为true时处理完成后追加时间索引
+    // 不加索引的文件只有定长记录，处理过程中可以由其他进程逐条读取（组合解的单向处理）
+    void setBinaryOutput(bool binary, bool indexed = true);
+
+    // 读取输入并处理，参数与postpos相同
+    // 返回值: 0 成功, 1 被取消, -1 错误
+    int run(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt, const solopt_t *sopt,
+            const filopt_t *fopt, char **infile, int n, const char *outfile);
+
+    // 处理已读取的输入，outfile为空时不输出结果文件（仅统计或保存到setSolutionStore的store）
+    // 输入在处理过程中只读，多个引擎可在不同线程中同时处理同一输入（不输出状态文件时）
+    int process(PPPInputs *inputs, const solopt_t *sopt, const char *outfile);
+
+    // 本次处理是否从检查点恢复
+    bool resumed() const;
+
+    // 处理的历元数
+    int epochCount() const;
+
+    // 写检查点的次数和总耗时 (s)
+    int checkpointCount() const;
+    double checkpointSeconds() const;
+
+    // 热启动信息：测站名，是否由数据库热启动，
+    // 本次收敛时间和数据库中该测站冷启动的收敛时间 (s)，<0为未收敛或未知
+    const QString &stationName() const;
+    bool warmStarted() const;
+    double convergenceSeconds() const;
+    double coldConvergenceSeconds() const;
+
+    // 是否提前结束，以及未处理的观测时长 (s)
+    bool stoppedEarly() const;
+    double skippedSeconds() const;
+
+    // 最后一个PPP解的位置三维标准差 (m)，以及收敛后各历元坐标的三维离散度 (m)，<0为无
+    double finalSigma() const;
+    double repeatability() const;
+
+    // 写出与postpos相同的.pos文本头部：输入文件、观测起止时间（ts为0表示没有观测数据）、处理选项和列标题
+    static void outputHeader(FILE *fp, const QList<QByteArray> &files, gtime_t ts, gtime_t te, const prcopt_t *popt,
+                             const solopt_t *sopt);
+
+private:
+    bool writeHeader(const char *outfile) const;
+    int nextEpoch(int *index) const;
+    int prevEpoch(int *index) const;
+    int readEpoch(int *index, obsd_t *obs);
+    bool openStream(int skip);
+    int processEpochs(FILE *fp, int index);
+
+    // 检查点
+    bool writeCheckpoint(FILE *fp, int index);
+    bool readCheckpoint(qint64 *offset, qint64 *statOffset, int *index);
+    void removeCheckpoint();
+    static bool appendFile(const QString &path, const QString &part);
+
+    void accumulateSpread(const sol_t &sol);
+
+    // 提前结束判断，满足条件时写结束记录并返回true
+    bool checkEarlyStop(FILE *fp);
+
+    // 测站数据库
+    void warmStart();
+    void updateStation();
+    int tropIndex() const;
+
+    PPPInputs *m_in;
+    prcopt_t m_popt;                 // 本次处理的选项
+    prcopt_t m_options;              // setOptions设置的选项
+    bool m_hasOptions;
+    solopt_t m_sopt;
+    rtk_t m_rtk;
+    nav_t *m_nav;                    // 输入导航数据的副本，精密星历和钟差指向本引擎的展开窗口
+    PPPPreciseWindow m_window;
+    const std::atomic<bool> *m_cancel;
+    PPPSolutionStore *m_solutions;
+    PPPResidualStore *m_residuals;
+    PPPTracer *m_tracer;
+    bool m_binary;                   // 二进制结果文件
+    bool m_indexed;                  // 二进制结果文件追加时间索引
+    bool m_backward;                 // 后向滤波
+    int m_epochs;
+
+    QString m_checkpointPath;
+    QByteArray m_jobId;
+    QElapsedTimer m_checkpointTimer; // 距上次写检查点的时间
+    QString m_statFile;              // 写检查点时的状态文件，RTKLIB写出到m_statPart，每个检查点追加到状态文件
+    QString m_statPart;
+    double m_checkpointInterval;     // 检查点的最短间隔 (s)
+    double m_checkpointCost;         // 上次写检查点的耗时 (s)
+    double m_checkpointTotal;
+    int m_checkpointCount;
+    bool m_resumed;
+
+    QString m_obsCacheDir;
+    bool m_streaming;
+    std::unique_ptr<PPPObsStream> m_stream; // 流式处理时的观测文件
+    QString m_stationDb;
+    QString m_station;
+    bool m_warmStarted;
+    gtime_t m_startTime;             // 第一个历元的时间，用于计算收敛时间
+    double m_convergence;
+    double m_coldConvergence;
+
+    double m_stopSigma;
+    double m_stopChange;
+    double m_stopWindow;
+    gtime_t m_stableStart;           // 满足提前结束条件的起始时间，0为不满足
+    double m_stableRef[3];           // 起始时的坐标，之后的坐标变化相对于该坐标
+    bool m_stoppedEarly;
+    double m_skipped;
+
+    // 收敛后的坐标统计，相对于收敛时的坐标累加以避免ECEF大数相减的精度损失
+    double m_finalSigma;
+    double m_spreadRef[3];
+    double m_spreadSum[3];
+    double m_spreadSumSq[3];
+    int m_spreadCount;
+};
+
+#endif // PPPENGINE_H
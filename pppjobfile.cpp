@@ -0,0 +1,446 @@
+#include "pppjobfile.h"
+#include "pppproductcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QStringList>
+#include <cstdio>
+
+// 枚举选项与任务文件中的名称
+static const char *const MODE_NAMES[] = { "static", "kinematic" };
+static const char *const TROP_NAMES[] = { "off", "saas", "sbas", "est", "estg" };
+static const char *const IONO_NAMES[] = { "off", "brdc", "sbas", "iflc", "est", "tec" };
+static const char *const SOLTYPE_NAMES[] = { "forward", "backward", "combined" };
+static const char *const SOLFORMAT_NAMES[] = { "text", "binary", "records" };
+static const char *const TRACEFORMAT_NAMES[] = { "binary", "text" };
+
+// 参数扫描的最大组合数
+static const int MAX_SWEEP_VARIANTS = 1000;
+
+// 卫星系统代码与名称
+static const struct {
+    int sys;
+    const char *code;
+    const char *names[3];
+} NAVSYS_NAMES[] = {
+    { SYS_GPS, "G", { "GPS", nullptr, nullptr } },
+    { SYS_GLO, "R", { "GLO", "GLONASS", nullptr } },
+    { SYS_GAL, "E", { "GAL", "GALILEO", nullptr } },
+    { SYS_CMP, "C", { "BDS", "BEIDOU", "CMP" } },
+    { SYS_QZS, "J", { "QZS", "QZSS", nullptr } },
+    { SYS_IRN, "I", { "IRN", "IRNSS", nullptr } },
+    { SYS_SBS, "S", { "SBS", "SBAS", nullptr } },
+};
+
+template <size_t N>
+static int indexOfName(const char *const (&names)[N], const QString &value)
+{
+    for (size_t i = 0; i < N; i++) {
+        if (value.compare(QLatin1String(names[i]), Qt::CaseInsensitive) == 0) {
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+// 复制路径到定长缓冲区，统一为本地路径分隔符
+static bool copyPath(const QString &value, char *dst, size_t size, QString *error)
+{
+    QByteArray ba = QDir::toNativeSeparators(value).toLocal8Bit();
+    if (size_t(ba.size()) >= size) {
+        *error = QString("路径过长: %1").arg(value);
+        return false;
+    }
+    strcpy(dst, ba.constData());
+    return true;
+}
+
+bool PPPJobFile::readText(const QString &path, QByteArray *text, QString *error)
+{
+    if (path == "-") {
+        // 从标准输入读取任务，到文件结束或结束行为止，之后的输入留给调用者（批处理的取消请求）
+        // 与调用者使用同一个stdio缓冲区，不能用QFile读取
+        char line[4096];
+        text->clear();
+        while (fgets(line, sizeof(line), stdin)) {
+            if (QByteArray(line).trimmed() == END_LINE) {
+                return true;
+            }
+            text->append(line);
+        }
+        if (ferror(stdin)) {
+            *error = "无法读取标准输入";
+            return false;
+        }
+        return true;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QString("无法打开任务文件: %1").arg(path);
+        return false;
+    }
+    *text = file.readAll();
+    return true;
+}
+
+bool PPPJobFile::load(const QString &path, ppp_paths_t *paths, QString *error)
+{
+    QByteArray text;
+    if (!readText(path, &text, error)) {
+        return false;
+    }
+
+    // 任务文件默认处理全部历元且不生成RTKLIB日志
+    PPPProcessor::initPaths(paths);
+    paths->trace_level = 0;
+    return parse(text, paths, error);
+}
+
+bool PPPJobFile::loadBatch(const QString &path, QList<ppp_paths_t> *jobs, QString *error)
+{
+    QByteArray text;
+    if (!readText(path, &text, error)) {
+        return false;
+    }
+    const QList<QByteArray> lines = text.split('\n');
+
+    // 找出各 [job] 节的起始行
+    QList<int> sections;
+    for (int i = 0; i < lines.size(); i++) {
+        if (lines[i].trimmed().toLower() == "[job]") {
+            sections.append(i);
+        }
+    }
+    if (sections.isEmpty()) {
+        *error = "批处理任务文件中没有 [job] 节";
+        return false;
+    }
+
+    // 公共设置
+    ppp_paths_t defaults;
+    PPPProcessor::initPaths(&defaults);
+    defaults.trace_level = 0;
+    if (!parseLines(lines, 0, sections[0], &defaults, error)) {
+        return false;
+    }
+
+    jobs->clear();
+    for (int k = 0; k < sections.size(); k++) {
+        ppp_paths_t job = defaults;
+        int last = k + 1 < sections.size() ? sections[k + 1] : lines.size();
+        if (!parseLines(lines, sections[k] + 1, last, &job, error) || !validate(job, error)) {
+            *error = QString("第%1个任务: %2").arg(k + 1).arg(*error);
+            return false;
+        }
+        jobs->append(job);
+    }
+    return true;
+}
+
+bool PPPJobFile::loadSweep(const QString &path, const ppp_paths_t &base, QList<ppp_paths_t> *variants,
+                           QStringList *labels, QString *error)
+{
+    QByteArray text;
+    if (!readText(path, &text, error)) {
+        return false;
+    }
+
+    variants->clear();
+    labels->clear();
+    variants->append(base);
+    labels->append(QString());
+    const QList<QByteArray> lines = text.split('\n');
+    for (int i = 0; i < lines.size(); i++) {
+        QString line = QString::fromLocal8Bit(lines[i]).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        int eq = line.indexOf('=');
+        if (eq <= 0) {
+            *error = QString("第%1行格式错误: %2").arg(i + 1).arg(line);
+            return false;
+        }
+        QString key = line.left(eq).trimmed().toLower();
+        QStringList values = line.mid(eq + 1).split('|', Qt::SkipEmptyParts);
+        if (values.isEmpty() || variants->size() * values.size() > MAX_SWEEP_VARIANTS) {
+            *error = QString("第%1行: 参数组合数超过%2或没有取值").arg(i + 1).arg(MAX_SWEEP_VARIANTS);
+            return false;
+        }
+
+        // 已有的每个组合与本行的每个取值组合
+        QList<ppp_paths_t> expanded;
+        QStringList expandedLabels;
+        for (int k = 0; k < variants->size(); k++) {
+            for (QString value : values) {
+                value = value.trimmed();
+                ppp_paths_t variant = variants->at(k);
+                if (!setValue(key, value, &variant, error)) {
+                    *error = QString("第%1行: %2").arg(i + 1).arg(*error);
+                    return false;
+                }
+                expanded.append(variant);
+                QString label = labels->at(k);
+                expandedLabels.append((label.isEmpty() ? label : label + ' ') + key + '=' + value);
+            }
+        }
+        *variants = expanded;
+        *labels = expandedLabels;
+    }
+    return true;
+}
+
+bool PPPJobFile::parse(const QByteArray &text, ppp_paths_t *paths, QString *error)
+{
+    const QList<QByteArray> lines = text.split('\n');
+    return parseLines(lines, 0, lines.size(), paths, error) && validate(*paths, error);
+}
+
+bool PPPJobFile::parseLines(const QList<QByteArray> &lines, int first, int last, ppp_paths_t *paths, QString *error)
+{
+    for (int i = first; i < last; i++) {
+        QString line = QString::fromLocal8Bit(lines[i]).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        int eq = line.indexOf('=');
+        if (eq <= 0) {
+            *error = QString("第%1行格式错误: %2").arg(i + 1).arg(line);
+            return false;
+        }
+        QString key = line.left(eq).trimmed().toLower();
+        QString value = line.mid(eq + 1).trimmed();
+        if (!setValue(key, value, paths, error)) {
+            *error = QString("第%1行: %2").arg(i + 1).arg(*error);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool PPPJobFile::validate(const ppp_paths_t &paths, QString *error)
+{
+    if (!paths.obs_file[0]) {
+        *error = "任务文件缺少观测文件(obs)";
+        return false;
+    }
+    if (!paths.out_file[0]) {
+        *error = "任务文件缺少输出文件(out)";
+        return false;
+    }
+    if (paths.solformat != SOLFORMAT_TEXT && (paths.soltype == SOLTYPE_COMBINED || paths.shards > 1)) {
+        *error = "二进制结果文件(solformat = binary | records)只支持不分片的前向或后向解算";
+        return false;
+    }
+    return true;
+}
+
+bool PPPJobFile::setValue(const QString &key, const QString &value, ppp_paths_t *paths, QString *error)
+{
+    bool ok = true;
+    int index;
+
+    if (key == "obs") return copyPath(value, paths->obs_file, sizeof(paths->obs_file), error);
+    if (key == "nav") return copyPath(value, paths->nav_file, sizeof(paths->nav_file), error);
+    if (key == "sp3") return copyPath(value, paths->sp3_file, sizeof(paths->sp3_file), error);
+    if (key == "clk") return copyPath(value, paths->clk_file, sizeof(paths->clk_file), error);
+    if (key == "atx") return copyPath(value, paths->atx_file, sizeof(paths->atx_file), error);
+    if (key == "dcb") return copyPath(value, paths->dcb_file, sizeof(paths->dcb_file), error);
+    if (key == "erp") return copyPath(value, paths->erp_file, sizeof(paths->erp_file), error);
+    if (key == "out") return copyPath(value, paths->out_file, sizeof(paths->out_file), error);
+    if (key == "obscache") return copyPath(value, paths->obs_cache, sizeof(paths->obs_cache), error);
+    if (key == "stationdb") return copyPath(value, paths->station_db, sizeof(paths->station_db), error);
+
+    if (key == "mode") {
+        if ((index = indexOfName(MODE_NAMES, value)) < 0) ok = false;
+        else paths->mode = run_mode_t(index);
+    } else if (key == "trop") {
+        if ((index = indexOfName(TROP_NAMES, value)) < 0) ok = false;
+        else paths->tropopt = trop_opt_t(index);
+    } else if (key == "iono") {
+        if ((index = indexOfName(IONO_NAMES, value)) < 0) ok = false;
+        else paths->ionoopt = iono_opt_t(index);
+    } else if (key == "soltype") {
+        if ((index = indexOfName(SOLTYPE_NAMES, value)) < 0) ok = false;
+        else paths->soltype = sol_type_t(index);
+    } else if (key == "solformat") {
+        if ((index = indexOfName(SOLFORMAT_NAMES, value)) < 0) ok = false;
+        else paths->solformat = sol_format_t(index);
+    } else if (key == "navsys") {
+        ok = parseNavSys(value, &paths->navsys);
+    } else if (key == "ts") {
+        ok = parseTime(value, paths->ts);
+        paths->use_time_range = true;
+    } else if (key == "te") {
+        ok = parseTime(value, paths->te);
+        paths->use_time_range = true;
+    } else if (key == "ti") {
+        paths->ti = value.toDouble(&ok);
+    } else if (key == "niter") {
+        paths->niter = value.toInt(&ok);
+    } else if (key == "elmask") {
+        paths->elmask = value.toDouble(&ok);
+    } else if (key == "trace") {
+        paths->trace_level = value.toInt(&ok);
+    } else if (key == "tracefmt") {
+        if ((index = indexOfName(TRACEFORMAT_NAMES, value)) < 0) ok = false;
+        else paths->tracefmt = trace_format_t(index);
+    } else if (key == "shards") {
+        paths->shards = value.toInt(&ok);
+    } else if (key == "overlap") {
+        paths->shard_overlap = value.toDouble(&ok);
+    } else if (key == "checkpoint") {
+        paths->checkpoint = value.toInt(&ok) != 0;
+    } else if (key == "stream") {
+        paths->stream = value.toInt(&ok) != 0;
+    } else if (key == "earlystop") {
+        paths->early_stop = value.toInt(&ok) != 0;
+    } else if (key == "stopsigma") {
+        paths->stop_sigma = value.toDouble(&ok);
+    } else if (key == "stopchange") {
+        paths->stop_change = value.toDouble(&ok);
+    } else if (key == "stopwindow") {
+        paths->stop_window = value.toDouble(&ok);
+    } else {
+        *error = QString("未知的选项: %1").arg(key);
+        return false;
+    }
+
+    if (!ok) {
+        *error = QString("选项 %1 的值无效: %2").arg(key, value);
+    }
+    return ok;
+}
+
+bool PPPJobFile::parseTime(const QString &value, double *ep)
+{
+    double t[6] = { 0 };
+    QByteArray ba = value.toLatin1();
+    if (sscanf(ba.constData(), "%lf/%lf/%lf %lf:%lf:%lf", t, t + 1, t + 2, t + 3, t + 4, t + 5) < 3) {
+        return false;
+    }
+    for (int i = 0; i < 6; i++) {
+        ep[i] = t[i];
+    }
+    return true;
+}
+
+bool PPPJobFile::parseNavSys(const QString &value, int *navsys)
+{
+    int sys = 0;
+    const QStringList tokens = value.split(QRegularExpression("[,+\\s]+"), Qt::SkipEmptyParts);
+    for (const QString &token : tokens) {
+        int found = 0;
+        for (const auto &entry : NAVSYS_NAMES) {
+            if (token.compare(QLatin1String(entry.code), Qt::CaseInsensitive) == 0) {
+                found = entry.sys;
+            }
+            for (const char *name : entry.names) {
+                if (name && token.compare(QLatin1String(name), Qt::CaseInsensitive) == 0) {
+                    found = entry.sys;
+                }
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        sys |= found;
+    }
+    if (!sys) {
+        return false;
+    }
+    *navsys = sys;
+    return true;
+}
+
+QByteArray PPPJobFile::format(const ppp_paths_t &paths)
+{
+    QByteArray text;
+    auto addLine = [&text](const char *key, const QByteArray &value) {
+        text += key;
+        text += " = ";
+        text += value;
+        text += '\n';
+    };
+    auto addPath = [&addLine](const char *key, const char *path) {
+        if (path[0]) addLine(key, QByteArray(path));
+    };
+    auto epochText = [](const double *ep) {
+        return QString::asprintf("%04d/%02d/%02d %02d:%02d:%02d", int(ep[0]), int(ep[1]), int(ep[2]),
+                                 int(ep[3]), int(ep[4]), int(ep[5])).toLatin1();
+    };
+
+    addPath("obs", paths.obs_file);
+    addPath("nav", paths.nav_file);
+    addPath("sp3", paths.sp3_file);
+    addPath("clk", paths.clk_file);
+    addPath("atx", paths.atx_file);
+    addPath("dcb", paths.dcb_file);
+    addPath("erp", paths.erp_file);
+    addPath("out", paths.out_file);
+    addLine("mode", MODE_NAMES[paths.mode]);
+    addLine("trop", TROP_NAMES[paths.tropopt]);
+    addLine("iono", IONO_NAMES[paths.ionoopt]);
+    addLine("soltype", SOLTYPE_NAMES[paths.soltype]);
+    if (paths.solformat != SOLFORMAT_TEXT) {
+        addLine("solformat", SOLFORMAT_NAMES[paths.solformat]);
+    }
+
+    QByteArray sys;
+    for (const auto &entry : NAVSYS_NAMES) {
+        if (paths.navsys & entry.sys) {
+            if (!sys.isEmpty()) sys += ',';
+            sys += entry.code;
+        }
+    }
+    addLine("navsys", sys);
+
+    if (paths.use_time_range) {
+        addLine("ts", epochText(paths.ts));
+        addLine("te", epochText(paths.te));
+    }
+    addLine("ti", QByteArray::number(paths.ti));
+    addLine("niter", QByteArray::number(paths.niter));
+    addLine("elmask", QByteArray::number(paths.elmask));
+    addLine("trace", QByteArray::number(paths.trace_level));
+    if (paths.tracefmt != TRACEFORMAT_BINARY) {
+        addLine("tracefmt", TRACEFORMAT_NAMES[paths.tracefmt]);
+    }
+    if (paths.shards > 1) {
+        addLine("shards", QByteArray::number(paths.shards));
+        addLine("overlap", QByteArray::number(paths.shard_overlap));
+    }
+    if (paths.checkpoint) {
+        addLine("checkpoint", "1");
+    }
+    addPath("obscache", paths.obs_cache);
+    if (paths.stream) {
+        addLine("stream", "1");
+    }
+    addPath("stationdb", paths.station_db);
+    if (paths.early_stop) {
+        addLine("earlystop", "1");
+        addLine("stopsigma", QByteArray::number(paths.stop_sigma));
+        addLine("stopchange", QByteArray::number(paths.stop_change));
+        addLine("stopwindow", QByteArray::number(paths.stop_window));
+    }
+    return text;
+}
+
+QByteArray PPPJobFile::jobId(const ppp_paths_t &paths)
+{
+    ppp_paths_t key = paths;
+    key.trace_level = 0; // 日志级别和格式不影响结果
+    key.tracefmt = TRACEFORMAT_BINARY;
+    key.stream = false;  // 流式处理与读取全部观测数据的结果相同，检查点可以互相恢复
+    key.obs_cache[0] = '\0'; // 观测数据缓存的位置不影响结果，移动缓存目录后仍可恢复
+
+    // 输入文件的路径、修改时间和大小（与产品缓存的键相同），同一路径的文件被替换后不再从旧的检查点恢复
+    QByteArray text = format(key);
+    const char *const files[] = { paths.obs_file, paths.nav_file, paths.sp3_file, paths.clk_file,
+                                  paths.atx_file, paths.dcb_file, paths.erp_file };
+    for (const char *file : files) {
+        text += PPPProductCache::fileKey(file) + '\n';
+    }
+    return QCryptographicHash::hash(text, QCryptographicHash::Md5);
+}
@@ -0,0 +1,95 @@
+#ifndef PPPJOBFILE_H
+#define PPPJOBFILE_H
+
+#include "pppprocessor.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+// PPP任务文件：每行一个 "键 = 值"，'#' 开头为注释
+//
+//   obs    = D:/data/abcd0010.23o    观测文件（必需）
+//   nav    = D:/data/brdc0010.23p    导航文件
+//   sp3    = D:/data/igs22400.sp3    精密星历文件
+//   clk    = D:/data/igs22400.clk    精密钟差文件
+//   atx    = D:/data/igs20.atx       天线相位中心文件
+//   dcb    = D:/data/P1C12301.DCB    DCB文件
+//   erp    = D:/data/igs22407.erp    地球自转参数文件
+//   out    = D:/out/abcd0010.pos     输出文件（必需）
+//   mode   = static | kinematic
+//   trop   = off | saas | sbas | est | estg
+//   iono   = off | brdc | sbas | iflc | est | tec
+//   soltype = forward | backward | combined  解算方向（combined为前后向平滑）
+//   solformat = text | binary | records  结果文件格式：.pos文本，带时间索引或不带索引（处理中可读取）的二进制文件
+//   navsys = G,R,E,C,J,I,S           卫星系统（GPS,GLO,GAL,BDS,QZS,IRN,SBS）
+//   ts     = 2023/01/01 00:00:00     开始时间（指定ts/te即启用时间范围）
+//   te     = 2023/01/01 23:59:30     结束时间
+//   ti     = 30                      处理间隔(s)，0为全部历元
+//   niter  = 8                       最大迭代次数
+//   elmask = 15                      截止高度角(度)
+//   trace  = 0                       RTKLIB日志级别（0不生成日志）
+//   tracefmt = binary | text         日志格式：异步写出的二进制文件（默认，ppp_cli --trace2txt转换）或RTKLIB的文本
+//   shards = 8                       时间窗分片数，需同时指定ts/te（0不分片）
+//   overlap = 3600                   分片的收敛重叠时长(s)
+//   checkpoint = 1                   写检查点，中断后重新运行从最近的检查点恢复（仅前向解算）
+//   obscache = D:/cache              观测数据缓存目录，再次处理同一观测文件时不解析RINEX（仅前向解算）
+//   stream = 1                       流式处理，按历元读取观测文件，内存占用与文件长度无关（仅前向解算）
+//   stationdb = D:/data/stations.txt 测站数据库，静态PPP由上次的坐标和ZTD热启动，完成后更新
+//   earlystop = 1                    静态PPP收敛后提前结束（仅前向解算）
+//   stopsigma = 0.01                 提前结束的三维标准差阈值(m)
+//   stopchange = 0.005               提前结束的坐标变化阈值(m)
+//   stopwindow = 3600                条件需保持的时长(s)
+//
+// 批处理任务文件由多个 [job] 节组成，第一个 [job] 之前的键作为各任务的公共设置：
+//
+//   sp3 = D:/data/igs22400.sp3
+//   clk = D:/data/igs22400.clk
+//   [job]
+//   obs = D:/data/abcd0010.23o
+//   out = D:/out/abcd0010.pos
+//   [job]
+//   obs = D:/data/efgh0010.23o
+//   out = D:/out/efgh0010.pos
+//
+// 参数扫描文件每行一个 "键 = 值1 | 值2 | ..."，与任务文件的键相同，生成各行取值的所有组合：
+//
+//   trop   = est | estg
+//   iono   = iflc | est
+//   navsys = G | G,C | G,R,E,C
+//   elmask = 7 | 10 | 15
+//   niter  = 1 | 8
+class PPPJobFile
+{
+public:
+    // 从标准输入读取任务（路径为 "-"）时，遇到此行即结束，不必等到输入关闭
+    static constexpr const char *END_LINE = "[end]";
+
+    // 读取任务文件，未出现的键保持默认值
+    static bool load(const QString &path, ppp_paths_t *paths, QString *error);
+
+    // 读取批处理任务文件
+    static bool loadBatch(const QString &path, QList<ppp_paths_t> *jobs, QString *error);
+
+    // 读取参数扫描文件，以base为基础生成各参数组合及其说明（如 "trop=est iono=iflc"）
+    static bool loadSweep(const QString &path, const ppp_paths_t &base, QList<ppp_paths_t> *variants,
+                          QStringList *labels, QString *error);
+
+    // 解析任务文本
+    static bool parse(const QByteArray &text, ppp_paths_t *paths, QString *error);
+
+    // 将处理参数格式化为任务文本
+    static QByteArray format(const ppp_paths_t &paths);
+
+    // 任务标识（任务文本和各输入文件修改时间、大小的MD5，不含日志、流式处理和观测数据缓存目录等不影响结果的设置），用于判断检查点等中间结果是否属于该任务
+    static QByteArray jobId(const ppp_paths_t &paths);
+
+private:
+    static bool readText(const QString &path, QByteArray *text, QString *error);
+    static bool parseLines(const QList<QByteArray> &lines, int first, int last, ppp_paths_t *paths, QString *error);
+    static bool validate(const ppp_paths_t &paths, QString *error);
+    static bool setValue(const QString &key, const QString &value, ppp_paths_t *paths, QString *error);
+    static bool parseTime(const QString &value, double *ep);
+    static bool parseNavSys(const QString &value, int *navsys);
+};
+
+#endif // PPPJOBFILE_H
@@ -0,0 +1,144 @@
+#include "ppplogmodel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+#include <algorithm>
+
+PPPLogModel::PPPLogModel(QObject *parent)
+    : QAbstractListModel(parent), m_first(0), m_next(0), m_discarded(0), m_level(Info)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(FRAME_MSECS);
+    connect(&m_timer, &QTimer::timeout, this, &PPPLogModel::flush);
+}
+
+void PPPLogModel::append(const QString &message, Level level)
+{
+    // 待显示的消息过多（界面长时间未刷新）时立即插入，不超过缓冲区大小
+    if (m_pending.size() >= size_t(MAX_ENTRIES)) {
+        flush();
+    }
+    Entry entry;
+    entry.msecs = QDateTime::currentMSecsSinceEpoch();
+    entry.level = level;
+    entry.text = message.left(MAX_LENGTH);
+    if (entry.text.contains('\n')) {
+        entry.text.replace('\n', ' '); // 每条消息显示为一行
+    }
+    m_pending.push_back(std::move(entry));
+    if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+PPPLogModel::Level PPPLogModel::levelOf(const QString &message)
+{
+    if (message.contains("错误") || message.contains("失败") || message.startsWith("error", Qt::CaseInsensitive)) {
+        return Error;
+    }
+    if (message.contains("警告") || message.startsWith("warning", Qt::CaseInsensitive)) {
+        return Warning;
+    }
+    return Info;
+}
+
+void PPPLogModel::clear()
+{
+    beginResetModel();
+    std::vector<Entry>().swap(m_ring);
+    std::deque<quint64>().swap(m_rows);
+    std::vector<Entry>().swap(m_pending);
+    m_first = m_next = 0;
+    m_discarded = 0;
+    endResetModel();
+}
+
+void PPPLogModel::setFilter(Level level, const QString &text)
+{
+    flush();
+    beginResetModel();
+    m_level = level;
+    m_text = text;
+    m_rows.clear();
+    for (quint64 seq = m_first; seq < m_next; seq++) {
+        if (matches(entry(seq))) m_rows.push_back(seq);
+    }
+    endResetModel();
+}
+
+qint64 PPPLogModel::discarded() const
+{
+    return m_discarded;
+}
+
+int PPPLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_rows.size());
+}
+
+QVariant PPPLogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= int(m_rows.size())) {
+        return QVariant();
+    }
+    const Entry &e = entry(m_rows[index.row()]);
+    if (role == Qt::DisplayRole) {
+        return QDateTime::fromMSecsSinceEpoch(e.msecs).toString("[yyyy-MM-dd hh:mm:ss] ") + e.text;
+    }
+    if (role == Qt::ForegroundRole && e.level != Info) {
+        return QBrush(e.level == Error ? QColor(200, 0, 0) : QColor(170, 110, 0));
+    }
+    return QVariant();
+}
+
+void PPPLogModel::flush()
+{
+    m_timer.stop();
+    if (m_pending.empty()) {
+        return;
+    }
+
+    // 一帧内超出缓冲区的消息直接丢弃，其余的依次替换最早的消息
+    size_t n = m_pending.size();
+    size_t skip = n > size_t(MAX_ENTRIES) ? n - MAX_ENTRIES : 0;
+    quint64 next = m_next + (n - skip);
+    quint64 first = next > quint64(MAX_ENTRIES) ? std::max(m_first, next - MAX_ENTRIES) : m_first;
+    m_discarded += qint64(skip + (first - m_first));
+
+    auto end = std::lower_bound(m_rows.begin(), m_rows.end(), first);
+    if (end != m_rows.begin()) {
+        beginRemoveRows(QModelIndex(), 0, int(end - m_rows.begin()) - 1);
+        m_rows.erase(m_rows.begin(), end);
+        endRemoveRows();
+    }
+    m_first = first;
+
+    std::vector<quint64> added;
+    for (size_t i = skip; i < n; i++) {
+        quint64 seq = m_next++;
+        if (m_ring.size() < size_t(MAX_ENTRIES)) {
+            m_ring.push_back(std::move(m_pending[i]));
+        } else {
+            m_ring[seq % MAX_ENTRIES] = std::move(m_pending[i]);
+        }
+        if (matches(entry(seq))) added.push_back(seq);
+    }
+    m_pending.clear();
+
+    if (!added.empty()) {
+        int row = int(m_rows.size());
+        beginInsertRows(QModelIndex(), row, row + int(added.size()) - 1);
+        m_rows.insert(m_rows.end(), added.begin(), added.end());
+        endInsertRows();
+    }
+}
+
+bool PPPLogModel::matches(const Entry &entry) const
+{
+    return entry.level >= m_level && (m_text.isEmpty() || entry.text.contains(m_text, Qt::CaseInsensitive));
+}
+
+const PPPLogModel::Entry &PPPLogModel::entry(quint64 seq) const
+{
+    return m_ring[seq % MAX_ENTRIES];
+}
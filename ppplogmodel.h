@@ -0,0 +1,72 @@
+#ifndef PPPLOGMODEL_H
+#define PPPLOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include <deque>
+#include <vector>
+
+// 日志的数据模型
+// 最近的MAX_ENTRIES条消息保存在环形缓冲区中，更早的消息被丢弃，长时间运行内存不增长。
+// 新消息先放入待显示列表，由定时器按固定帧率一次插入视图，每秒上万条消息也只引起每帧一次的布局更新；
+// 列表视图只请求可见的行，文本在data()中按需加上时间。
+// 按级别和关键字过滤时只保存匹配消息的序号，不复制消息。
+class PPPLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Level {
+        Info,
+        Warning,
+        Error
+    };
+
+    static const int MAX_ENTRIES = 100000;   // 保存的消息数
+    static const int MAX_LENGTH = 4096;      // 单条消息的最大长度，更长的截断
+    static const int FRAME_MSECS = 33;       // 更新视图的间隔（约30帧/秒）
+
+    explicit PPPLogModel(QObject *parent = nullptr);
+
+    // 追加一条消息，在下一帧显示
+    void append(const QString &message, Level level = Info);
+
+    // 按内容判断级别：错误/失败为Error，警告为Warning（含RTKLIB的"error"/"warning"）
+    static Level levelOf(const QString &message);
+
+    void clear();
+
+    // 只显示不低于level且包含text（不区分大小写，为空则不限）的消息
+    void setFilter(Level level, const QString &text);
+
+    // 已丢弃的消息数（超出缓冲区）
+    qint64 discarded() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Entry {
+        qint64 msecs;     // 时间 (ms since epoch)
+        Level level;
+        QString text;
+    };
+
+    void flush();
+    bool matches(const Entry &entry) const;
+    const Entry &entry(quint64 seq) const;
+
+    std::vector<Entry> m_ring;       // 序号seq的消息位于m_ring[seq % MAX_ENTRIES]
+    quint64 m_first;                 // 缓冲区中最早消息的序号
+    quint64 m_next;                  // 下一条消息的序号
+    std::deque<quint64> m_rows;      // 显示的消息序号
+    std::vector<Entry> m_pending;    // 待显示的消息
+    qint64 m_discarded;
+    Level m_level;
+    QString m_text;
+    QTimer m_timer;
+};
+
+#endif // PPPLOGMODEL_H
@@ -0,0 +1,257 @@
+#include "pppobscache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <climits>
+#include <cstring>
+#include <vector>
+
+static const char OBS_CACHE_MAGIC[8] = { 'P', 'P', 'P', 'O', 'B', 'S', 'C', '1' };
+
+// 每条观测记录的频率（观测值）个数
+static const int NOBS = NFREQ + NEXOBS;
+
+// GLONASS频率号个数（nav_t::glo_fcn）
+static const int NFCN = 32;
+
+// 缓存文件头，其后依次为sta_t、GLONASS频率号和各列数据，每段按8字节对齐
+struct ObsCacheHeader {
+    char magic[8];
+    quint32 nobs;          // NFREQ+NEXOBS
+    quint32 staSize;       // sizeof(sta_t)
+    qint64 count;          // 观测记录数
+    quint8 key[16];        // 缓存键
+    quint8 digest[16];     // 文件头之后全部数据的MD5
+};
+
+// 分段计算摘要，缓存文件可能超过QByteArray的长度上限
+static void addData(QCryptographicHash *hash, const char *data, qint64 size)
+{
+    static const qint64 CHUNK = 64 << 20;
+    for (qint64 i = 0; i < size; i += CHUNK) {
+        hash->addData(QByteArray::fromRawData(data + i, int(qMin(CHUNK, size - i))));
+    }
+}
+
+static qint64 aligned(qint64 size)
+{
+    return (size + 7) & ~qint64(7);
+}
+
+// 数据部分的总长度：sta_t、频率号，以及时间(秒+小数秒)、卫星号、接收机号各一列，
+// 信噪比、失锁标志、码类型、载波相位、伪距、多普勒每个频率一列
+static qint64 payloadSize(qint64 n)
+{
+    return aligned(sizeof(sta_t)) + aligned(NFCN * sizeof(qint32)) + aligned(n * 8) * 2 + aligned(n) * 2 +
+           NOBS * (aligned(n * 2) + aligned(n) * 2 + aligned(n * 8) * 2 + aligned(n * 4));
+}
+
+// 写入一列数据并累加到摘要
+class ColumnWriter
+{
+public:
+    ColumnWriter(QSaveFile *file, QCryptographicHash *hash) : m_file(file), m_hash(hash) {}
+
+    void put(const void *data, qint64 size)
+    {
+        static const char zeros[8] = { 0 };
+        write(static_cast<const char *>(data), size);
+        write(zeros, aligned(size) - size);
+    }
+
+    template <typename T, typename F>
+    void column(int n, F get)
+    {
+        std::vector<T> values(n);
+        for (int i = 0; i < n; i++) values[i] = get(i);
+        put(values.data(), qint64(n) * sizeof(T));
+    }
+
+private:
+    void write(const char *data, qint64 size)
+    {
+        m_file->write(data, size);
+        addData(m_hash, data, size);
+    }
+
+    QSaveFile *m_file;
+    QCryptographicHash *m_hash;
+};
+
+// 按列读取
+class ColumnReader
+{
+public:
+    explicit ColumnReader(const uchar *data) : m_data(data) {}
+
+    void get(void *data, qint64 size)
+    {
+        memcpy(data, m_data, size_t(size));
+        m_data += aligned(size);
+    }
+
+    template <typename T, typename F>
+    void column(int n, F set)
+    {
+        const T *values = reinterpret_cast<const T *>(m_data);
+        for (int i = 0; i < n; i++) set(i, values[i]);
+        m_data += aligned(qint64(n) * sizeof(T));
+    }
+
+private:
+    const uchar *m_data;
+};
+
+PPPObsCache::PPPObsCache(const QString &dir)
+    : m_dir(dir)
+{
+}
+
+bool PPPObsCache::setSource(const char *file, gtime_t ts, gtime_t te, double ti, const char *opt)
+{
+    QFile source(QString::fromLocal8Bit(file));
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (!hash.addData(&source)) {
+        return false;
+    }
+    // 读取参数和记录结构也是键的一部分，RTKLIB的obsd_t定义变化后不会读取旧缓存
+    QByteArray params;
+    params.append(OBS_CACHE_MAGIC, sizeof(OBS_CACHE_MAGIC));
+    params.append(QByteArray::number(qint64(ts.time)) + ' ' + QByteArray::number(ts.sec, 'g', 17) + ' ');
+    params.append(QByteArray::number(qint64(te.time)) + ' ' + QByteArray::number(te.sec, 'g', 17) + ' ');
+    params.append(QByteArray::number(ti, 'g', 17) + ' ' + QByteArray(opt) + ' ');
+    params.append(QByteArray::number(NOBS) + ' ' + QByteArray::number(int(sizeof(sta_t))));
+    hash.addData(params);
+    m_key = hash.result();
+    return true;
+}
+
+QString PPPObsCache::path() const
+{
+    return QDir(m_dir).filePath(QString::fromLatin1(m_key.toHex()) + ".obsc");
+}
+
+bool PPPObsCache::load(obs_t *obs, sta_t *sta, int *fcn, QString *reason) const
+{
+    reason->clear();
+    QFile file(path());
+    if (m_key.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    ObsCacheHeader header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        *reason = "truncated header";
+        return false;
+    }
+    if (memcmp(header.magic, OBS_CACHE_MAGIC, sizeof(header.magic)) || header.nobs != quint32(NOBS) ||
+        header.staSize != sizeof(sta_t) || memcmp(header.key, m_key.constData(), sizeof(header.key))) {
+        *reason = "stale format";
+        return false;
+    }
+    if (header.count <= 0 || header.count > INT_MAX ||
+        file.size() != qint64(sizeof(header)) + payloadSize(header.count)) {
+        *reason = "size mismatch";
+        return false;
+    }
+    const uchar *data = file.map(sizeof(header), payloadSize(header.count));
+    if (!data) {
+        *reason = "map failed";
+        return false;
+    }
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    addData(&hash, reinterpret_cast<const char *>(data), payloadSize(header.count));
+    if (memcmp(hash.result().constData(), header.digest, sizeof(header.digest))) {
+        *reason = "checksum mismatch";
+        return false;
+    }
+
+    int n = int(header.count);
+    obsd_t *records = static_cast<obsd_t *>(calloc(n, sizeof(obsd_t)));
+    if (!records) {
+        *reason = "insufficient memory";
+        return false;
+    }
+    qint32 glo[NFCN];
+    ColumnReader reader(data);
+    reader.get(sta, sizeof(sta_t));
+    reader.get(glo, sizeof(glo));
+    reader.column<qint64>(n, [records](int i, qint64 v) { records[i].time.time = time_t(v); });
+    reader.column<double>(n, [records](int i, double v) { records[i].time.sec = v; });
+    reader.column<quint8>(n, [records](int i, quint8 v) { records[i].sat = v; });
+    reader.column<quint8>(n, [records](int i, quint8 v) { records[i].rcv = v; });
+    for (int f = 0; f < NOBS; f++) {
+        reader.column<quint16>(n, [records, f](int i, quint16 v) { records[i].SNR[f] = v; });
+        reader.column<quint8>(n, [records, f](int i, quint8 v) { records[i].LLI[f] = v; });
+        reader.column<quint8>(n, [records, f](int i, quint8 v) { records[i].code[f] = v; });
+        reader.column<double>(n, [records, f](int i, double v) { records[i].L[f] = v; });
+        reader.column<double>(n, [records, f](int i, double v) { records[i].P[f] = v; });
+        reader.column<float>(n, [records, f](int i, float v) { records[i].D[f] = v; });
+    }
+    for (int i = 0; i < NFCN; i++) {
+        fcn[i] = glo[i];
+    }
+    free(obs->data);
+    obs->data = records;
+    obs->n = obs->nmax = n;
+    return true;
+}
+
+bool PPPObsCache::store(const obs_t *obs, const sta_t *sta, const int *fcn, QString *error) const
+{
+    if (m_key.isEmpty() || obs->n <= 0) {
+        return false;
+    }
+    if (!QDir().mkpath(m_dir)) {
+        *error = QString("error : obs cache directory %1").arg(m_dir);
+        return false;
+    }
+    QSaveFile file(path());
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = QString("error : obs cache write %1").arg(path());
+        return false;
+    }
+
+    // 文件头的摘要在写完数据后回填
+    ObsCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, OBS_CACHE_MAGIC, sizeof(header.magic));
+    header.nobs = NOBS;
+    header.staSize = sizeof(sta_t);
+    header.count = obs->n;
+    memcpy(header.key, m_key.constData(), sizeof(header.key));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    ColumnWriter writer(&file, &hash);
+    const obsd_t *records = obs->data;
+    int n = obs->n;
+    qint32 glo[NFCN];
+    for (int i = 0; i < NFCN; i++) glo[i] = fcn[i];
+    writer.put(sta, sizeof(sta_t));
+    writer.put(glo, sizeof(glo));
+    writer.column<qint64>(n, [records](int i) { return qint64(records[i].time.time); });
+    writer.column<double>(n, [records](int i) { return records[i].time.sec; });
+    writer.column<quint8>(n, [records](int i) { return records[i].sat; });
+    writer.column<quint8>(n, [records](int i) { return records[i].rcv; });
+    for (int f = 0; f < NOBS; f++) {
+        writer.column<quint16>(n, [records, f](int i) { return records[i].SNR[f]; });
+        writer.column<quint8>(n, [records, f](int i) { return records[i].LLI[f]; });
+        writer.column<quint8>(n, [records, f](int i) { return records[i].code[f]; });
+        writer.column<double>(n, [records, f](int i) { return records[i].L[f]; });
+        writer.column<double>(n, [records, f](int i) { return records[i].P[f]; });
+        writer.column<float>(n, [records, f](int i) { return records[i].D[f]; });
+    }
+
+    memcpy(header.digest, hash.result().constData(), sizeof(header.digest));
+    if (!file.seek(0) ||
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        !file.commit()) {
+        *error = QString("error : obs cache write %1").arg(path());
+        return false;
+    }
+    return true;
+}
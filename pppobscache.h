@@ -0,0 +1,36 @@
+#ifndef PPPOBSCACHE_H
+#define PPPOBSCACHE_H
+
+#include "rtklib.h"
+#include <QByteArray>
+#include <QString>
+
+// 观测数据缓存
+// 解码后的观测数据按列存储（时间、卫星号以及各频率的信噪比、载波相位、伪距等分别连续存放），
+// 文件名为观测文件内容与读取参数（时间范围、间隔、RINEX选项）的MD5，
+// 观测文件或读取参数变化后不会命中旧的缓存。
+// 命中时映射缓存文件按列填充obs_t，不再解析RINEX文本；缓存过期或损坏时返回false，由调用者重新解析。
+class PPPObsCache
+{
+public:
+    explicit PPPObsCache(const QString &dir);
+
+    // 计算缓存键（读取整个观测文件），文件无法读取时返回false
+    bool setSource(const char *file, gtime_t ts, gtime_t te, double ti, const char *opt);
+
+    // 缓存文件路径
+    QString path() const;
+
+    // 读取缓存到空的obs，sta为测站信息，fcn为GLONASS频率号（nav_t::glo_fcn）
+    // 缓存不存在时reason为空，过期或损坏时给出原因
+    bool load(obs_t *obs, sta_t *sta, int *fcn, QString *reason) const;
+
+    // 写入缓存，写入过程中中断不会留下不完整的缓存文件
+    bool store(const obs_t *obs, const sta_t *sta, const int *fcn, QString *error) const;
+
+private:
+    QString m_dir;
+    QByteArray m_key;
+};
+
+#endif // PPPOBSCACHE_H
@@ -0,0 +1,298 @@
+#include "pppobsreader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QThread>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// 每段的最小字节数，较小的文件分段解码的收益不及线程开销
+static const qint64 MIN_CHUNK_BYTES = 4 << 20;
+
+// 一段观测数据（以历元行开始）
+struct ObsChunk {
+    qint64 start;                 // 段起点和终点的文件偏移
+    qint64 end;
+    std::vector<obsd_t> data;
+    std::vector<int> epochs;      // 各历元的观测数
+    sta_t sta;                    // 文件头中的测站信息
+    int fcn[32];                  // 文件头中的GLONASS频率号
+    int tsys;
+    bool ok;                      // 解码成功且不含事件记录
+};
+
+// 超过2GB的文件也需要定位（定位到二进制扫描得到的历元行起点，文本方式下也是行首）
+static int seekFile(FILE *fp, qint64 offset)
+{
+#ifdef WIN32
+    return _fseeki64(fp, offset, SEEK_SET);
+#else
+    return fseeko(fp, off_t(offset), SEEK_SET);
+#endif
+}
+
+// RINEX 3观测文件返回文件头之后的位置，其他文件返回-1
+static qint64 headerEnd(QFile *file)
+{
+    QByteArray line = file->readLine();
+    if (line.size() < 21 || line.left(9).trimmed().toDouble() < 3.0 || line[20] != 'O') {
+        return -1;
+    }
+    while (!file->atEnd()) {
+        line = file->readLine();
+        if (line.mid(60).startsWith("END OF HEADER")) {
+            return file->pos();
+        }
+    }
+    return -1;
+}
+
+// offset之后第一个历元行的位置，没有则返回-1
+static qint64 nextEpoch(QFile *file, qint64 offset)
+{
+    if (!file->seek(offset)) {
+        return -1;
+    }
+    file->readLine(); // 不完整的行
+    while (!file->atEnd()) {
+        qint64 pos = file->pos();
+        if (file->readLine().startsWith('>')) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+// 段内的历元数：以'>'开头的行数，与分段时查找历元行的方法相同，-1为读取失败
+static int countEpochs(const char *file, qint64 start, qint64 end)
+{
+    QFile source(QString::fromLocal8Bit(file));
+    if (!source.open(QIODevice::ReadOnly) || !source.seek(start)) {
+        return -1;
+    }
+    int count = 0;
+    bool lineStart = true; // 段起点是历元行的行首
+    QByteArray block;
+    for (qint64 pos = start; pos < end; pos += block.size()) {
+        block = source.read(qMin(end - pos, qint64(1) << 20));
+        if (block.isEmpty()) {
+            return -1;
+        }
+        const char *p = block.constData(), *last = p + block.size();
+        while (p < last) {
+            if (lineStart && *p == '>') count++;
+            const char *newline = static_cast<const char *>(memchr(p, '\n', last - p));
+            lineStart = newline != nullptr;
+            if (!newline) break;
+            p = newline + 1;
+        }
+    }
+    return count;
+}
+
+// 解码一段，文件头由每个线程各自读取
+// RTKLIB与readrnxt一样以文本方式读取，段的终点由历元数确定而不比较文件位置：
+// 段的边界是二进制的字节偏移，Windows上文本方式打开的文件对只有LF换行的文件ftell给出的不是字节偏移
+static void decodeChunk(const char *file, const char *opt, ObsChunk *chunk)
+{
+    chunk->ok = false;
+    int epochs = countEpochs(file, chunk->start, chunk->end);
+    if (epochs <= 0) {
+        return;
+    }
+    FILE *fp = fopen(file, "r");
+    if (!fp) {
+        return;
+    }
+    // rnxctr_t含nav_t，在堆上创建，避免超出线程栈
+    std::unique_ptr<rnxctr_t> rnx(new rnxctr_t);
+    if (!init_rnxctr(rnx.get())) {
+        fclose(fp);
+        return;
+    }
+    strncpy(rnx->opt, opt, sizeof(rnx->opt) - 1);
+    rnx->opt[sizeof(rnx->opt) - 1] = '\0';
+    bool ok = open_rnxctr(rnx.get(), fp) && rnx->type == 'O' && !seekFile(fp, chunk->start);
+    for (int i = 0; ok && i < epochs; i++) {
+        int ret = input_rnxctr(rnx.get(), fp);
+        if (ret > 0 && rnx->obs.n > 0) {
+            chunk->data.insert(chunk->data.end(), rnx->obs.data, rnx->obs.data + rnx->obs.n);
+            chunk->epochs.push_back(rnx->obs.n);
+        } else {
+            ok = false; // 事件记录或文件提前结束等，由readrnxt处理
+        }
+    }
+    if (ok) {
+        chunk->sta = rnx->sta;
+        chunk->tsys = rnx->tsys;
+        memcpy(chunk->fcn, rnx->nav.glo_fcn, sizeof(chunk->fcn));
+        chunk->ok = true;
+    }
+    free_rnxctr(rnx.get());
+    fclose(fp);
+}
+
+PPPObsReader::PPPObsReader()
+    : m_threads(QThread::idealThreadCount()), m_chunks(0)
+{
+}
+
+void PPPObsReader::setThreadCount(int count)
+{
+    m_threads = count;
+}
+
+int PPPObsReader::threadCount() const
+{
+    return m_threads;
+}
+
+int PPPObsReader::chunkCount() const
+{
+    return m_chunks;
+}
+
+int PPPObsReader::read(const char *file, int rcv, gtime_t ts, gtime_t te, double ti, const char *opt, obs_t *obs,
+                       nav_t *nav, sta_t *sta)
+{
+    m_chunks = 0;
+
+    // 按历元边界分段，通配符路径和压缩文件由readrnxt展开和解压，管道只能顺序读取
+    std::vector<ObsChunk> chunks;
+    QFile source(QString::fromLocal8Bit(file));
+    if (m_threads > 1 && !strchr(file, '*') && QFileInfo(source).isFile() && source.open(QIODevice::ReadOnly)) {
+        qint64 begin = headerEnd(&source), size = source.size();
+        int n = begin < 0 ? 0 : int(qMin(qint64(m_threads), (size - begin) / MIN_CHUNK_BYTES));
+        QList<qint64> starts;
+        if (n > 1) {
+            starts.append(begin);
+        }
+        for (int i = 1; i < n; i++) {
+            qint64 start = nextEpoch(&source, begin + (size - begin) * i / n);
+            if (start < 0) break;
+            if (start > starts.last()) starts.append(start);
+        }
+        source.close();
+        for (int i = 0; starts.size() > 1 && i < starts.size(); i++) {
+            ObsChunk chunk;
+            chunk.start = starts[i];
+            chunk.end = i + 1 < starts.size() ? starts[i + 1] : size;
+            chunk.ok = false;
+            chunks.push_back(std::move(chunk));
+        }
+    }
+    if (chunks.empty()) {
+        return readrnxt(file, rcv, ts, te, ti, opt, obs, nav, sta);
+    }
+
+    QList<QThread *> threads;
+    for (ObsChunk &chunk : chunks) {
+        ObsChunk *p = &chunk;
+        threads.append(QThread::create([file, opt, p]() { decodeChunk(file, opt, p); }));
+        threads.last()->start();
+    }
+    bool ok = true;
+    for (int i = 0; i < threads.size(); i++) {
+        threads[i]->wait();
+        delete threads[i];
+        ok = ok && chunks[i].ok;
+    }
+    if (!ok) {
+        return readrnxt(file, rcv, ts, te, ti, opt, obs, nav, sta);
+    }
+    m_chunks = int(chunks.size());
+
+    // 文件头信息
+    const ObsChunk &head = chunks[0];
+    if (sta) {
+        *sta = head.sta;
+    }
+    if (nav) {
+        for (int i = 0; i < 32; i++) {
+            if (head.fcn[i]) nav->glo_fcn[i] = head.fcn[i];
+        }
+    }
+
+    size_t total = 0;
+    for (const ObsChunk &chunk : chunks) {
+        total += chunk.data.size();
+    }
+    if (obs->nmax < obs->n + int(total)) {
+        obsd_t *data = static_cast<obsd_t *>(realloc(obs->data, sizeof(obsd_t) * (obs->n + total)));
+        if (!data) {
+            return -1;
+        }
+        obs->data = data;
+        obs->nmax = obs->n + int(total);
+    }
+
+    // 按文件顺序合并，与RTKLIB readrnxobs相同：筛选掉的历元的周跳标志保留到下一个读取的历元
+    uint8_t slips[MAXSAT][NFREQ + NEXOBS] = {};
+    int stat = 0;
+    for (ObsChunk &chunk : chunks) {
+        obsd_t *data = chunk.data.data();
+        for (int n : chunk.epochs) {
+            for (int i = 0; i < n; i++) {
+                if (head.tsys == TSYS_UTC) data[i].time = utc2gpst(data[i].time);
+                for (int j = 0; j < NFREQ + NEXOBS; j++) {
+                    if (data[i].LLI[j] & 1) slips[data[i].sat - 1][j] |= LLI_SLIP;
+                }
+            }
+            if (screent(data[0].time, ts, te, ti)) {
+                for (int i = 0; i < n; i++) {
+                    for (int j = 0; j < NFREQ + NEXOBS; j++) {
+                        if (slips[data[i].sat - 1][j] & 1) data[i].LLI[j] |= LLI_SLIP;
+                        slips[data[i].sat - 1][j] = 0;
+                    }
+                    data[i].rcv = uint8_t(rcv);
+                    obs->data[obs->n++] = data[i];
+                }
+                stat = 1;
+            }
+            data += n;
+        }
+    }
+
+    if (sta) {
+        setStationName(file, sta);
+    }
+    return stat;
+}
+
+void PPPObsReader::setStationName(const char *file, sta_t *sta)
+{
+    if (*sta->name) {
+        return;
+    }
+    const char *p = strrchr(file, FILEPATHSEP);
+    p = p ? p + 1 : file;
+    int len = 0;
+    while (len < 4 && p[len]) len++;
+    while (len > 0 && p[len - 1] == ' ') len--;
+    memcpy(sta->name, p, len);
+    sta->name[len] = '\0';
+}
+
+bool PPPObsReader::sameObs(const obsd_t &a, const obsd_t &b)
+{
+    return a.time.time == b.time.time && !memcmp(&a.time.sec, &b.time.sec, sizeof(double)) && a.sat == b.sat &&
+           a.rcv == b.rcv && !memcmp(a.SNR, b.SNR, sizeof(a.SNR)) && !memcmp(a.LLI, b.LLI, sizeof(a.LLI)) &&
+           !memcmp(a.code, b.code, sizeof(a.code)) && !memcmp(a.L, b.L, sizeof(a.L)) &&
+           !memcmp(a.P, b.P, sizeof(a.P)) && !memcmp(a.D, b.D, sizeof(a.D));
+}
+
+bool PPPObsReader::sameStation(const sta_t &a, const sta_t &b)
+{
+    const char *const fields[][2] = {
+        { a.name, b.name }, { a.marker, b.marker }, { a.antdes, b.antdes }, { a.antsno, b.antsno },
+        { a.rectype, b.rectype }, { a.recver, b.recver }, { a.recsno, b.recsno },
+    };
+    for (const auto &field : fields) {
+        if (strncmp(field[0], field[1], MAXANT)) return false;
+    }
+    return a.antsetup == b.antsetup && a.itrf == b.itrf && a.deltype == b.deltype &&
+           a.glo_cp_align == b.glo_cp_align && !memcmp(a.pos, b.pos, sizeof(a.pos)) &&
+           !memcmp(a.del, b.del, sizeof(a.del)) && !memcmp(&a.hgt, &b.hgt, sizeof(double)) &&
+           !memcmp(a.glo_cp_bias, b.glo_cp_bias, sizeof(a.glo_cp_bias));
+}
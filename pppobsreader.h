@@ -0,0 +1,39 @@
+#ifndef PPPOBSREADER_H
+#define PPPOBSREADER_H
+
+#include "rtklib.h"
+#include <QtGlobal>
+
+// 多线程RINEX观测文件读取
+// RINEX 3的每个历元以'>'开头，文件按历元边界分为若干段，各段在不同线程中用RTKLIB的rnxctr解码，
+// 再按文件顺序合并，并与readrnxt一样进行UTC转换、时间筛选和跳过历元的周跳标志合并，结果与readrnxt相同。
+// RINEX 2、压缩文件、含事件记录的文件以及较小的文件直接调用readrnxt。
+class PPPObsReader
+{
+public:
+    PPPObsReader();
+
+    // 解码线程数，默认为逻辑核心数，<=1为单线程
+    void setThreadCount(int count);
+    int threadCount() const;
+
+    // 参数和返回值与readrnxt相同
+    int read(const char *file, int rcv, gtime_t ts, gtime_t te, double ti, const char *opt, obs_t *obs, nav_t *nav,
+             sta_t *sta);
+
+    // 上次读取分段解码的段数，0为使用readrnxt
+    int chunkCount() const;
+
+    // 与readrnxt相同：测站名为空时取文件名的前4个字符
+    static void setStationName(const char *file, sta_t *sta);
+
+    // 读取结果逐位比较（不比较结构体的填充字节），性能测试和回归测试用来检查与readrnxt是否相同
+    static bool sameObs(const obsd_t &a, const obsd_t &b);
+    static bool sameStation(const sta_t &a, const sta_t &b);
+
+private:
+    int m_threads;
+    int m_chunks;
+};
+
+#endif // PPPOBSREADER_H
@@ -0,0 +1,154 @@
+#include "pppobsstream.h"
+#include "pppobsreader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstring>
+
+PPPObsStream::PPPObsStream()
+    : m_fp(nullptr), m_rnx(nullptr), m_ts({ 0 }), m_te({ 0 }), m_ti(0.0), m_count(0)
+{
+    memset(m_slips, 0, sizeof(m_slips));
+}
+
+PPPObsStream::~PPPObsStream()
+{
+    close();
+}
+
+bool PPPObsStream::isStreamable(const char *file)
+{
+    // 管道（进程内解压的压缩文件）不能重新打开和定位
+    QFile source(QString::fromLocal8Bit(file));
+    if (strchr(file, '*') || !QFileInfo(source).isFile() || !source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray line = source.readLine();
+    return line.size() >= 21 && line.left(9).trimmed().toDouble() >= 3.0 && line[20] == 'O';
+}
+
+bool PPPObsStream::open(const char *file, gtime_t ts, gtime_t te, double ti, const char *opt, sta_t *sta, int *fcn)
+{
+    close();
+    if (!(m_fp = fopen(file, "r"))) {
+        return false;
+    }
+    // rnxctr_t含nav_t，在堆上创建
+    m_rnx = new rnxctr_t;
+    if (!init_rnxctr(m_rnx)) {
+        delete m_rnx;
+        m_rnx = nullptr;
+        close();
+        return false;
+    }
+    strncpy(m_rnx->opt, opt, sizeof(m_rnx->opt) - 1);
+    m_rnx->opt[sizeof(m_rnx->opt) - 1] = '\0';
+    if (!open_rnxctr(m_rnx, m_fp) || m_rnx->type != 'O') {
+        close();
+        return false;
+    }
+    m_file = QByteArray(file);
+    m_ts = ts;
+    m_te = te;
+    m_ti = ti;
+    m_count = 0;
+    memset(m_slips, 0, sizeof(m_slips));
+    if (sta) {
+        *sta = m_rnx->sta;
+        PPPObsReader::setStationName(file, sta);
+    }
+    if (fcn) {
+        for (int i = 0; i < 32; i++) {
+            if (m_rnx->nav.glo_fcn[i]) fcn[i] = m_rnx->nav.glo_fcn[i];
+        }
+    }
+    return true;
+}
+
+void PPPObsStream::close()
+{
+    if (m_rnx) {
+        free_rnxctr(m_rnx);
+        delete m_rnx;
+        m_rnx = nullptr;
+    }
+    if (m_fp) {
+        fclose(m_fp);
+        m_fp = nullptr;
+    }
+}
+
+bool PPPObsStream::scanSpan(gtime_t *first, gtime_t *last) const
+{
+    QFile file(QString::fromLocal8Bit(m_file));
+    if (!m_rnx || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // 与RTKLIB decode_obsepoch相同：历元标志0-2和6为观测数据
+    bool found = false;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (!line.startsWith('>') || line.size() < 35) continue;
+        int flag = line[31] - '0';
+        gtime_t time;
+        if ((flag > 2 && flag != 6) || line.mid(32, 3).trimmed().toInt() <= 0 ||
+            str2time(line.constData(), 1, 28, &time)) {
+            continue;
+        }
+        if (m_rnx->tsys == TSYS_UTC) time = utc2gpst(time);
+        if (!screent(time, m_ts, m_te, m_ti)) continue;
+        if (!found) *first = time;
+        *last = time;
+        found = true;
+    }
+    return found;
+}
+
+int PPPObsStream::next(obsd_t *obs)
+{
+    while (m_rnx) {
+        int ret = input_rnxctr(m_rnx, m_fp);
+        if (ret < 0 && feof(m_fp)) {
+            return 0;
+        }
+        int n = m_rnx->obs.n;
+        if (ret <= 0 || n <= 0) {
+            continue; // 事件记录
+        }
+        obsd_t *data = m_rnx->obs.data;
+
+        // 与RTKLIB readrnxobs相同：筛选掉的历元的周跳标志保留到下一个读取的历元
+        for (int i = 0; i < n; i++) {
+            if (m_rnx->tsys == TSYS_UTC) data[i].time = utc2gpst(data[i].time);
+            for (int j = 0; j < NFREQ + NEXOBS; j++) {
+                if (data[i].LLI[j] & 1) m_slips[data[i].sat - 1][j] |= LLI_SLIP;
+            }
+        }
+        if (!screent(data[0].time, m_ts, m_te, m_ti)) {
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < NFREQ + NEXOBS; j++) {
+                if (m_slips[data[i].sat - 1][j] & 1) data[i].LLI[j] |= LLI_SLIP;
+                m_slips[data[i].sat - 1][j] = 0;
+            }
+            data[i].rcv = 1;
+        }
+
+        // 与sortobs相同：按卫星号排序并去除重复的卫星
+        std::stable_sort(data, data + n, [](const obsd_t &a, const obsd_t &b) { return a.sat < b.sat; });
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            if (m > 0 && obs[m - 1].sat == data[i].sat) continue;
+            obs[m++] = data[i];
+        }
+        m_count += m;
+        return m;
+    }
+    return 0;
+}
+
+int PPPObsStream::count() const
+{
+    return m_count;
+}
@@ -0,0 +1,46 @@
+#ifndef PPPOBSSTREAM_H
+#define PPPOBSSTREAM_H
+
+#include "rtklib.h"
+#include <QByteArray>
+
+// 按历元读取RINEX 3观测文件
+// 每次读取一个历元，结果与readrnxt读取全部观测数据、sortobs排序后按历元取出的相同
+// （UTC转换、时间筛选、筛选掉的历元的周跳标志合并、历元内按卫星号排序并去除重复），
+// 内存占用与文件长度无关。文件中的历元应按时间顺序排列（RINEX的要求）。
+class PPPObsStream
+{
+public:
+    PPPObsStream();
+    ~PPPObsStream();
+
+    // 是否为可按历元读取的RINEX 3观测文件（未压缩）
+    static bool isStreamable(const char *file);
+
+    // 打开文件并读取文件头，sta为文件头中的测站信息，fcn为GLONASS频率号（nav_t::glo_fcn），可为空
+    bool open(const char *file, gtime_t ts, gtime_t te, double ti, const char *opt, sta_t *sta, int *fcn);
+    void close();
+
+    // 扫描全部历元行（不解码观测数据），得到筛选后第一个和最后一个历元的时间
+    bool scanSpan(gtime_t *first, gtime_t *last) const;
+
+    // 读取下一个历元到obs（至少MAXOBS个），返回观测数，0为文件结束
+    int next(obsd_t *obs);
+
+    // 已读取的观测记录数
+    int count() const;
+
+private:
+    QByteArray m_file;
+    FILE *m_fp;
+    rnxctr_t *m_rnx;
+    gtime_t m_ts;
+    gtime_t m_te;
+    double m_ti;
+    uint8_t m_slips[MAXSAT][NFREQ + NEXOBS];
+    int m_count;
+
+    Q_DISABLE_COPY(PPPObsStream)
+};
+
+#endif // PPPOBSSTREAM_H
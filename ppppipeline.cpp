@@ -0,0 +1,268 @@
+#include "ppppipeline.h"
+#include "pppengine.h"
+#include <QThread>
+
+// 预读的任务数：只读取下一个任务，内存中最多同时保留两个任务的输入
+static const int PREFETCH_JOBS = 1;
+
+PPPPipeline::PPPPipeline(QObject *parent)
+    : QObject(parent), m_reader(nullptr), m_solver(nullptr), m_cancelled(false), m_running(false),
+      m_processor(nullptr), m_readDone(false), m_readStats(), m_solveStats(), m_elapsed(0.0)
+{
+    // 任务结果从解算线程发出
+    qRegisterMetaType<PPPBatchResult>("PPPBatchResult");
+}
+
+PPPPipeline::~PPPPipeline()
+{
+    cancel();
+    wait();
+    delete m_reader;
+    delete m_solver;
+    qDeleteAll(m_queue);
+}
+
+void PPPPipeline::addJobs(const QList<ppp_paths_t> &jobs)
+{
+    m_jobs.append(jobs);
+}
+
+int PPPPipeline::jobCount() const
+{
+    return m_jobs.size();
+}
+
+bool PPPPipeline::isRunning() const
+{
+    return m_running;
+}
+
+const QVector<PPPBatchResult> &PPPPipeline::results() const
+{
+    return m_results;
+}
+
+PPPStageStats PPPPipeline::readStats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_readStats;
+}
+
+PPPStageStats PPPPipeline::solveStats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_solveStats;
+}
+
+double PPPPipeline::elapsedSeconds() const
+{
+    return m_running ? m_timer.elapsed() / 1000.0 : m_elapsed;
+}
+
+bool PPPPipeline::start()
+{
+    if (m_running || m_jobs.isEmpty()) {
+        return false;
+    }
+    wait();
+    delete m_reader;
+    delete m_solver;
+
+    m_results = QVector<PPPBatchResult>(m_jobs.size());
+    for (int i = 0; i < m_jobs.size(); i++) {
+        m_results[i] = PPPBatchResult{ QString::fromLocal8Bit(m_jobs[i].obs_file), false, false, -1, 0.0, QString() };
+    }
+    m_cancelled = false;
+    m_readDone = false;
+    m_readStats = PPPStageStats();
+    m_solveStats = PPPStageStats();
+    m_running = true;
+    m_timer.start();
+
+    m_reader = QThread::create([this]() { readLoop(); });
+    m_solver = QThread::create([this]() { solveLoop(); });
+    m_reader->start();
+    m_solver->start();
+    return true;
+}
+
+void PPPPipeline::cancel()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cancelled = true;
+    if (m_processor) {
+        m_processor->cancelProcessing();
+    }
+    m_queueChanged.wakeAll();
+}
+
+bool PPPPipeline::wait(unsigned long msecs)
+{
+    bool ok = true;
+    if (m_reader) ok = m_reader->wait(msecs) && ok;
+    if (m_solver) ok = m_solver->wait(msecs) && ok;
+    return ok;
+}
+
+void PPPPipeline::readLoop()
+{
+    for (int i = 0; i < m_jobs.size() && !m_cancelled; i++) {
+        // 等待解算线程取走上一个预读的任务
+        {
+            QMutexLocker lock(&m_mutex);
+            QElapsedTimer timer;
+            timer.start();
+            while (m_queue.size() >= PREFETCH_JOBS && !m_cancelled) {
+                m_queueChanged.wait(&m_mutex);
+            }
+            m_readStats.waitSeconds += timer.elapsed() / 1000.0;
+        }
+        if (m_cancelled) {
+            break;
+        }
+
+        Prefetched *item = new Prefetched;
+        item->index = i;
+        item->job = m_jobs[i];
+        if (item->job.soltype == SOLTYPE_FORWARD) {
+            QElapsedTimer timer;
+            timer.start();
+            item->inputs.reset(new PPPInputs);
+            item->inputs->setStreaming(item->job.stream);
+            bool loaded = PPPProcessor::loadInputs(&item->job, &item->prcopt, &item->solopt, item->inputs.get(),
+                                                   &item->error);
+            qint64 bytes = item->inputs->bytes();
+            if (!loaded) {
+                item->inputs.reset();
+            }
+
+            QMutexLocker lock(&m_mutex);
+            m_readStats.jobs++;
+            m_readStats.bytes += bytes;
+            m_readStats.busySeconds += timer.elapsed() / 1000.0;
+        } else {
+            filopt_t filopt;
+            PPPProcessor::checkInputFiles(&item->job);
+            PPPProcessor::initOptions(&item->job, &item->prcopt, &item->solopt, &filopt);
+        }
+
+        QMutexLocker lock(&m_mutex);
+        m_queue.enqueue(item);
+        m_queueChanged.wakeAll();
+    }
+
+    QMutexLocker lock(&m_mutex);
+    m_readDone = true;
+    m_queueChanged.wakeAll();
+}
+
+void PPPPipeline::solveLoop()
+{
+    while (true) {
+        Prefetched *next = nullptr;
+        {
+            QMutexLocker lock(&m_mutex);
+            QElapsedTimer timer;
+            timer.start();
+            while (m_queue.isEmpty() && !m_readDone) {
+                m_queueChanged.wait(&m_mutex);
+            }
+            m_solveStats.waitSeconds += timer.elapsed() / 1000.0;
+            if (m_queue.isEmpty()) {
+                break;
+            }
+            next = m_queue.dequeue();
+            m_queueChanged.wakeAll();
+        }
+        std::unique_ptr<Prefetched> item(next);
+        PPPBatchResult &result = m_results[item->index];
+        if (m_cancelled) {
+            result.message = "已取消";
+            emit jobFinished(item->index, result);
+            continue;
+        }
+
+        emit jobStarted(item->index, result.obsFile);
+        QElapsedTimer timer;
+        timer.start();
+        solve(item.get(), &result);
+        result.wallTime = timer.elapsed() / 1000.0;
+        {
+            QMutexLocker lock(&m_mutex);
+            m_solveStats.jobs++;
+            m_solveStats.busySeconds += result.wallTime;
+        }
+        emit jobFinished(item->index, result);
+    }
+
+    // 取消后读取线程可能留下未处理的任务
+    for (int i = 0; i < m_results.size(); i++) {
+        if (m_results[i].exitCode == -1 && m_results[i].message.isEmpty()) {
+            m_results[i].message = "已取消";
+        }
+    }
+    int succeeded = 0;
+    for (const PPPBatchResult &result : m_results) {
+        if (result.success) succeeded++;
+    }
+    m_elapsed = m_timer.elapsed() / 1000.0;
+    m_running = false;
+    emit finished(succeeded, m_results.size() - succeeded);
+}
+
+void PPPPipeline::solve(Prefetched *item, PPPBatchResult *result)
+{
+    if (item->inputs) {
+        std::unique_ptr<PPPEngine> engine(new PPPEngine);
+        engine->setCancelFlag(&m_cancelled);
+        PPPProcessor::setupEngine(&item->job, engine.get());
+        int ret = engine->process(item->inputs.get(), &item->solopt, item->job.out_file);
+        bool cacheHit = item->inputs->obsCacheHit();
+        item->inputs.reset(); // 尽早释放，下一个任务的输入正在读取
+
+        {
+            QMutexLocker lock(&m_mutex);
+            m_solveStats.epochs += engine->epochCount();
+        }
+        result->exitCode = ret;
+        result->success = ret == 0 && !m_cancelled;
+        if (result->success) {
+            result->message = QString("PPP处理成功完成！%1 个历元").arg(engine->epochCount());
+            QString report = PPPProcessor::engineReport(&item->job, *engine);
+            if (!report.isEmpty()) {
+                result->message += "，" + report;
+            }
+            if (cacheHit) {
+                result->message += "，观测数据由缓存读取";
+            }
+        } else if (m_cancelled) {
+            result->message = "PPP处理已取消";
+        } else {
+            result->message = QString("PPP处理失败，错误码: %1").arg(ret);
+        }
+        return;
+    }
+    if (!item->error.isEmpty()) {
+        result->message = item->error;
+        return;
+    }
+
+    // 非前向解算由postpos处理
+    PPPProcessor processor;
+    processor.setPaths(m_jobs[item->index]);
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_cancelled) {
+            result->message = "已取消";
+            return;
+        }
+        m_processor = &processor;
+    }
+    result->success = processor.execute();
+    {
+        QMutexLocker lock(&m_mutex);
+        m_processor = nullptr;
+    }
+    result->exitCode = result->success ? 0 : 1;
+    result->message = processor.getStatusMessage();
+}
@@ -0,0 +1,92 @@
+#ifndef PPPPIPELINE_H
+#define PPPPIPELINE_H
+
+#include "pppbatchengine.h"
+#include <QMutex>
+#include <QObject>
+#include <QQueue>
+#include <QWaitCondition>
+#include <atomic>
+#include <climits>
+#include <memory>
+
+class PPPInputs;
+class QThread;
+
+// 流水线中一个阶段的吞吐量统计
+struct PPPStageStats {
+    int jobs;              // 完成的任务数
+    double busySeconds;    // 工作时间 (s)
+    double waitSeconds;    // 等待另一阶段的时间 (s)
+    qint64 bytes;          // 读取的字节数（读取阶段）
+    qint64 epochs;         // 处理的历元数（解算阶段）
+};
+
+// 流水线批处理
+// 在单个进程中依次处理任务：I/O线程读取并解码下一个任务的观测、星历和产品文件，
+// 解算线程同时对当前任务进行滤波，磁盘读取与计算重叠。
+// 分别统计读取和解算两个阶段的工作和等待时间：解算阶段等待说明瓶颈在读取，反之在解算。
+// 非前向解算的任务不能由PPPEngine处理，在解算线程中使用PPPProcessor（postpos）处理，不预读。
+class PPPPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PPPPipeline(QObject *parent = nullptr);
+    ~PPPPipeline();
+
+    void addJobs(const QList<ppp_paths_t> &jobs);
+    int jobCount() const;
+
+    // 开始处理（异步，结果通过信号通知）
+    bool start();
+    void cancel();
+    bool isRunning() const;
+    bool wait(unsigned long msecs = ULONG_MAX);
+
+    const QVector<PPPBatchResult> &results() const;
+    PPPStageStats readStats() const;
+    PPPStageStats solveStats() const;
+    double elapsedSeconds() const;
+
+signals:
+    void jobStarted(int index, const QString &obsFile);
+    void jobFinished(int index, const PPPBatchResult &result);
+    void finished(int succeeded, int failed);
+
+private:
+    // 已读取、等待解算的任务
+    struct Prefetched {
+        int index;
+        ppp_paths_t job;
+        prcopt_t prcopt;
+        solopt_t solopt;
+        std::unique_ptr<PPPInputs> inputs; // 为空表示不预读（非前向解算）或读取失败
+        QString error;
+    };
+
+    void readLoop();
+    void solveLoop();
+    void solve(Prefetched *item, PPPBatchResult *result);
+
+    QList<ppp_paths_t> m_jobs;
+    QVector<PPPBatchResult> m_results;
+    QThread *m_reader;
+    QThread *m_solver;
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_running;
+    PPPProcessor *m_processor;      // 正在运行的postpos任务（受m_mutex保护）
+
+    // 两个阶段之间的任务队列
+    mutable QMutex m_mutex;
+    QWaitCondition m_queueChanged;
+    QQueue<Prefetched *> m_queue;
+    bool m_readDone;
+
+    PPPStageStats m_readStats;
+    PPPStageStats m_solveStats;
+    QElapsedTimer m_timer;
+    double m_elapsed;
+};
+
+#endif // PPPPIPELINE_H
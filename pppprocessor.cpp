@@ -1,49 +1,98 @@
 #include "pppprocessor.h"
+#include "pppdecompress.h"
+#include "pppengine.h"
+#include "pppjobfile.h"
+#include "ppptracer.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QDebug>
 #include <QString>
 #include <QDateTime>
+#include <QThread>
+#include <QCoreApplication>
+#include <memory>
+
+// 当前运行中的处理器。RTKLIB的回调是全局函数且postpos内部有全局状态，
+// 同一进程内同一时刻只允许一个任务运行
+static std::atomic<PPPProcessor*> s_activeProcessor{nullptr};
+
+// 历元处理在总进度中占用的区间
+static const int PROGRESS_EPOCH_BEGIN = 50;
+static const int PROGRESS_EPOCH_END = 95;
 
 PPPProcessor::PPPProcessor(QObject *parent)
-    : QObject(parent), m_isProcessing(false)
+    : QObject(parent), m_isProcessing(false), m_cancelRequested(false), m_worker(nullptr),
+      m_spanStart{0, 0.0}, m_spanEnd{0, 0.0}, m_lastPercent(-1)
 {
     // 初始化默认参数
-    memset(&m_paths, 0, sizeof(ppp_paths_t));
-    m_paths.mode = MODE_STATIC_PPP;
-    m_paths.trace_level = 3;
+    initPaths(&m_paths);
+    memset(&m_job, 0, sizeof(ppp_paths_t));
+}
+
+void PPPProcessor::initPaths(ppp_paths_t *paths)
+{
+    memset(paths, 0, sizeof(ppp_paths_t));
+    paths->mode = MODE_STATIC_PPP;
+    paths->trace_level = 3;
+    paths->tracefmt = TRACEFORMAT_BINARY;
     
     // 初始化新增的参数
     QDateTime current = QDateTime::currentDateTime();
     
     // 默认处理当天的数据
-    m_paths.ts[0] = current.date().year();
-    m_paths.ts[1] = current.date().month();
-    m_paths.ts[2] = current.date().day();
-    m_paths.ts[3] = 0;
-    m_paths.ts[4] = 0;
-    m_paths.ts[5] = 0;
+    paths->ts[0] = current.date().year();
+    paths->ts[1] = current.date().month();
+    paths->ts[2] = current.date().day();
+    paths->ts[3] = 0;
+    paths->ts[4] = 0;
+    paths->ts[5] = 0;
     
-    m_paths.te[0] = current.date().year();
-    m_paths.te[1] = current.date().month();
-    m_paths.te[2] = current.date().day();
-    m_paths.te[3] = 23;
-    m_paths.te[4] = 59;
-    m_paths.te[5] = 59;
+    paths->te[0] = current.date().year();
+    paths->te[1] = current.date().month();
+    paths->te[2] = current.date().day();
+    paths->te[3] = 23;
+    paths->te[4] = 59;
+    paths->te[5] = 59;
     
-    m_paths.ti = 0.0;            // 默认间隔为0，使用观测文件所有数据
-    m_paths.niter = 8;           // 默认最大迭代次数
-    m_paths.tropopt = TROP_ESTG; // 默认估计对流层延迟和梯度
-    m_paths.ionoopt = IONO_IFLC; // 默认电离层无关线性组合
-    m_paths.use_time_range = false; // 默认不使用时间范围，处理所有数据
-    m_paths.navsys = SYS_GPS | SYS_CMP; // 默认使用GPS和北斗
+    paths->ti = 0.0;            // 默认间隔为0，使用观测文件所有数据
+    paths->niter = 8;           // 默认最大迭代次数
+    paths->elmask = 15.0;       // 默认截止高度角，与RTKLIB默认值一致
+    paths->tropopt = TROP_ESTG; // 默认估计对流层延迟和梯度
+    paths->ionoopt = IONO_IFLC; // 默认电离层无关线性组合
+    paths->use_time_range = false; // 默认不使用时间范围，处理所有数据
+    paths->navsys = SYS_GPS | SYS_CMP; // 默认使用GPS和北斗
+    paths->soltype = SOLTYPE_FORWARD; // 默认前向解算
+    paths->solformat = SOLFORMAT_TEXT; // 默认输出.pos文本
+    paths->shards = 0;          // 默认不分片
+    paths->shard_overlap = 3600.0; // 默认重叠1小时用于收敛
+    paths->checkpoint = false;  // 默认不写检查点
+    paths->obs_cache[0] = '\0';  // 默认不缓存观测数据
+    paths->stream = false;      // 默认读取全部观测数据后处理
+    paths->station_db[0] = '\0'; // 默认不使用测站数据库
+    paths->early_stop = false;  // 默认处理全部历元
+    paths->stop_sigma = 0.01;   // 三维标准差小于1 cm
+    paths->stop_change = 0.005; // 坐标变化小于5 mm
+    paths->stop_window = 3600.0; // 保持1小时
+}
+
+void PPPProcessor::setPaths(const ppp_paths_t &paths)
+{
+    m_paths = paths;
+}
+
+const ppp_paths_t &PPPProcessor::paths() const
+{
+    return m_paths;
 }
 
 PPPProcessor::~PPPProcessor()
 {
-    // 确保处理结束时关闭日志
-    if (m_isProcessing) {
-        traceclose();
+    // 取消仍在运行的任务并等待工作线程退出（日志由任务自行关闭）
+    if (m_worker) {
+        cancelProcessing();
+        m_worker->wait();
+        delete m_worker;
+        m_worker = nullptr;
     }
 }
 
@@ -151,11 +200,52 @@ void PPPProcessor::setNavSys(int navsys)
     m_paths.navsys = navsys;
 }
 
+void PPPProcessor::setSolutionType(sol_type_t type)
+{
+    m_paths.soltype = type;
+}
+
+void PPPProcessor::initSolutionOptions(const ppp_paths_t *paths, solopt_t *solopt)
+{
+    *solopt = solopt_default;
+    solopt->outopt = 1;                // 输出位置结果
+    solopt->outhead = 1;               // 输出头信息
+    solopt->outvel = 0;                // 不输出速度
+    solopt->sstat = SOLF_STAT;         // 输出状态
+    solopt->trace = paths->trace_level; // 跟踪级别
+    strcpy(solopt->sep, " ");          // 分隔符为空格
+}
+
 QString PPPProcessor::getStatusMessage() const
 {
     return m_statusMessage;
 }
 
+bool PPPProcessor::isProcessing() const
+{
+    return m_isProcessing;
+}
+
+bool PPPProcessor::wasCancelled() const
+{
+    return m_cancelRequested;
+}
+
+const PPPSolutionStore &PPPProcessor::solutions() const
+{
+    return m_solutions;
+}
+
+const PPPResidualStore &PPPProcessor::residuals() const
+{
+    return m_residuals;
+}
+
+QString PPPProcessor::traceFile() const
+{
+    return m_traceFile;
+}
+
 bool PPPProcessor::startProcessing()
 {
     if (m_isProcessing) {
@@ -163,52 +253,132 @@ bool PPPProcessor::startProcessing()
         return false;
     }
 
+    // 回收上一次任务的线程
+    if (m_worker) {
+        m_worker->wait();
+        delete m_worker;
+        m_worker = nullptr;
+    }
+
+    m_isProcessing = true;
+    m_cancelRequested = false;
+    m_job = m_paths;
+
+    m_worker = QThread::create([this]() { processJob(); });
+    m_worker->start();
+    return true;
+}
+
+bool PPPProcessor::execute()
+{
+    if (m_isProcessing) {
+        m_statusMessage = "已有处理任务正在运行";
+        return false;
+    }
+
     m_isProcessing = true;
+    m_cancelRequested = false;
+    m_job = m_paths;
+    return processJob();
+}
+
+void PPPProcessor::cancelProcessing()
+{
+    if (m_isProcessing) {
+        m_cancelRequested = true;
+    }
+}
+
+bool PPPProcessor::waitForFinished(unsigned long msecs)
+{
+    return m_worker ? m_worker->wait(msecs) : true;
+}
+
+bool PPPProcessor::processJob()
+{
     emit processingStarted();
     
     m_statusMessage = "开始PPP处理...";
     emit processingProgress(0, m_statusMessage);
     
-    // 初始化日志
-    QString logFile = QString("ppp_log_%1.txt").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
-    QByteArray baLogFile = logFile.toLocal8Bit();
-    traceopen(baLogFile.constData());
-    tracelevel(m_paths.trace_level);
+    // 初始化日志（日志级别为0时不生成日志文件）
+    m_traceFile.clear();
+    if (m_job.trace_level > 0) {
+        // 文件名包含进程号，避免批处理中并行的工作进程写同一个日志
+        QString logFile = QString("ppp_log_%1_%2").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"))
+                                                  .arg(QCoreApplication::applicationPid());
+        QByteArray baLogFile = (logFile + ".txt").toLocal8Bit();
+        if (m_job.tracefmt == TRACEFORMAT_BINARY) {
+            // RTKLIB的跟踪输出经管道进入环形缓冲区，由后台线程写出，失败时仍直接写文本
+            QString error;
+            m_tracer.reset(new PPPTracer);
+            if (m_tracer->start(logFile + ".trc", &error)) {
+                baLogFile = m_tracer->pipePath();
+                logFile += ".trc";
+            } else {
+                emit processingProgress(0, QString("无法创建二进制日志，改为文本日志: %1").arg(error));
+                m_tracer.reset();
+                logFile += ".txt";
+            }
+        } else {
+            logFile += ".txt";
+        }
+        m_traceFile = logFile;
+        traceopen(baLogFile.constData());
+        tracelevel(m_job.trace_level);
+    }
     
     // 设置精密星历和钟差文件
-    setupPreciseFiles();
+    setupPreciseFiles(&m_job);
     
     // 设置PPP选项
     prcopt_t prcopt;
     solopt_t solopt;
     filopt_t filopt;
-    setPPPOptions(&prcopt, &solopt, &filopt);
+    setPPPOptions(&m_job, &prcopt, &solopt, &filopt);
     
-    // 执行PPP处理
+    // 执行PPP处理，期间RTKLIB回调转发到本对象
     emit processingProgress(20, "正在执行PPP计算...");
-    int ret = runPPP(&prcopt, &solopt, &filopt);
+    m_spanStart = m_spanEnd = gtime_t{0, 0.0};
+    m_lastPercent = -1;
+    m_engineReport.clear();
+    m_solutions.clear();
+    m_residuals.clear();
+    s_activeProcessor = this;
+    int ret = runPPP(&m_job, &prcopt, &solopt, &filopt);
+    s_activeProcessor = nullptr;
     
     // 关闭日志
-    traceclose();
+    if (m_job.trace_level > 0) {
+        traceclose();
+    }
+    if (m_tracer) {
+        m_tracer->stop();
+        emit processingProgress(PROGRESS_EPOCH_END, QString("日志 %1：%2 条，丢弃 %3 条，%4 MB（文本 %5 MB）")
+                                .arg(m_traceFile).arg(m_tracer->entries()).arg(m_tracer->dropped())
+                                .arg(m_tracer->fileBytes() / 1048576.0, 0, 'f', 1)
+                                .arg(m_tracer->textBytes() / 1048576.0, 0, 'f', 1));
+        m_tracer.reset();
+    }
     
-    m_isProcessing = false;
-    bool success = (ret == 0);
+    bool success = (ret == 0 && !m_cancelRequested);
     if (success) {
-        m_statusMessage = "PPP处理成功完成！";
+        m_statusMessage = "PPP处理成功完成！" + m_engineReport;
+    } else if (m_cancelRequested) {
+        m_statusMessage = "PPP处理已取消";
     } else {
         m_statusMessage = QString("PPP处理失败，错误码: %1").arg(ret);
     }
     
+    m_isProcessing = false;
     emit processingProgress(100, m_statusMessage);
     emit processingFinished(success);
     
     return success;
 }
 
-void PPPProcessor::setupPreciseFiles()
+void PPPProcessor::checkInputFiles(ppp_paths_t *paths)
 {
-    emit processingProgress(5, "检查文件有效性...");
-    
     // 检查文件是否存在
     auto checkFile = [](const char* filepath, const char* fileType) -> bool {
         if (filepath[0]) {
@@ -224,180 +394,206 @@ void PPPProcessor::setupPreciseFiles()
     };
     
     // 检查SP3文件
-    if (!checkFile(m_paths.sp3_file, "精密星历")) {
-        m_paths.sp3_file[0] = '\0';
+    if (!checkFile(paths->sp3_file, "精密星历")) {
+        paths->sp3_file[0] = '\0';
     }
     
     // 检查CLK文件
-    if (!checkFile(m_paths.clk_file, "精密钟差")) {
-        m_paths.clk_file[0] = '\0';
+    if (!checkFile(paths->clk_file, "精密钟差")) {
+        paths->clk_file[0] = '\0';
     }
     
     // 检查NAV文件
-    if (!checkFile(m_paths.nav_file, "导航")) {
-        m_paths.nav_file[0] = '\0';
+    if (!checkFile(paths->nav_file, "导航")) {
+        paths->nav_file[0] = '\0';
     }
     
     // 检查其他文件
-    checkFile(m_paths.obs_file, "观测");
-    checkFile(m_paths.atx_file, "天线相位中心");
-    checkFile(m_paths.dcb_file, "DCB");
-    checkFile(m_paths.erp_file, "地球自转参数");
-    
+    checkFile(paths->obs_file, "观测");
+    checkFile(paths->atx_file, "天线相位中心");
+    checkFile(paths->dcb_file, "DCB");
+    checkFile(paths->erp_file, "地球自转参数");
+}
+
+void PPPProcessor::setupPreciseFiles(ppp_paths_t *paths)
+{
+    emit processingProgress(5, "检查文件有效性...");
+    checkInputFiles(paths);
     emit processingProgress(10, "文件检查完成");
 }
 
-void PPPProcessor::setPPPOptions(prcopt_t *prcopt, solopt_t *solopt, filopt_t *filopt)
+void PPPProcessor::initOptions(const ppp_paths_t *paths, prcopt_t *prcopt, solopt_t *solopt, filopt_t *filopt)
 {
-    emit processingProgress(15, "配置PPP选项...");
-    
     // 初始化为默认值
     *prcopt = prcopt_default;
-    *solopt = solopt_default;
     memset(filopt, 0, sizeof(filopt_t));
 
     // 根据运行模式设置PPP模式
-    if (m_paths.mode == MODE_STATIC_PPP) {
-        prcopt->mode = PMODE_PPP_STATIC;
-        emit processingProgress(16, "处理模式: 静态PPP");
-    } else {
-        prcopt->mode = PMODE_PPP_KINEMA;
-        emit processingProgress(16, "处理模式: 动态PPP");
-    }
+    prcopt->mode = paths->mode == MODE_STATIC_PPP ? PMODE_PPP_STATIC : PMODE_PPP_KINEMA;
 
     // 基本PPP设置
-    prcopt->soltype = 0;               // 前向解算
-    prcopt->niter = m_paths.niter;     // 最大迭代次数
-    emit processingProgress(17, QString("最大迭代次数: %1").arg(m_paths.niter));
+    // 进程内的组合解由RTKLIB先后执行前向和后向滤波；ppp_cli使用PPPCombinedRunner并行执行两个方向
+    prcopt->soltype = paths->soltype;  // 解算方向
+    prcopt->niter = paths->niter;      // 最大迭代次数
+    prcopt->elmin = paths->elmask * D2R; // 截止高度角
     
     // 设置对流层延迟模型
-    QString tropModelStr;
-    switch(m_paths.tropopt) {
-        case TROP_OFF:
-            prcopt->tropopt = TROPOPT_OFF;
-            tropModelStr = "关闭";
-            break;
-        case TROP_SAAS:
-            prcopt->tropopt = TROPOPT_SAAS;
-            tropModelStr = "Saastamoinen模型";
-            break;
-        case TROP_SBAS:
-            prcopt->tropopt = TROPOPT_SBAS;
-            tropModelStr = "SBAS模型";
-            break;
-        case TROP_EST:
-            prcopt->tropopt = TROPOPT_EST;
-            tropModelStr = "估计ZTD";
-            break;
+    switch(paths->tropopt) {
+        case TROP_OFF:  prcopt->tropopt = TROPOPT_OFF;  break;
+        case TROP_SAAS: prcopt->tropopt = TROPOPT_SAAS; break;
+        case TROP_SBAS: prcopt->tropopt = TROPOPT_SBAS; break;
+        case TROP_EST:  prcopt->tropopt = TROPOPT_EST;  break;
         case TROP_ESTG:
-        default:
-            prcopt->tropopt = TROPOPT_ESTG;
-            tropModelStr = "估计ZTD+梯度";
-            break;
+        default:        prcopt->tropopt = TROPOPT_ESTG; break;
     }
-    emit processingProgress(18, QString("对流层模型: %1").arg(tropModelStr));
     
     // 设置电离层延迟模型
-    QString ionoModelStr;
-    switch(m_paths.ionoopt) {
-        case IONO_OFF:
-            prcopt->ionoopt = IONOOPT_OFF;
-            ionoModelStr = "关闭";
-            break;
-        case IONO_BRDC:
-            prcopt->ionoopt = IONOOPT_BRDC;
-            ionoModelStr = "广播模型";
-            break;
-        case IONO_SBAS:
-            prcopt->ionoopt = IONOOPT_SBAS;
-            ionoModelStr = "SBAS模型";
-            break;
+    switch(paths->ionoopt) {
+        case IONO_OFF:  prcopt->ionoopt = IONOOPT_OFF;  break;
+        case IONO_BRDC: prcopt->ionoopt = IONOOPT_BRDC; break;
+        case IONO_SBAS: prcopt->ionoopt = IONOOPT_SBAS; break;
+        case IONO_EST:  prcopt->ionoopt = IONOOPT_EST;  break;
+        case IONO_TEC:  prcopt->ionoopt = IONOOPT_TEC;  break;
         case IONO_IFLC:
-            prcopt->ionoopt = IONOOPT_IFLC;
-            ionoModelStr = "无电离层组合";
-            break;
-        case IONO_EST:
-            prcopt->ionoopt = IONOOPT_EST;
-            ionoModelStr = "估计STEC";
-            break;
-        case IONO_TEC:
-            prcopt->ionoopt = IONOOPT_TEC;
-            ionoModelStr = "TEC模型";
-            break;
-        default:
-            prcopt->ionoopt = IONOOPT_IFLC;
-            ionoModelStr = "无电离层组合";
-            break;
-    }
-    emit processingProgress(19, QString("电离层模型: %1").arg(ionoModelStr));
+        default:        prcopt->ionoopt = IONOOPT_IFLC; break;
+    }
     
-    prcopt->dynamics = (m_paths.mode == MODE_STATIC_PPP) ? 0 : 1; // 根据模式设置动力学
+    prcopt->dynamics = (paths->mode == MODE_STATIC_PPP) ? 0 : 1; // 根据模式设置动力学
     prcopt->tidecorr = 2;              // 潮汐改正
     prcopt->modear = 3;                // 固定和保持模糊度
-    prcopt->navsys = m_paths.navsys;   // 使用用户选择的卫星系统
+    prcopt->navsys = paths->navsys;    // 使用用户选择的卫星系统
     prcopt->posopt[4] = 1;             // 相位偏心改正
     prcopt->posopt[5] = 1;             // 相位缠绕改正
     prcopt->sateph = EPHOPT_PREC;      // 精密星历
     
     // 设置文件选项
-    if (m_paths.atx_file[0]) strcpy(filopt->rcvantp, m_paths.atx_file);
-    if (m_paths.dcb_file[0]) strcpy(filopt->dcb, m_paths.dcb_file);
-    if (m_paths.erp_file[0]) strcpy(filopt->eop, m_paths.erp_file);
+    if (paths->atx_file[0]) strcpy(filopt->rcvantp, paths->atx_file);
+    if (paths->dcb_file[0]) strcpy(filopt->dcb, paths->dcb_file);
+    if (paths->erp_file[0]) strcpy(filopt->eop, paths->erp_file);
     
-    // 解算结果输出选项    
-    solopt->outopt = 1;                // 输出位置结果
-    solopt->outhead = 1;               // 输出头信息
-    solopt->outvel = 0;                // 不输出速度
-    solopt->sstat = SOLF_STAT;         // 输出状态
-    solopt->trace = m_paths.trace_level;// 跟踪级别
-    strcpy(solopt->sep, " ");          // 分隔符为空格
+    // 解算结果输出选项
+    initSolutionOptions(paths, solopt);
+}
+
+int PPPProcessor::inputFiles(const ppp_paths_t *paths, char **infiles)
+{
+    int n = 0;
+    if (paths->obs_file[0]) infiles[n++] = (char*)paths->obs_file;
+    if (paths->nav_file[0]) infiles[n++] = (char*)paths->nav_file;
+    if (paths->sp3_file[0]) infiles[n++] = (char*)paths->sp3_file;
+    if (paths->clk_file[0]) infiles[n++] = (char*)paths->clk_file;
+    return n;
+}
+
+bool PPPProcessor::loadInputs(ppp_paths_t *paths, prcopt_t *prcopt, solopt_t *solopt, PPPInputs *inputs,
+                              QString *error)
+{
+    filopt_t filopt;
+    checkInputFiles(paths);
+    initOptions(paths, prcopt, solopt, &filopt);
+
+    // 压缩文件在读取期间由进程内解码器通过管道提供
+    ppp_paths_t files = *paths;
+    PPPDecompressor decompressor;
+    char *infiles[8] = { 0 };
+    QString message;
+    int n = decompressor.prepare(&files, &filopt, &message) ? inputFiles(&files, infiles) : 0;
+    if (!message.isEmpty()) {
+        *error = QString("错误：%1").arg(message);
+        return false;
+    }
+    if (n < 2) {
+        *error = "错误：需要至少一个观测文件和导航/精密星历文件！";
+        return false;
+    }
+    gtime_t ts = { 0 }, te = { 0 };
+    if (paths->use_time_range) {
+        ts = epoch2time(paths->ts);
+        te = epoch2time(paths->te);
+    }
+    inputs->setObsCache(QString::fromLocal8Bit(paths->obs_cache));
+    if (!inputs->load(ts, te, paths->ti, prcopt, &filopt, infiles, n)) {
+        *error = inputs->error();
+        return false;
+    }
+    if (!decompressor.errors().isEmpty()) {
+        *error = QString("解压失败: %1").arg(decompressor.errors().join("; "));
+        return false;
+    }
+    return true;
+}
+
+void PPPProcessor::setPPPOptions(const ppp_paths_t *paths, prcopt_t *prcopt, solopt_t *solopt, filopt_t *filopt)
+{
+    static const char *const TROP_MODEL_NAMES[] = { "关闭", "Saastamoinen模型", "SBAS模型", "估计ZTD", "估计ZTD+梯度" };
+    static const char *const IONO_MODEL_NAMES[] = { "关闭", "广播模型", "SBAS模型", "无电离层组合", "估计STEC", "TEC模型" };
+    
+    emit processingProgress(15, "配置PPP选项...");
+    initOptions(paths, prcopt, solopt, filopt);
+    
+    emit processingProgress(16, paths->mode == MODE_STATIC_PPP ? "处理模式: 静态PPP" : "处理模式: 动态PPP");
+    emit processingProgress(17, QString("最大迭代次数: %1").arg(paths->niter));
+    emit processingProgress(18, QString("对流层模型: %1").arg(TROP_MODEL_NAMES[prcopt->tropopt]));
+    emit processingProgress(19, QString("电离层模型: %1").arg(IONO_MODEL_NAMES[prcopt->ionoopt]));
 }
 
-int PPPProcessor::runPPP(const prcopt_t *prcopt, const solopt_t *solopt, const filopt_t *filopt)
+int PPPProcessor::runPPP(const ppp_paths_t *paths, const prcopt_t *prcopt, const solopt_t *solopt, const filopt_t *filopt)
 {
     char* infiles[8] = { 0 }; // 最多8个输入文件
     int n = 0, ret;
     
     // 设置处理时间
     gtime_t ts = { 0 }, te = { 0 };
-    if (m_paths.use_time_range) {
+    if (paths->use_time_range) {
         // 使用用户设定的时间范围
-        ts = epoch2time(m_paths.ts);
-        te = epoch2time(m_paths.te);
+        ts = epoch2time(paths->ts);
+        te = epoch2time(paths->te);
+        onRtkTimeSpan(ts, te); // RTKLIB只在未指定时间范围时调用settspan
         emit processingProgress(20, QString("使用设定的时间范围: %1 - %2")
-                              .arg(QDateTime(QDate(int(m_paths.ts[0]), int(m_paths.ts[1]), int(m_paths.ts[2])), 
-                                    QTime(int(m_paths.ts[3]), int(m_paths.ts[4]), int(m_paths.ts[5]))).toString("yyyy-MM-dd hh:mm:ss"))
-                              .arg(QDateTime(QDate(int(m_paths.te[0]), int(m_paths.te[1]), int(m_paths.te[2])), 
-                                    QTime(int(m_paths.te[3]), int(m_paths.te[4]), int(m_paths.te[5]))).toString("yyyy-MM-dd hh:mm:ss")));
+                              .arg(QDateTime(QDate(int(paths->ts[0]), int(paths->ts[1]), int(paths->ts[2])), 
+                                    QTime(int(paths->ts[3]), int(paths->ts[4]), int(paths->ts[5]))).toString("yyyy-MM-dd hh:mm:ss"))
+                              .arg(QDateTime(QDate(int(paths->te[0]), int(paths->te[1]), int(paths->te[2])), 
+                                    QTime(int(paths->te[3]), int(paths->te[4]), int(paths->te[5]))).toString("yyyy-MM-dd hh:mm:ss")));
     } else {
         
         // 默认使用观测文件的全部时间范围
         emit processingProgress(20, "使用观测文件的全部时间范围");
     }
-    double ti = m_paths.ti; // 处理间隔
+    double ti = paths->ti; // 处理间隔
     if (ti > 0.0) {
         emit processingProgress(22, QString("处理间隔: %.1f 秒").arg(ti));
     }
 
+    // 压缩文件（.gz/.Z/Hatanaka）由进程内解码器解压，RTKLIB从管道读取解压后的数据
+    ppp_paths_t job = *paths;
+    filopt_t fopt = *filopt;
+    PPPDecompressor decompressor;
+    QString error;
+    if (!decompressor.prepare(&job, &fopt, &error)) {
+        m_statusMessage = QString("错误：%1").arg(error);
+        emit processingProgress(24, m_statusMessage);
+        return -1;
+    }
+    for (const QString &file : decompressor.files()) {
+        emit processingProgress(24, QString("进程内解压: %1").arg(file));
+    }
+
     // 添加输入文件
-    if (m_paths.obs_file[0]) {
-        infiles[n++] = (char*)m_paths.obs_file;
-        emit processingProgress(25, QString("添加观测文件: %1").arg(m_paths.obs_file));
+    n = inputFiles(&job, infiles);
+    if (paths->obs_file[0]) {
+        emit processingProgress(25, QString("添加观测文件: %1").arg(paths->obs_file));
     }
 
-    if (m_paths.nav_file[0]) {
-        infiles[n++] = (char*)m_paths.nav_file;
-        emit processingProgress(30, QString("添加导航文件: %1").arg(m_paths.nav_file));
+    if (paths->nav_file[0]) {
+        emit processingProgress(30, QString("添加导航文件: %1").arg(paths->nav_file));
     }
 
-    if (m_paths.sp3_file[0]) {
-        infiles[n++] = (char*)m_paths.sp3_file;
-        emit processingProgress(35, QString("添加精密星历文件: %1").arg(m_paths.sp3_file));
+    if (paths->sp3_file[0]) {
+        emit processingProgress(35, QString("添加精密星历文件: %1").arg(paths->sp3_file));
     }
 
-    if (m_paths.clk_file[0]) {
-        infiles[n++] = (char*)m_paths.clk_file;
-        emit processingProgress(40, QString("添加精密钟差文件: %1").arg(m_paths.clk_file));
+    if (paths->clk_file[0]) {
+        emit processingProgress(40, QString("添加精密钟差文件: %1").arg(paths->clk_file));
     }    // 确保至少有观测文件和导航/精密星历文件
     if (n < 2) {
         m_statusMessage = "错误：需要至少一个观测文件和导航/精密星历文件！";
@@ -407,37 +603,199 @@ int PPPProcessor::runPPP(const prcopt_t *prcopt, const solopt_t *solopt, const f
     
     // 记录使用的卫星系统
     QStringList systems;
-    if (m_paths.navsys & SYS_GPS) systems << "GPS";
-    if (m_paths.navsys & SYS_GLO) systems << "GLONASS";
-    if (m_paths.navsys & SYS_GAL) systems << "Galileo";
-    if (m_paths.navsys & SYS_CMP) systems << "BeiDou";    if (m_paths.navsys & SYS_QZS) systems << "QZSS";
-    if (m_paths.navsys & SYS_IRN) systems << "IRNSS";
-    if (m_paths.navsys & SYS_SBS) systems << "SBAS";
+    if (paths->navsys & SYS_GPS) systems << "GPS";
+    if (paths->navsys & SYS_GLO) systems << "GLONASS";
+    if (paths->navsys & SYS_GAL) systems << "Galileo";
+    if (paths->navsys & SYS_CMP) systems << "BeiDou";    if (paths->navsys & SYS_QZS) systems << "QZSS";
+    if (paths->navsys & SYS_IRN) systems << "IRNSS";
+    if (paths->navsys & SYS_SBS) systems << "SBAS";
     emit processingProgress(45, QString("使用的卫星系统: %1").arg(systems.join(", ")));
 
-    emit processingProgress(50, "开始PPP计算...");
-
-    qDebug() << "ts:" << ts.time;
-    qDebug() << "te:" << te.time;
-    qDebug() << "ti:" << ti;
-    qDebug() << "out_file:" << m_paths.out_file;
-    //打印全部参数
-    qDebug() << "prcopt:" << prcopt->mode << prcopt->tropopt << prcopt->ionoopt << prcopt->dynamics;
-    qDebug() << "solopt:" << solopt->outopt << solopt->outhead << solopt->outvel;
-    qDebug() << "filopt:" << filopt->rcvantp << filopt->dcb << filopt->eop;
-    qDebug() << "infiles:" << infiles[0] << infiles[1] << infiles[2] << infiles[3];
-    qDebug() << "n:" << n;
-    
-    
+    emit processingProgress(PROGRESS_EPOCH_BEGIN, "开始PPP计算...");
+
     // 执行后处理
-    ret = postpos(ts, te, ti, 0.0, prcopt, solopt, filopt, infiles, n, 
-                 (char*)m_paths.out_file, (char*)"", (char*)"");
+    if (useEngine(paths)) {
+        // PPPEngine持有滤波器状态（检查点、热启动和提前结束），按postpos的流程处理
+        // 解算结果同时保存在内存中，界面不必重新读取结果文件；未指定输出文件时只保存在内存中
+        std::unique_ptr<PPPEngine> engine(new PPPEngine);
+        if (paths->checkpoint && paths->out_file[0] && QFile::exists(QString::fromLocal8Bit(paths->out_file) + ".ckpt")) {
+            emit processingProgress(PROGRESS_EPOCH_BEGIN, "发现检查点，尝试从检查点恢复处理");
+        }
+        setupEngine(paths, engine.get());
+        engine->setSolutionStore(&m_solutions);
+        engine->setResidualStore(&m_residuals);
+        engine->setTracer(m_tracer.get());
+        ret = engine->run(ts, te, ti, prcopt, solopt, &fopt, infiles, n, paths->out_file[0] ? paths->out_file : nullptr);
+        if (engine->resumed()) {
+            m_solutions.clear(); // 检查点之前的结果只在结果文件中
+            m_residuals.clear();
+        }
+        if (paths->checkpoint && paths->soltype == SOLTYPE_FORWARD) {
+            emit processingProgress(PROGRESS_EPOCH_END, QString("%1检查点 %2 次，耗时 %3 s")
+                                  .arg(engine->resumed() ? "已从检查点恢复，" : "")
+                                  .arg(engine->checkpointCount()).arg(engine->checkpointSeconds(), 0, 'f', 2));
+        }
+        if (ret == 0) {
+            m_engineReport = engineReport(paths, *engine);
+            if (!m_engineReport.isEmpty()) {
+                emit processingProgress(PROGRESS_EPOCH_END, m_engineReport);
+            }
+            if (!m_residuals.isEmpty()) {
+                emit processingProgress(PROGRESS_EPOCH_END, rejectReport(m_residuals));
+            }
+        }
+    } else if (!paths->out_file[0]) {
+        m_statusMessage = "错误：未指定输出文件！";
+        emit processingProgress(PROGRESS_EPOCH_BEGIN, m_statusMessage);
+        ret = -1;
+    } else if (paths->solformat != SOLFORMAT_TEXT) {
+        m_statusMessage = "错误：二进制结果文件只支持前向或后向解算！";
+        emit processingProgress(PROGRESS_EPOCH_BEGIN, m_statusMessage);
+        ret = -1;
+    } else {
+        ret = postpos(ts, te, ti, 0.0, prcopt, solopt, &fopt, infiles, n, 
+                     (char*)paths->out_file, (char*)"", (char*)"");
+    }
+    QStringList errors = decompressor.errors();
+    if (!errors.isEmpty()) {
+        emit processingProgress(PROGRESS_EPOCH_END, QString("解压失败: %1").arg(errors.join("; ")));
+        if (ret == 0) ret = -1;
+    }
 
-    if (ret == 0) {
-        emit processingProgress(90, "PPP处理成功完成");
+    if (m_cancelRequested) {
+        emit processingProgress(PROGRESS_EPOCH_END, "PPP处理已被用户取消");
+    } else if (ret == 0) {
+        emit processingProgress(PROGRESS_EPOCH_END, "PPP处理成功完成");
     } else {
-        emit processingProgress(90, QString("PPP处理失败，错误码: %1").arg(ret));
+        emit processingProgress(PROGRESS_EPOCH_END, QString("PPP处理失败，错误码: %1").arg(ret));
     }
 
     return ret;
 }
+
+bool PPPProcessor::useEngine(const ppp_paths_t *paths)
+{
+    // 前向解算在界面和ppp_cli中都由PPPEngine处理，输出与postpos相同，
+    // 精密产品由产品缓存共享，解算结果和残差同时保存在内存中。
+    // 二进制结果只能由PPPEngine写出，后向解算也由引擎处理（组合解的单向处理）；
+    // 文本格式的后向解算和组合解仍由postpos处理
+    if (paths->solformat != SOLFORMAT_TEXT) {
+        return paths->soltype != SOLTYPE_COMBINED;
+    }
+    return paths->soltype == SOLTYPE_FORWARD;
+}
+
+void PPPProcessor::setupEngine(const ppp_paths_t *paths, PPPEngine *engine)
+{
+    engine->setObsCache(QString::fromLocal8Bit(paths->obs_cache));
+    engine->setBinaryOutput(paths->solformat != SOLFORMAT_TEXT, paths->solformat == SOLFORMAT_BINARY);
+    if (paths->soltype != SOLTYPE_FORWARD) {
+        return; // 以下功能只用于前向解算
+    }
+    if (paths->checkpoint && paths->out_file[0]) {
+        engine->setCheckpoint(QString::fromLocal8Bit(paths->out_file) + ".ckpt", PPPJobFile::jobId(*paths));
+    }
+    engine->setStreaming(paths->stream);
+    engine->setStationDatabase(QString::fromLocal8Bit(paths->station_db));
+    if (paths->early_stop) {
+        engine->setEarlyStop(paths->stop_sigma, paths->stop_change, paths->stop_window);
+    }
+}
+
+QString PPPProcessor::engineReport(const ppp_paths_t *paths, const PPPEngine &engine)
+{
+    auto seconds = [](double t) { return t < 0.0 ? QString("未知") : QString("%1 s").arg(t, 0, 'f', 0); };
+    QStringList parts;
+    if (paths->station_db[0]) {
+        QString converged = engine.convergenceSeconds() < 0.0 ? QString("未收敛") : seconds(engine.convergenceSeconds());
+        QString report = QString("测站 %1 %2，收敛时间 %3")
+                             .arg(engine.stationName(), engine.warmStarted() ? "热启动" : "冷启动", converged);
+        if (engine.warmStarted()) {
+            report += QString("（冷启动 %1）").arg(seconds(engine.coldConvergenceSeconds()));
+        }
+        parts << report;
+    }
+    if (engine.stoppedEarly()) {
+        parts << QString("已收敛，提前结束，跳过 %1 h 的观测").arg(engine.skippedSeconds() / 3600.0, 0, 'f', 1);
+    }
+    return parts.join("，");
+}
+
+QString PPPProcessor::rejectReport(const PPPResidualStore &residuals)
+{
+    static const struct {
+        int sys;
+        const char *name;
+    } systems[] = { { SYS_GPS, "GPS" }, { SYS_GLO, "GLONASS" }, { SYS_GAL, "Galileo" }, { SYS_CMP, "BeiDou" },
+                    { SYS_QZS, "QZSS" }, { SYS_IRN, "IRNSS" }, { SYS_SBS, "SBAS" } };
+    gtime_t all = { 0 };
+    QStringList parts;
+    for (const auto &system : systems) {
+        int n = residuals.rejects(system.sys, all, all);
+        if (n > 0) parts << QString("%1 %2").arg(system.name).arg(n);
+    }
+    return QString("残差记录 %1 条，拒绝次数：%2").arg(residuals.size()).arg(parts.isEmpty() ? QString("无") : parts.join("，"));
+}
+
+bool PPPProcessor::onRtkMessage(const char *message)
+{
+    // postpos每个历元都会调用showmsg("processing : ...")检查中断，
+    // 这类消息只用于取消检测，进度由settime给出
+    if (message[0] && strncmp(message, "processing", 10) != 0) {
+        emit processingProgress(qMax(m_lastPercent, PROGRESS_EPOCH_BEGIN), QString::fromLocal8Bit(message));
+    }
+    return m_cancelRequested;
+}
+
+void PPPProcessor::onRtkTimeSpan(gtime_t ts, gtime_t te)
+{
+    m_spanStart = ts;
+    m_spanEnd = te;
+}
+
+void PPPProcessor::onRtkTime(gtime_t time)
+{
+    double span = timediff(m_spanEnd, m_spanStart);
+    if (m_spanStart.time == 0 || span <= 0.0) {
+        return;
+    }
+    double ratio = qBound(0.0, timediff(time, m_spanStart) / span, 1.0);
+    int percent = PROGRESS_EPOCH_BEGIN + int(ratio * (PROGRESS_EPOCH_END - PROGRESS_EPOCH_BEGIN));
+    
+    // 只在百分比变化时发送信号，避免逐历元刷新界面
+    if (percent != m_lastPercent) {
+        m_lastPercent = percent;
+        emit processingProgress(percent, QString("正在处理历元: %1").arg(time_str(time, 0)));
+    }
+}
+
+// RTKLIB要求应用程序提供的回调函数，RTKLIB库已自带时不定义（见CMakeLists.txt中的检查）
+#ifdef PPP_RTKLIB_CALLBACKS
+extern "C" int showmsg(const char *format, ...)
+{
+    PPPProcessor *processor = s_activeProcessor;
+    if (!processor) {
+        return 0;
+    }
+    char buff[1024];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(buff, sizeof(buff), format, ap);
+    va_end(ap);
+    return processor->onRtkMessage(buff) ? 1 : 0;
+}
+
+extern "C" void settspan(gtime_t ts, gtime_t te)
+{
+    if (PPPProcessor *processor = s_activeProcessor) {
+        processor->onRtkTimeSpan(ts, te);
+    }
+}
+
+extern "C" void settime(gtime_t time)
+{
+    if (PPPProcessor *processor = s_activeProcessor) {
+        processor->onRtkTime(time);
+    }
+}
+#endif
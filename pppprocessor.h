@@ -1,9 +1,19 @@
 #ifndef PPPPROCESSOR_H
 #define PPPPROCESSOR_H
 
+#include "pppresidualstore.h"
+#include "pppsolutionstore.h"
 #include "rtklib.h"
 #include <QObject>
 #include <QString>
+#include <atomic>
+#include <climits>
+#include <memory>
+
+class PPPEngine;
+class PPPInputs;
+class PPPTracer;
+class QThread;
 
 // 处理模式
 typedef enum {
@@ -30,6 +40,26 @@ typedef enum {
     IONO_TEC               // TEC模型
 } iono_opt_t;
 
+// 解算方向（取值与RTKLIB的prcopt_t::soltype一致）
+typedef enum {
+    SOLTYPE_FORWARD,       // 前向滤波
+    SOLTYPE_BACKWARD,      // 后向滤波
+    SOLTYPE_COMBINED       // 前后向组合（平滑）
+} sol_type_t;
+
+// 结果文件格式
+typedef enum {
+    SOLFORMAT_TEXT,        // RTKLIB的.pos文本
+    SOLFORMAT_BINARY,      // 定长记录的二进制文件（PPPSolutionFile），带时间索引
+    SOLFORMAT_RECORDS      // 不带时间索引的二进制文件，处理过程中可以逐条读取（组合解的单向处理）
+} sol_format_t;
+
+// 跟踪日志格式
+typedef enum {
+    TRACEFORMAT_BINARY,    // 异步写出的二进制跟踪文件（PPPTracer），用ppp_cli --trace2txt转换为文本
+    TRACEFORMAT_TEXT       // RTKLIB直接写出的文本，每行都等待写入磁盘
+} trace_format_t;
+
 // 定义数据路径结构体
 typedef struct {
     // 输入文件路径
@@ -42,21 +72,47 @@ typedef struct {
     char erp_file[1024];   // 地球自转参数文件路径
 
     // 输出文件路径
-    char out_file[1024];   // 输出文件路径
+    char out_file[1024];   // 输出文件路径（由PPPEngine处理时可为空，只保存在内存中）
 
     // 处理参数
     run_mode_t mode;       // 处理模式
     int trace_level;       // 日志级别
+    trace_format_t tracefmt; // 日志格式
     
     // 新增处理参数
     double ts[6];          // 开始时间 [年,月,日,时,分,秒]
     double te[6];          // 结束时间 [年,月,日,时,分,秒]
     double ti;             // 处理间隔 (秒)
     int niter;             // 最大迭代次数
+    double elmask;         // 截止高度角 (度)
     trop_opt_t tropopt;    // 对流层模型选项
     iono_opt_t ionoopt;    // 电离层模型选项
     bool use_time_range;   // 是否使用时间范围
     int navsys;            // 卫星系统选项(SYS_GPS|SYS_GLO|...)
+    sol_type_t soltype;    // 解算方向
+    sol_format_t solformat; // 结果文件格式（二进制仅单向不分片解算）
+    
+    // 时间窗分片并行处理
+    int shards;            // 分片数（0或1为不分片）
+    double shard_overlap;  // 分片前的收敛重叠时长 (s)，重叠部分的结果被丢弃
+    
+    // 检查点（仅前向解算），中断后重新运行同一任务时从最近的检查点恢复
+    bool checkpoint;       // 是否写检查点
+    
+    // 观测数据缓存（仅前向解算），解码后的观测数据按文件内容缓存，再次处理时不解析RINEX
+    char obs_cache[1024];  // 缓存目录（为空不缓存）
+    
+    // 流式处理（仅前向解算），观测文件不读入内存，处理时按历元读取
+    bool stream;           // 是否流式处理
+    
+    // 测站数据库（仅静态前向解算），从上次的坐标和对流层延迟热启动，完成后更新
+    char station_db[1024]; // 测站数据库文件路径（为空不使用）
+    
+    // 静态PPP收敛后提前结束（仅静态前向解算）
+    bool early_stop;       // 是否提前结束
+    double stop_sigma;     // 位置三维标准差阈值 (m)
+    double stop_change;    // 坐标变化阈值 (m)
+    double stop_window;    // 条件需保持的时长 (s)
 } ppp_paths_t;
 
 class PPPProcessor : public QObject
@@ -67,6 +123,13 @@ public:
     explicit PPPProcessor(QObject *parent = nullptr);
     ~PPPProcessor();
 
+    // 以默认值初始化处理参数
+    static void initPaths(ppp_paths_t *paths);
+    
+    // 整体设置/获取处理参数（用于任务文件）
+    void setPaths(const ppp_paths_t &paths);
+    const ppp_paths_t &paths() const;
+    
     // 设置处理模式
     void setMode(run_mode_t mode);
     
@@ -101,11 +164,58 @@ public:
     
     // 设置卫星系统
     void setNavSys(int navsys);
-      // 执行PPP处理
+    
+    // 设置解算方向
+    void setSolutionType(sol_type_t type);
+    
+    // 解算结果输出选项，工作进程的输出与组合解的合并结果使用相同格式
+    static void initSolutionOptions(const ppp_paths_t *paths, solopt_t *solopt);
+    
+    // 由处理参数生成RTKLIB选项，不发送进度信号，可在任意线程中调用
+    static void checkInputFiles(ppp_paths_t *paths);
+    static void initOptions(const ppp_paths_t *paths, prcopt_t *prcopt, solopt_t *solopt, filopt_t *filopt);
+    static int inputFiles(const ppp_paths_t *paths, char **infiles); // 返回输入文件数，infiles至少4个元素
+
+    // 检查文件、生成选项并读取PPPEngine的输入（观测数据缓存取自任务，流式处理等由调用方设置inputs），
+    // 压缩文件在读取期间由进程内解码器通过管道提供；失败时error为说明文字
+    static bool loadInputs(ppp_paths_t *paths, prcopt_t *prcopt, solopt_t *solopt, PPPInputs *inputs, QString *error);
+    
+    // 由PPPEngine处理的任务（前向解算和二进制结果），以及按任务设置引擎
+    static bool useEngine(const ppp_paths_t *paths);
+    static void setupEngine(const ppp_paths_t *paths, PPPEngine *engine);
+    
+    // 热启动、收敛时间和提前结束的说明文字
+    static QString engineReport(const ppp_paths_t *paths, const PPPEngine &engine);
+
+    // 各系统的拒绝次数，没有残差时为空
+    static QString rejectReport(const PPPResidualStore &residuals);
+    
+    // 在工作线程中启动PPP处理（立即返回，结果通过信号通知）
     bool startProcessing();
     
+    // 在调用线程中同步执行PPP处理
+    bool execute();
+    
+    // 请求取消当前任务，postpos将在下一历元返回
+    void cancelProcessing();
+    
+    // 等待工作线程结束
+    bool waitForFinished(unsigned long msecs = ULONG_MAX);
+    
     // 获取处理进度和状态
     QString getStatusMessage() const;
+    bool isProcessing() const;
+    bool wasCancelled() const;
+    
+    // 最近一次处理的解算结果，由PPPEngine处理时保存（从检查点恢复时只有部分结果，不保存），否则为空
+    // 处理期间不得访问
+    const PPPSolutionStore &solutions() const;
+
+    // 最近一次处理的各卫星残差和状态，保存条件与solutions()相同
+    const PPPResidualStore &residuals() const;
+
+    // 最近一次处理的日志文件，未生成日志时为空
+    QString traceFile() const;
     
 signals:
     // 处理状态信号
@@ -115,15 +225,37 @@ signals:
     
 private:
     // 私有实现函数
-    void setupPreciseFiles();
-    void setPPPOptions(prcopt_t *prcopt, solopt_t *solopt, filopt_t *filopt);
-    int runPPP(const prcopt_t *prcopt, const solopt_t *solopt, const filopt_t *filopt);
+    bool processJob();
+    void setupPreciseFiles(ppp_paths_t *paths);
+    void setPPPOptions(const ppp_paths_t *paths, prcopt_t *prcopt, solopt_t *solopt, filopt_t *filopt);
+    int runPPP(const ppp_paths_t *paths, const prcopt_t *prcopt, const solopt_t *solopt, const filopt_t *filopt);
     QString setFilePathWithDoubleBackslashes(const QString &path);
     
+    // RTKLIB回调（showmsg/settspan/settime转发到当前运行的处理器）
+    friend int ::showmsg(const char *format, ...);
+    friend void ::settspan(gtime_t ts, gtime_t te);
+    friend void ::settime(gtime_t time);
+    bool onRtkMessage(const char *message);
+    void onRtkTimeSpan(gtime_t ts, gtime_t te);
+    void onRtkTime(gtime_t time);
+    
     // 配置和状态变量
-    ppp_paths_t m_paths;
+    ppp_paths_t m_paths;       // 界面设置的参数
+    ppp_paths_t m_job;         // 当前任务的参数快照
     QString m_statusMessage;
-    bool m_isProcessing;
+    std::atomic<bool> m_isProcessing;
+    std::atomic<bool> m_cancelRequested;
+    QThread *m_worker;
+    
+    // 历元进度（由settspan/settime更新）
+    gtime_t m_spanStart;
+    gtime_t m_spanEnd;
+    int m_lastPercent;
+    QString m_engineReport; // 收敛时间、提前结束等说明，附加在状态信息后
+    PPPSolutionStore m_solutions;
+    PPPResidualStore m_residuals;
+    std::unique_ptr<PPPTracer> m_tracer; // 处理期间的二进制跟踪日志
+    QString m_traceFile;
 };
 
 #endif // PPPPROCESSOR_H
@@ -0,0 +1,256 @@
+#include "pppproductcache.h"
+#include "pppdecompress.h"
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <cstring>
+
+// 缺省内存预算 (byte)
+static const qint64 DEFAULT_BUDGET = 512LL << 20;
+
+PPPErpTable::PPPErpTable()
+{
+    memset(&erp, 0, sizeof(erp_t));
+}
+
+PPPErpTable::~PPPErpTable()
+{
+    free(erp.data);
+}
+
+PPPNavigation::PPPNavigation()
+    : nav(new nav_t())
+{
+}
+
+PPPNavigation::~PPPNavigation()
+{
+    freenav(nav, 0xFF);
+    delete nav;
+}
+
+PPPProductCache::PPPProductCache()
+    : m_budget(DEFAULT_BUDGET), m_bytes(0), m_clock(0), m_hits(0), m_misses(0)
+{
+}
+
+PPPProductCache &PPPProductCache::instance()
+{
+    static PPPProductCache cache;
+    return cache;
+}
+
+void PPPProductCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_budget = qMax(bytes, qint64(0));
+    evict();
+}
+
+qint64 PPPProductCache::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_budget;
+}
+
+qint64 PPPProductCache::bytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+int PPPProductCache::hits() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hits;
+}
+
+int PPPProductCache::misses() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_misses;
+}
+
+void PPPProductCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->loading) {
+            ++it;
+            continue;
+        }
+        m_bytes -= it->bytes;
+        it = m_entries.erase(it);
+    }
+}
+
+QByteArray PPPProductCache::fileKey(const char *file)
+{
+    QString source = PPPDecompressor::sourceFile(file);
+    QFileInfo info(source.isEmpty() ? QString::fromLocal8Bit(file) : source);
+    if (!*file || !info.isFile()) {
+        return QByteArray();
+    }
+    return QFile::encodeName(info.canonicalFilePath()) + '|' +
+           QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + '|' + QByteArray::number(info.size());
+}
+
+char PPPProductCache::fileType(const char *file)
+{
+    // 与RTKLIB相同：SP3文件以'#'开头，RINEX文件第一行的第21列为文件类型
+    QFile f(QString::fromLocal8Bit(file));
+    if (strchr(file, '*') || !f.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QByteArray line = f.readLine(128);
+    if (line.startsWith('#')) {
+        return 'P';
+    }
+    if (line.size() < 21 || !line.contains("RINEX VERSION / TYPE")) {
+        return 0;
+    }
+    switch (line[20]) {
+    case 'O': return 'O';
+    case 'N': case 'G': case 'H': case 'J': case 'L': return 'N';
+    case 'C': return 'C';
+    default: return 0;
+    }
+}
+
+std::shared_ptr<const PPPAntexIndex> PPPProductCache::antennas(const char *file, QString *error, bool *hit)
+{
+    QByteArray key = fileKey(file);
+    auto data = get(key.isEmpty() ? key : "atx|" + key, [file, error](qint64 *bytes) -> std::shared_ptr<const void> {
+        std::shared_ptr<PPPAntexIndex> index = std::make_shared<PPPAntexIndex>();
+        if (!index->open(file, error)) {
+            return nullptr;
+        }
+        *bytes = sizeof(PPPAntexIndex) + index->bytes();
+        return index;
+    }, hit);
+    return std::static_pointer_cast<const PPPAntexIndex>(data);
+}
+
+std::shared_ptr<const PPPErpTable> PPPProductCache::erp(const char *file, bool *hit)
+{
+    QByteArray key = fileKey(file);
+    auto data = get(key.isEmpty() ? key : "erp|" + key, [file](qint64 *bytes) -> std::shared_ptr<const void> {
+        std::shared_ptr<PPPErpTable> table = std::make_shared<PPPErpTable>();
+        if (!readerp(file, &table->erp)) {
+            return nullptr;
+        }
+        *bytes = sizeof(PPPErpTable) + qint64(table->erp.nmax) * sizeof(erpd_t);
+        return table;
+    }, hit);
+    return std::static_pointer_cast<const PPPErpTable>(data);
+}
+
+std::shared_ptr<const PPPNavigation> PPPProductCache::navigation(const char *file, const char *opt, bool *hit)
+{
+    // 读取选项中的卫星系统影响读入的星历
+    QByteArray key = fileKey(file);
+    auto data = get(key.isEmpty() ? key : "nav|" + QByteArray(opt) + '|' + key,
+                    [file, opt](qint64 *bytes) -> std::shared_ptr<const void> {
+        std::shared_ptr<PPPNavigation> navigation = std::make_shared<PPPNavigation>();
+        nav_t *nav = navigation->nav;
+        obs_t obs = {};
+        int stat = readrnxt(file, 1, gtime_t{ 0, 0.0 }, gtime_t{ 0, 0.0 }, 0.0, opt, &obs, nav, nullptr);
+        freeobs(&obs);
+        if (stat < 0 || (nav->n <= 0 && nav->ng <= 0 && nav->ns <= 0)) {
+            return nullptr;
+        }
+        uniqnav(nav);
+        *bytes = sizeof(nav_t) + qint64(nav->nmax) * sizeof(eph_t) + qint64(nav->ngmax) * sizeof(geph_t) +
+                 qint64(nav->nsmax) * sizeof(seph_t);
+        return navigation;
+    }, hit);
+    return std::static_pointer_cast<const PPPNavigation>(data);
+}
+
+std::shared_ptr<const PPPPreciseProducts> PPPProductCache::products(const QList<QByteArray> &files, bool *hit)
+{
+    // 键为各文件的键按顺序连接，任一文件无法识别时不缓存
+    QByteArray key = "sp3";
+    for (const QByteArray &file : files) {
+        QByteArray k = fileKey(file.constData());
+        if (k.isEmpty()) {
+            key.clear();
+            break;
+        }
+        key += '|' + k;
+    }
+    auto data = get(key, [&files](qint64 *bytes) -> std::shared_ptr<const void> {
+        std::unique_ptr<nav_t> nav(new nav_t());
+        for (const QByteArray &file : files) readsp3(file.constData(), nav.get(), 0);
+        for (const QByteArray &file : files) readrnxc(file.constData(), nav.get());
+        std::shared_ptr<PPPPreciseProducts> products = std::make_shared<PPPPreciseProducts>();
+        if (nav->ne > 0 || nav->nc > 0) {
+            products->build(nav.get());
+        }
+        freenav(nav.get(), 0xFF);
+        *bytes = sizeof(PPPPreciseProducts) + products->bytes();
+        return products;
+    }, hit);
+    return std::static_pointer_cast<const PPPPreciseProducts>(data);
+}
+
+std::shared_ptr<const void> PPPProductCache::get(const QByteArray &key, const Loader &loader, bool *hit)
+{
+    qint64 bytes = 0;
+    if (hit) *hit = false;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_budget <= 0 || key.isEmpty()) {
+        locker.unlock();
+        return loader(&bytes);
+    }
+
+    // 其他任务正在读取同一文件时等待其完成，读取失败时由本任务重新读取
+    auto it = m_entries.find(key);
+    while (it != m_entries.end() && it->loading) {
+        m_loaded.wait(&m_mutex);
+        it = m_entries.find(key);
+    }
+    if (it != m_entries.end()) {
+        it->lastUse = ++m_clock;
+        m_hits++;
+        if (hit) *hit = true;
+        return it->data;
+    }
+    m_misses++;
+    m_entries[key].loading = true;
+    locker.unlock();
+
+    std::shared_ptr<const void> data = loader(&bytes);
+
+    locker.relock();
+    if (data) {
+        Entry &entry = m_entries[key];
+        entry.data = data;
+        entry.bytes = bytes;
+        entry.lastUse = ++m_clock;
+        entry.loading = false;
+        m_bytes += bytes;
+        evict();
+    } else {
+        m_entries.remove(key);
+    }
+    m_loaded.wakeAll();
+    return data;
+}
+
+void PPPProductCache::evict()
+{
+    // 按最近使用时间淘汰，正在使用的数据由使用者的引用保持到任务结束
+    while (m_bytes > m_budget) {
+        auto oldest = m_entries.end();
+        for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (!it->loading && (oldest == m_entries.end() || it->lastUse < oldest->lastUse)) oldest = it;
+        }
+        if (oldest == m_entries.end()) {
+            break;
+        }
+        m_bytes -= oldest->bytes;
+        m_entries.erase(oldest);
+    }
+}
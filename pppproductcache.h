@@ -0,0 +1,92 @@
+#ifndef PPPPRODUCTCACHE_H
+#define PPPPRODUCTCACHE_H
+
+#include "pppantexindex.h"
+#include "pppproducts.h"
+#include "rtklib.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+
+// 地球自转参数表（readerp读取的ERP文件）
+struct PPPErpTable {
+    PPPErpTable();
+    ~PPPErpTable();
+    erp_t erp;
+    Q_DISABLE_COPY(PPPErpTable)
+};
+
+// 一个导航文件中的广播星历（已经uniqnav排序去重）
+// 使用者只读共享eph/geph/seph数组，不得修改或释放
+struct PPPNavigation {
+    PPPNavigation();
+    ~PPPNavigation();
+    nav_t *nav;
+    Q_DISABLE_COPY(PPPNavigation)
+};
+
+// 同一进程中各任务共享的只读产品缓存
+// 网络批处理和界面中的连续处理通常使用相同的精密星历、钟差、ERP、ANTEX和导航文件，
+// 缓存按文件路径、修改时间和大小保存解码后的数据，后续任务（包括同时进行的任务）直接共享，不再读取和复制。
+// 缓存的数据只读；超过内存预算时按最近使用时间淘汰，仍被任务使用的数据在任务结束后释放。
+// 预算为0时不缓存，每次调用都重新读取（数据仍可在同一任务内共享）。
+class PPPProductCache
+{
+public:
+    static PPPProductCache &instance();
+
+    // 内存预算 (byte)，0为不缓存
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+
+    qint64 bytes() const;    // 缓存中数据占用的内存 (byte)
+    int hits() const;
+    int misses() const;
+    void clear();
+
+    // 读取失败时返回空指针；hit不为空时返回是否由缓存得到
+    std::shared_ptr<const PPPAntexIndex> antennas(const char *file, QString *error, bool *hit = nullptr);
+    std::shared_ptr<const PPPErpTable> erp(const char *file, bool *hit = nullptr);
+    std::shared_ptr<const PPPNavigation> navigation(const char *file, const char *opt, bool *hit = nullptr);
+
+    // 按顺序对各文件调用readsp3和readrnxc，转为紧凑存储（与postpos读取精密产品的顺序相同）
+    std::shared_ptr<const PPPPreciseProducts> products(const QList<QByteArray> &files, bool *hit = nullptr);
+
+    // 文件的缓存键：规范路径、修改时间和大小，文件不存在时为空
+    // 进程内解压的管道路径按原压缩文件计算
+    static QByteArray fileKey(const char *file);
+
+    // 按文件头识别RINEX/SP3文件的类型：'O'观测，'N'导航，'C'钟差，'P'精密星历，0未知
+    static char fileType(const char *file);
+
+private:
+    PPPProductCache();
+
+    struct Entry {
+        std::shared_ptr<const void> data;
+        qint64 bytes = 0;
+        quint64 lastUse = 0;
+        bool loading = false;
+    };
+
+    typedef std::function<std::shared_ptr<const void>(qint64 *bytes)> Loader;
+    std::shared_ptr<const void> get(const QByteArray &key, const Loader &loader, bool *hit);
+    void evict();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_loaded;
+    QHash<QByteArray, Entry> m_entries;
+    qint64 m_budget;
+    qint64 m_bytes;
+    quint64 m_clock;
+    int m_hits;
+    int m_misses;
+
+    Q_DISABLE_COPY(PPPProductCache)
+};
+
+#endif // PPPPRODUCTCACHE_H
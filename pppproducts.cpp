@@ -0,0 +1,248 @@
+#include "pppproducts.h"
+#include <algorithm>
+#include <cstring>
+
+// RTKLIB preceph.c中星历插值的阶数（NMAX），插值使用前后共NMAX+1个历元
+static const int INTERP_ORDER = 10;
+
+// 窗口在time前后至少保留的历元数，包括信号发射时刻和求速度时的时间偏移
+static const int WINDOW_MARGIN = INTERP_ORDER + 2;
+
+// 每次展开的历元数
+static const int WINDOW_SPAN = 4 * WINDOW_MARGIN;
+
+template <typename T>
+static bool nonzero(const T *values, int n)
+{
+    for (int i = 0; i < n; i++) {
+        if (values[i] != 0) return true;
+    }
+    return false;
+}
+
+template <typename T>
+static qint64 vectorBytes(const std::vector<T> &v)
+{
+    return qint64(v.size()) * sizeof(T);
+}
+
+// 选择覆盖time的窗口起点，已展开的窗口仍覆盖time前后WINDOW_MARGIN个历元时返回false
+static bool selectWindow(const std::vector<gtime_t> &times, gtime_t time, int current, int *start)
+{
+    int n = int(times.size());
+    int i = int(std::upper_bound(times.begin(), times.end(), time,
+                                 [](gtime_t t, gtime_t epoch) { return timediff(t, epoch) < 0.0; }) -
+                times.begin());
+    int lo = qMax(0, i - WINDOW_MARGIN), hi = qMin(n, i + WINDOW_MARGIN);
+    if (current >= 0 && current <= lo && current + WINDOW_SPAN >= hi) {
+        return false;
+    }
+    *start = qMax(0, qMin(i - WINDOW_MARGIN, n - WINDOW_SPAN));
+    return true;
+}
+
+PPPPreciseWindow::PPPPreciseWindow()
+    : m_ephStart(-1), m_clkStart(-1)
+{
+}
+
+void PPPPreciseWindow::reset()
+{
+    // 不同输入中的卫星可能不同，重新分配使未出现的卫星为0
+    m_peph.clear();
+    m_pclk.clear();
+    m_ephStart = m_clkStart = -1;
+}
+
+qint64 PPPPreciseWindow::bytes() const
+{
+    return vectorBytes(m_peph) + vectorBytes(m_pclk);
+}
+
+PPPPreciseProducts::PPPPreciseProducts() : m_navBytes(0)
+{
+}
+
+void PPPPreciseProducts::clear()
+{
+    // 释放内存，clear()不会减小容量
+    *this = PPPPreciseProducts();
+}
+
+bool PPPPreciseProducts::isEmpty() const
+{
+    return m_ephTime.empty() && m_clkTime.empty();
+}
+
+int PPPPreciseProducts::satCount() const
+{
+    return int(m_sats.size());
+}
+
+int PPPPreciseProducts::ephCount() const
+{
+    return int(m_ephTime.size());
+}
+
+int PPPPreciseProducts::clkCount() const
+{
+    return int(m_clkTime.size());
+}
+
+qint64 PPPPreciseProducts::bytes() const
+{
+    return vectorBytes(m_sats) + vectorBytes(m_ephTime) + vectorBytes(m_ephIndex) + vectorBytes(m_pos) +
+           vectorBytes(m_std) + vectorBytes(m_vel) + vectorBytes(m_vst) + vectorBytes(m_cov) + vectorBytes(m_vco) +
+           vectorBytes(m_clkTime) + vectorBytes(m_clkIndex) + vectorBytes(m_clk) + vectorBytes(m_clkStd);
+}
+
+qint64 PPPPreciseProducts::sourceBytes() const
+{
+    return m_navBytes;
+}
+
+qint64 PPPPreciseProducts::navBytes(const nav_t *nav)
+{
+    return qint64(nav->nemax) * sizeof(peph_t) + qint64(nav->ncmax) * sizeof(pclk_t);
+}
+
+void PPPPreciseProducts::build(nav_t *nav)
+{
+    clear();
+    m_navBytes = navBytes(nav);
+
+    // 产品中出现过的卫星（未出现的卫星各量均为0）
+    bool used[MAXSAT] = {};
+    bool hasVel = false, hasCov = false;
+    for (int i = 0; i < nav->ne; i++) {
+        const peph_t &peph = nav->peph[i];
+        for (int j = 0; j < MAXSAT; j++) {
+            bool vel = nonzero(peph.vel[j], 4) || nonzero(peph.vst[j], 4);
+            bool cov = nonzero(peph.cov[j], 3) || nonzero(peph.vco[j], 3);
+            hasVel |= vel;
+            hasCov |= cov;
+            used[j] |= vel || cov || nonzero(peph.pos[j], 4) || nonzero(peph.std[j], 4);
+        }
+    }
+    for (int i = 0; i < nav->nc; i++) {
+        for (int j = 0; j < MAXSAT; j++) {
+            used[j] |= nav->pclk[i].clk[j][0] != 0.0 || nav->pclk[i].std[j][0] != 0.0f;
+        }
+    }
+    for (int j = 0; j < MAXSAT; j++) {
+        if (used[j]) m_sats.push_back(j + 1);
+    }
+
+    int ns = int(m_sats.size()), ne = nav->ne, nc = nav->nc;
+    m_ephTime.resize(ne);
+    m_ephIndex.resize(ne);
+    for (int i = 0; i < ne; i++) {
+        m_ephTime[i] = nav->peph[i].time;
+        m_ephIndex[i] = nav->peph[i].index;
+    }
+    m_pos.resize(size_t(ns) * ne * 4);
+    m_std.resize(size_t(ns) * ne * 4);
+    if (hasVel) {
+        m_vel.resize(size_t(ns) * ne * 4);
+        m_vst.resize(size_t(ns) * ne * 4);
+    }
+    if (hasCov) {
+        m_cov.resize(size_t(ns) * ne * 3);
+        m_vco.resize(size_t(ns) * ne * 3);
+    }
+    for (int s = 0; s < ns; s++) {
+        int j = m_sats[s] - 1;
+        for (int i = 0; i < ne; i++) {
+            const peph_t &peph = nav->peph[i];
+            size_t k = size_t(s) * ne + i;
+            memcpy(&m_pos[k * 4], peph.pos[j], sizeof(peph.pos[j]));
+            memcpy(&m_std[k * 4], peph.std[j], sizeof(peph.std[j]));
+            if (hasVel) {
+                memcpy(&m_vel[k * 4], peph.vel[j], sizeof(peph.vel[j]));
+                memcpy(&m_vst[k * 4], peph.vst[j], sizeof(peph.vst[j]));
+            }
+            if (hasCov) {
+                memcpy(&m_cov[k * 3], peph.cov[j], sizeof(peph.cov[j]));
+                memcpy(&m_vco[k * 3], peph.vco[j], sizeof(peph.vco[j]));
+            }
+        }
+    }
+
+    m_clkTime.resize(nc);
+    m_clkIndex.resize(nc);
+    for (int i = 0; i < nc; i++) {
+        m_clkTime[i] = nav->pclk[i].time;
+        m_clkIndex[i] = nav->pclk[i].index;
+    }
+    m_clk.resize(size_t(ns) * nc);
+    m_clkStd.resize(size_t(ns) * nc);
+    for (int s = 0; s < ns; s++) {
+        int j = m_sats[s] - 1;
+        for (int i = 0; i < nc; i++) {
+            m_clk[size_t(s) * nc + i] = nav->pclk[i].clk[j][0];
+            m_clkStd[size_t(s) * nc + i] = nav->pclk[i].std[j][0];
+        }
+    }
+
+    free(nav->peph);
+    free(nav->pclk);
+    nav->peph = nullptr;
+    nav->pclk = nullptr;
+    nav->ne = nav->nemax = 0;
+    nav->nc = nav->ncmax = 0;
+}
+
+void PPPPreciseProducts::update(gtime_t time, PPPPreciseWindow *window, nav_t *nav) const
+{
+    int ns = int(m_sats.size()), ne = int(m_ephTime.size()), nc = int(m_clkTime.size());
+    int start;
+
+    // 未出现的卫星在窗口中保持为0，只需改写存储中的卫星
+    if (ne > 0 && selectWindow(m_ephTime, time, window->m_ephStart, &start)) {
+        int n = qMin(WINDOW_SPAN, ne - start);
+        if (int(window->m_peph.size()) < n) {
+            window->m_peph.assign(n, peph_t());
+        }
+        for (int i = 0; i < n; i++) {
+            peph_t &peph = window->m_peph[i];
+            peph.time = m_ephTime[start + i];
+            peph.index = m_ephIndex[start + i];
+            for (int s = 0; s < ns; s++) {
+                int j = m_sats[s] - 1;
+                size_t k = size_t(s) * ne + start + i;
+                memcpy(peph.pos[j], &m_pos[k * 4], sizeof(peph.pos[j]));
+                memcpy(peph.std[j], &m_std[k * 4], sizeof(peph.std[j]));
+                if (!m_vel.empty()) {
+                    memcpy(peph.vel[j], &m_vel[k * 4], sizeof(peph.vel[j]));
+                    memcpy(peph.vst[j], &m_vst[k * 4], sizeof(peph.vst[j]));
+                }
+                if (!m_cov.empty()) {
+                    memcpy(peph.cov[j], &m_cov[k * 3], sizeof(peph.cov[j]));
+                    memcpy(peph.vco[j], &m_vco[k * 3], sizeof(peph.vco[j]));
+                }
+            }
+        }
+        window->m_ephStart = start;
+        nav->peph = window->m_peph.data();
+        nav->ne = nav->nemax = n;
+    }
+    if (nc > 0 && selectWindow(m_clkTime, time, window->m_clkStart, &start)) {
+        int n = qMin(WINDOW_SPAN, nc - start);
+        if (int(window->m_pclk.size()) < n) {
+            window->m_pclk.assign(n, pclk_t());
+        }
+        for (int i = 0; i < n; i++) {
+            pclk_t &pclk = window->m_pclk[i];
+            pclk.time = m_clkTime[start + i];
+            pclk.index = m_clkIndex[start + i];
+            for (int s = 0; s < ns; s++) {
+                int j = m_sats[s] - 1;
+                pclk.clk[j][0] = m_clk[size_t(s) * nc + start + i];
+                pclk.std[j][0] = m_clkStd[size_t(s) * nc + start + i];
+            }
+        }
+        window->m_clkStart = start;
+        nav->pclk = window->m_pclk.data();
+        nav->nc = nav->ncmax = n;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef PPPPRODUCTS_H
+#define PPPPRODUCTS_H
+
+#include "rtklib.h"
+#include <QtGlobal>
+#include <vector>
+
+// 精密星历和钟差的展开窗口，每个引擎一个
+// 持有RTKLIB格式的peph_t/pclk_t数组，只包含当前历元附近的产品历元
+class PPPPreciseWindow
+{
+public:
+    PPPPreciseWindow();
+
+    // 处理新的输入前调用，下次更新时重新展开
+    void reset();
+
+    // 展开的数组占用的内存 (byte)
+    qint64 bytes() const;
+
+private:
+    friend class PPPPreciseProducts;
+
+    std::vector<peph_t> m_peph;
+    std::vector<pclk_t> m_pclk;
+    int m_ephStart;   // 窗口第一个历元在存储中的序号，<0为未展开
+    int m_clkStart;
+};
+
+// 精密星历和钟差的紧凑存储
+// RTKLIB的peph_t/pclk_t每个历元都为全部MAXSAT颗卫星分配空间，而产品文件中只有其中一部分卫星。
+// 本类只保存产品中出现过的卫星，各量按卫星、历元连续存放（星历的速度和协方差仅在文件中有时保存）；
+// 处理时把当前历元附近的产品展开到引擎自己的窗口中，peph2pos的插值结果与使用完整数组相同。
+class PPPPreciseProducts
+{
+public:
+    PPPPreciseProducts();
+
+    // 取出nav中的精密星历和钟差并释放nav中的数组
+    void build(nav_t *nav);
+    void clear();
+
+    bool isEmpty() const;
+    int satCount() const;   // 存储的卫星数
+    int ephCount() const;   // 星历历元数
+    int clkCount() const;   // 钟差历元数
+
+    // 紧凑存储占用的内存，以及nav中peph/pclk数组占用的内存 (byte)
+    qint64 bytes() const;
+    static qint64 navBytes(const nav_t *nav);
+    qint64 sourceBytes() const;   // 转换前nav中数组占用的内存 (byte)
+
+    // 把time附近的产品展开到window，并设置nav的peph/pclk指向窗口
+    // 窗口仍覆盖time时不重新展开
+    void update(gtime_t time, PPPPreciseWindow *window, nav_t *nav) const;
+
+private:
+    std::vector<int> m_sats;          // 卫星号
+    std::vector<gtime_t> m_ephTime;
+    std::vector<int> m_ephIndex;
+    std::vector<double> m_pos;        // [卫星][历元][4]
+    std::vector<float> m_std;         // [卫星][历元][4]
+    std::vector<double> m_vel;        // [卫星][历元][4]，无速度时为空
+    std::vector<float> m_vst;         // [卫星][历元][4]，无速度时为空
+    std::vector<float> m_cov;         // [卫星][历元][3]，无协方差时为空
+    std::vector<float> m_vco;         // [卫星][历元][3]，无协方差时为空
+    std::vector<gtime_t> m_clkTime;
+    std::vector<int> m_clkIndex;
+    std::vector<double> m_clk;        // [卫星][历元]
+    std::vector<float> m_clkStd;      // [卫星][历元]
+    qint64 m_navBytes;
+};
+
+#endif // PPPPRODUCTS_H
@@ -0,0 +1,348 @@
+#include "pppresidualstore.h"
+#include <QByteArray>
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+static const char RESIDUAL_MAGIC[8] = { 'P', 'P', 'P', 'S', 'T', 'A', '0', '1' };
+
+struct ResidualFileHeader {
+    char magic[8];
+    qint64 time;           // 记录时间的起点 (GPST)
+    double sec;
+    quint32 series;        // 段数
+    quint32 reserved;
+};
+
+// 每段的开头，其后为count条记录的各列
+struct ResidualSeriesHeader {
+    quint16 sat;
+    quint8 frq;
+    quint8 reserved;
+    quint32 count;
+};
+
+struct PPPResidualStore::Series {
+    std::vector<double> time;      // 相对m_origin的秒数
+    std::vector<float> az, el;     // (rad)
+    std::vector<float> resp, resc; // (m)
+    std::vector<quint8> flag;      // (vsat<<5)+(slip<<3)+fix
+    std::vector<quint16> snr, lock, outc, slipc, rejc;
+    std::vector<quint32> rejected; // 拒绝次数的累计（rejc的增量，计数器复位时按复位后的值计）
+};
+
+template <typename T>
+static qint64 vectorBytes(const std::vector<T> &v)
+{
+    return qint64(v.capacity()) * sizeof(T);
+}
+
+template <typename T>
+static void appendColumn(QByteArray *data, const std::vector<T> &v)
+{
+    data->append(reinterpret_cast<const char *>(v.data()), int(v.size() * sizeof(T)));
+}
+
+template <typename T>
+static bool readColumn(const char **p, const char *end, size_t n, std::vector<T> *v)
+{
+    if (size_t(end - *p) < n * sizeof(T)) {
+        return false;
+    }
+    v->resize(n);
+    memcpy(v->data(), *p, n * sizeof(T));
+    *p += n * sizeof(T);
+    return true;
+}
+
+PPPResidualStore::PPPResidualStore()
+    : m_origin({ 0 }), m_size(0)
+{
+}
+
+PPPResidualStore::~PPPResidualStore()
+{
+}
+
+void PPPResidualStore::clear()
+{
+    // 释放内存，clear()不会减小容量
+    std::vector<Series>().swap(m_series);
+    m_origin = gtime_t{ 0, 0.0 };
+    m_size = 0;
+}
+
+void PPPResidualStore::append(const rtk_t &rtk)
+{
+    if (rtk.sol.stat == SOLQ_NONE) {
+        return;
+    }
+    int nfreq = qMin(rtk.opt.mode >= PMODE_DGPS ? rtk.opt.nf : 1, NFREQ);
+    solstat_t stat;
+    for (int i = 0; i < MAXSAT; i++) {
+        const ssat_t &ssat = rtk.ssat[i];
+        if (!ssat.vs) continue;
+        for (int j = 0; j < nfreq; j++) {
+            memset(&stat, 0, sizeof(stat));
+            stat.time = rtk.sol.time;
+            stat.sat = uint8_t(i + 1);
+            stat.frq = uint8_t(j + 1);
+            stat.az = float(ssat.azel[0]);
+            stat.el = float(ssat.azel[1]);
+            stat.resp = float(ssat.resp[j]);
+            stat.resc = float(ssat.resc[j]);
+            stat.flag = uint8_t((ssat.vsat[j] << 5) + ((ssat.slip[j] & 3) << 3) + ssat.fix[j]);
+            stat.snr = ssat.snr[j];
+            stat.lock = uint16_t(ssat.lock[j]);
+            stat.outc = uint16_t(ssat.outc[j]);
+            stat.slipc = uint16_t(ssat.slipc[j]);
+            stat.rejc = uint16_t(ssat.rejc[j]);
+            append(stat);
+        }
+    }
+}
+
+void PPPResidualStore::append(const solstat_t &stat)
+{
+    if (stat.sat < 1 || stat.sat > MAXSAT || stat.frq < 1 || stat.frq > NFREQ) {
+        return;
+    }
+    if (m_series.empty()) {
+        m_series.resize(size_t(MAXSAT) * NFREQ);
+        m_origin = stat.time;
+    }
+    Series &s = m_series[size_t(stat.sat - 1) * NFREQ + stat.frq - 1];
+    quint32 rejected = s.rejected.empty() ? 0 : s.rejected.back();
+    rejected += s.rejc.empty() || stat.rejc < s.rejc.back() ? stat.rejc : stat.rejc - s.rejc.back();
+    s.time.push_back(timediff(stat.time, m_origin));
+    s.az.push_back(stat.az);
+    s.el.push_back(stat.el);
+    s.resp.push_back(stat.resp);
+    s.resc.push_back(stat.resc);
+    s.flag.push_back(stat.flag);
+    s.snr.push_back(stat.snr);
+    s.lock.push_back(stat.lock);
+    s.outc.push_back(stat.outc);
+    s.slipc.push_back(stat.slipc);
+    s.rejc.push_back(stat.rejc);
+    s.rejected.push_back(rejected);
+    m_size++;
+}
+
+bool PPPResidualStore::loadStat(const QString &path, QString *error)
+{
+    clear();
+    QByteArray name = path.toLocal8Bit();
+    char *files[] = { name.data() };
+    solstatbuf_t buf = { 0 };
+    if (!readsolstat(files, 1, &buf)) {
+        *error = QString("无法读取状态文件: %1").arg(path);
+        return false;
+    }
+    // readsolstat已按时间排序
+    for (int i = 0; i < buf.n; i++) {
+        append(buf.data[i]);
+    }
+    freesolstatbuf(&buf);
+    return true;
+}
+
+bool PPPResidualStore::save(const QString &path, QString *error) const
+{
+    QByteArray data;
+    ResidualFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RESIDUAL_MAGIC, sizeof(header.magic));
+    header.time = qint64(m_origin.time);
+    header.sec = m_origin.sec;
+    data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    for (size_t k = 0; k < m_series.size(); k++) {
+        const Series &s = m_series[k];
+        if (s.time.empty()) continue;
+        ResidualSeriesHeader sh;
+        memset(&sh, 0, sizeof(sh));
+        sh.sat = quint16(k / NFREQ + 1);
+        sh.frq = quint8(k % NFREQ + 1);
+        sh.count = quint32(s.time.size());
+        data.append(reinterpret_cast<const char *>(&sh), sizeof(sh));
+        appendColumn(&data, s.time);
+        appendColumn(&data, s.az);
+        appendColumn(&data, s.el);
+        appendColumn(&data, s.resp);
+        appendColumn(&data, s.resc);
+        appendColumn(&data, s.flag);
+        appendColumn(&data, s.snr);
+        appendColumn(&data, s.lock);
+        appendColumn(&data, s.outc);
+        appendColumn(&data, s.slipc);
+        appendColumn(&data, s.rejc);
+        header.series++;
+    }
+    memcpy(data.data(), &header, sizeof(header));
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        *error = QString("无法写入残差文件: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool PPPResidualStore::load(const QString &path, QString *error)
+{
+    clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = QString("无法打开残差文件: %1").arg(path);
+        return false;
+    }
+    QByteArray data = file.readAll();
+    const char *p = data.constData(), *end = p + data.size();
+    ResidualFileHeader header;
+    if (data.size() < int(sizeof(header)) || memcmp(p, RESIDUAL_MAGIC, sizeof(RESIDUAL_MAGIC))) {
+        *error = QString("不是残差文件: %1").arg(path);
+        return false;
+    }
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    m_series.resize(size_t(MAXSAT) * NFREQ);
+    m_origin.time = time_t(header.time);
+    m_origin.sec = header.sec;
+
+    bool ok = true;
+    for (quint32 i = 0; ok && i < header.series; i++) {
+        ResidualSeriesHeader sh;
+        ok = size_t(end - p) >= sizeof(sh);
+        if (!ok) break;
+        memcpy(&sh, p, sizeof(sh));
+        p += sizeof(sh);
+        ok = sh.sat >= 1 && sh.sat <= MAXSAT && sh.frq >= 1 && sh.frq <= NFREQ;
+        if (!ok) break;
+        Series &s = m_series[size_t(sh.sat - 1) * NFREQ + sh.frq - 1];
+        size_t n = sh.count;
+        ok = s.time.empty() && readColumn(&p, end, n, &s.time) && readColumn(&p, end, n, &s.az) &&
+             readColumn(&p, end, n, &s.el) && readColumn(&p, end, n, &s.resp) && readColumn(&p, end, n, &s.resc) &&
+             readColumn(&p, end, n, &s.flag) && readColumn(&p, end, n, &s.snr) && readColumn(&p, end, n, &s.lock) &&
+             readColumn(&p, end, n, &s.outc) && readColumn(&p, end, n, &s.slipc) && readColumn(&p, end, n, &s.rejc);
+        if (!ok) break;
+
+        // 累计拒绝次数不保存，读取时重新计算
+        s.rejected.resize(n);
+        quint32 rejected = 0;
+        for (size_t j = 0; j < n; j++) {
+            rejected += j == 0 || s.rejc[j] < s.rejc[j - 1] ? s.rejc[j] : s.rejc[j] - s.rejc[j - 1];
+            s.rejected[j] = rejected;
+        }
+        m_size += qint64(n);
+    }
+    if (!ok) {
+        clear();
+        *error = QString("残差文件已损坏: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+qint64 PPPResidualStore::size() const
+{
+    return m_size;
+}
+
+bool PPPResidualStore::isEmpty() const
+{
+    return m_size == 0;
+}
+
+gtime_t PPPResidualStore::startTime() const
+{
+    return m_origin;
+}
+
+QVector<int> PPPResidualStore::satellites() const
+{
+    QVector<int> sats;
+    for (size_t k = 0; k < m_series.size(); k += NFREQ) {
+        for (int j = 0; j < NFREQ; j++) {
+            if (!m_series[k + j].time.empty()) {
+                sats.append(int(k / NFREQ) + 1);
+                break;
+            }
+        }
+    }
+    return sats;
+}
+
+const PPPResidualStore::Series *PPPResidualStore::series(int sat, int frq) const
+{
+    if (sat < 1 || sat > MAXSAT || frq < 1 || frq > NFREQ || m_series.empty()) {
+        return nullptr;
+    }
+    return &m_series[size_t(sat - 1) * NFREQ + frq - 1];
+}
+
+void PPPResidualStore::range(const Series &series, gtime_t ts, gtime_t te, int *first, int *last) const
+{
+    const std::vector<double> &time = series.time;
+    *first = ts.time ? int(std::lower_bound(time.begin(), time.end(), timediff(ts, m_origin)) - time.begin()) : 0;
+    *last = te.time ? int(std::upper_bound(time.begin(), time.end(), timediff(te, m_origin)) - time.begin())
+                    : int(time.size());
+    *last = qMax(*first, *last);
+}
+
+QVector<solstat_t> PPPResidualStore::residuals(int sat, int frq, gtime_t ts, gtime_t te) const
+{
+    QVector<solstat_t> stats;
+    const Series *s = series(sat, frq);
+    if (!s) {
+        return stats;
+    }
+    int first, last;
+    range(*s, ts, te, &first, &last);
+    stats.resize(last - first);
+    for (int i = first; i < last; i++) {
+        solstat_t &stat = stats[i - first];
+        memset(&stat, 0, sizeof(stat));
+        stat.time = timeadd(m_origin, s->time[i]);
+        stat.sat = uint8_t(sat);
+        stat.frq = uint8_t(frq);
+        stat.az = s->az[i];
+        stat.el = s->el[i];
+        stat.resp = s->resp[i];
+        stat.resc = s->resc[i];
+        stat.flag = s->flag[i];
+        stat.snr = s->snr[i];
+        stat.lock = s->lock[i];
+        stat.outc = s->outc[i];
+        stat.slipc = s->slipc[i];
+        stat.rejc = s->rejc[i];
+    }
+    return stats;
+}
+
+int PPPResidualStore::rejects(int sys, gtime_t ts, gtime_t te) const
+{
+    qint64 count = 0;
+    for (size_t k = 0; k < m_series.size(); k++) {
+        const Series &s = m_series[k];
+        if (s.time.empty() || !(satsys(int(k / NFREQ) + 1, nullptr) & sys)) continue;
+        int first, last;
+        range(s, ts, te, &first, &last);
+        if (last > first) {
+            count += s.rejected[last - 1] - (first > 0 ? s.rejected[first - 1] : 0);
+        }
+    }
+    return int(qMin(count, qint64(INT_MAX)));
+}
+
+qint64 PPPResidualStore::bytes() const
+{
+    qint64 bytes = qint64(m_series.capacity()) * sizeof(Series);
+    for (const Series &s : m_series) {
+        bytes += vectorBytes(s.time) + vectorBytes(s.az) + vectorBytes(s.el) + vectorBytes(s.resp) +
+                 vectorBytes(s.resc) + vectorBytes(s.flag) + vectorBytes(s.snr) + vectorBytes(s.lock) +
+                 vectorBytes(s.outc) + vectorBytes(s.slipc) + vectorBytes(s.rejc) + vectorBytes(s.rejected);
+    }
+    return bytes;
+}
@@ -0,0 +1,66 @@
+#ifndef PPPRESIDUALSTORE_H
+#define PPPRESIDUALSTORE_H
+
+#include "rtklib.h"
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+
+// 各卫星的残差和状态
+// 引擎每个历元从滤波器的卫星状态中取出与RTKLIB状态文件$SAT行相同的内容（方位角、高度角、
+// 伪距和载波相位残差、有效/周跳/固定标志、信噪比、锁定、中断、周跳和拒绝计数），
+// 按卫星和频率分别按时间顺序存放，查询一颗卫星的时间窗只需二分查找，
+// 各系统的拒绝次数由累计值相减得到，查询耗时与时间窗的长度无关。
+// 也可以读取RTKLIB的.stat文本或本类保存的二进制文件。
+class PPPResidualStore
+{
+public:
+    PPPResidualStore();
+    ~PPPResidualStore();
+
+    void clear();
+
+    // 追加一个历元：与outsolstat相同，忽略无解的历元和无效的卫星
+    void append(const rtk_t &rtk);
+
+    // 追加一条记录，同一卫星和频率的记录须按时间顺序追加
+    void append(const solstat_t &stat);
+
+    // 读取RTKLIB的状态文件（$SAT行）
+    bool loadStat(const QString &path, QString *error);
+
+    // 二进制文件：按卫星和频率分段，每段按列存放
+    bool save(const QString &path, QString *error) const;
+    bool load(const QString &path, QString *error);
+
+    qint64 size() const;
+    bool isEmpty() const;
+
+    // 第一条记录的时间
+    gtime_t startTime() const;
+
+    // 有记录的卫星号
+    QVector<int> satellites() const;
+
+    // 卫星sat第frq个频率(1:L1,2:L2,...)在时间窗[ts, te]内的记录，时间为0表示不限
+    QVector<solstat_t> residuals(int sat, int frq, gtime_t ts, gtime_t te) const;
+
+    // 时间窗[ts, te]内系统sys (SYS_???，SYS_ALL为全部)的拒绝次数
+    int rejects(int sys, gtime_t ts, gtime_t te) const;
+
+    // 占用的内存 (byte)
+    qint64 bytes() const;
+
+private:
+    struct Series;
+
+    const Series *series(int sat, int frq) const;
+    void range(const Series &series, gtime_t ts, gtime_t te, int *first, int *last) const;
+
+    std::vector<Series> m_series;  // [卫星号-1][频率-1]
+    gtime_t m_origin;              // 记录时间的起点
+    qint64 m_size;
+};
+
+#endif // PPPRESIDUALSTORE_H
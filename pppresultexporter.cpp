@@ -0,0 +1,409 @@
+#include "pppresultexporter.h"
+#include "pppsolutionfile.h"
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+#include <charconv>
+#include <cstring>
+#include <vector>
+
+static const int CHUNK_BYTES = 1 << 20;   // 每次写出的字节数
+static const int ROW_BYTES = 4096;        // 一行输出的最大长度
+
+// KML点的颜色 (aabbggrr)，按解算质量，与convkml按质量着色时相同
+static const char *const KML_COLORS[] = {
+    "ffffffff", "ff008800", "ff00aaff", "ffff00ff", "ff00ffff", "ff0000ff", "ffffffff"
+};
+
+static char *putText(char *p, const char *text)
+{
+    size_t n = strlen(text);
+    memcpy(p, text, n);
+    return p + n;
+}
+
+static char *putFixed(char *p, double value, int precision)
+{
+    return std::to_chars(p, p + 64, value, std::chars_format::fixed, precision).ptr;
+}
+
+static char *putInt(char *p, int value)
+{
+    return std::to_chars(p, p + 16, value).ptr;
+}
+
+static char *putDigits(char *p, int value, int width)
+{
+    for (int i = width - 1; i >= 0; i--) {
+        p[i] = char('0' + value % 10);
+        value /= 10;
+    }
+    return p + width;
+}
+
+// 与time2str(t, s, 3)相同的时间 (yyyy/mm/dd hh:mm:ss.sss)，iso为ISO 8601格式 (yyyy-mm-ddThh:mm:ss.sssZ)
+static char *putTime(char *p, gtime_t t, bool iso)
+{
+    double ep[6];
+    if (1.0 - t.sec < 0.0005) {
+        t.time++;
+        t.sec = 0.0;
+    }
+    time2epoch(t, ep);
+    int ms = int(ep[5] * 1000.0 + 0.5);
+    p = putDigits(p, int(ep[0]), 4);
+    *p++ = iso ? '-' : '/';
+    p = putDigits(p, int(ep[1]), 2);
+    *p++ = iso ? '-' : '/';
+    p = putDigits(p, int(ep[2]), 2);
+    *p++ = iso ? 'T' : ' ';
+    p = putDigits(p, int(ep[3]), 2);
+    *p++ = ':';
+    p = putDigits(p, int(ep[4]), 2);
+    *p++ = ':';
+    p = putDigits(p, ms / 1000, 2);
+    *p++ = '.';
+    p = putDigits(p, ms % 1000, 3);
+    if (iso) *p++ = 'Z';
+    return p;
+}
+
+// 按块写出的导出过程，progress按全部的行数（多遍输出时为各遍之和）计算
+class ResultWriter
+{
+public:
+    ResultWriter(QSaveFile *file, qint64 total, const std::atomic<bool> *cancel,
+                 const std::function<void(int)> &progress)
+        : m_file(file), m_buffer(CHUNK_BYTES + ROW_BYTES), m_pos(m_buffer.data()), m_total(qMax<qint64>(total, 1)),
+          m_done(0), m_percent(-1), m_cancel(cancel), m_progress(progress), m_cancelled(false)
+    {
+    }
+
+    bool put(const char *text)
+    {
+        m_pos = putText(m_pos, text);
+        return flush(false);
+    }
+
+    // 对每个序号调用row(p, i)格式化一行，返回写入后的位置
+    template <typename Row>
+    bool rows(int n, Row row)
+    {
+        for (int i = 0; i < n; i++) {
+            m_pos = row(m_pos, i);
+            if (m_pos - m_buffer.data() >= CHUNK_BYTES && (!flush(true) || !report(m_done + i + 1))) {
+                return false;
+            }
+        }
+        m_done += n;
+        return true;
+    }
+
+    // 直接写出数据（二进制的各列），count为计入进度的行数
+    bool raw(const char *data, qint64 size, qint64 count)
+    {
+        if (!flush(true)) return false;
+        for (qint64 offset = 0; offset < size; offset += CHUNK_BYTES) {
+            qint64 n = qMin<qint64>(CHUNK_BYTES, size - offset);
+            if (m_file->write(data + offset, n) != n) return false;
+            if (!report(m_done + count * (offset + n) / qMax<qint64>(size, 1))) return false;
+        }
+        m_done += count;
+        return true;
+    }
+
+    bool finish()
+    {
+        return flush(true) && report(m_total);
+    }
+
+    bool cancelled() const
+    {
+        return m_cancelled;
+    }
+
+private:
+    bool flush(bool force)
+    {
+        qint64 n = m_pos - m_buffer.data();
+        if (n == 0 || (!force && n < CHUNK_BYTES)) {
+            return true;
+        }
+        m_pos = m_buffer.data();
+        return m_file->write(m_buffer.data(), n) == n;
+    }
+
+    bool report(qint64 done)
+    {
+        if (m_cancel && *m_cancel) {
+            m_cancelled = true;
+            return false;
+        }
+        int percent = int(qMin<qint64>(done, m_total) * 100 / m_total);
+        if (percent != m_percent) {
+            m_percent = percent;
+            if (m_progress) m_progress(percent);
+        }
+        return true;
+    }
+
+    QSaveFile *m_file;
+    std::vector<char> m_buffer;
+    char *m_pos;
+    qint64 m_total;
+    qint64 m_done;
+    int m_percent;
+    const std::atomic<bool> *m_cancel;
+    const std::function<void(int)> &m_progress;
+    bool m_cancelled;
+};
+
+static bool writeCsv(const PPPResultColumns &r, ResultWriter *out)
+{
+    return out->put("时间,纬度(度),经度(度),高程(m),解算质量,卫星数,sdn(m),sde(m),sdu(m),sdne(m),sdeu(m),sdun(m)\n") &&
+           out->rows(r.size(), [&r](char *p, int i) {
+               p = putTime(p, r.time[i], false);
+               *p++ = ',';
+               p = putFixed(p, r.lat[i], 9);
+               *p++ = ',';
+               p = putFixed(p, r.lon[i], 9);
+               *p++ = ',';
+               p = putFixed(p, r.height[i], 4);
+               *p++ = ',';
+               p = putInt(p, r.quality[i]);
+               *p++ = ',';
+               p = putInt(p, r.ns[i]);
+               const float *sd[] = { r.sdn.constData(), r.sde.constData(), r.sdu.constData(),
+                                     r.sdne.constData(), r.sdeu.constData(), r.sdun.constData() };
+               for (const float *column : sd) {
+                   *p++ = ',';
+                   p = putFixed(p, column[i], 4);
+               }
+               *p++ = '\n';
+               return p;
+           }) &&
+           out->finish();
+}
+
+static bool writeGeoJson(const PPPResultColumns &r, ResultWriter *out)
+{
+    return out->put("{\"type\":\"FeatureCollection\",\"features\":[\n") &&
+           out->rows(r.size(), [&r](char *p, int i) {
+               if (i > 0) p = putText(p, ",\n");
+               p = putText(p, "{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[");
+               p = putFixed(p, r.lon[i], 9);
+               *p++ = ',';
+               p = putFixed(p, r.lat[i], 9);
+               *p++ = ',';
+               p = putFixed(p, r.height[i], 4);
+               p = putText(p, "]},\"properties\":{\"time\":\"");
+               p = putTime(p, gpst2utc(r.time[i]), true);
+               p = putText(p, "\",\"quality\":");
+               p = putInt(p, r.quality[i]);
+               p = putText(p, ",\"ns\":");
+               p = putInt(p, r.ns[i]);
+               p = putText(p, ",\"sdn\":");
+               p = putFixed(p, r.sdn[i], 4);
+               p = putText(p, ",\"sde\":");
+               p = putFixed(p, r.sde[i], 4);
+               p = putText(p, ",\"sdu\":");
+               p = putFixed(p, r.sdu[i], 4);
+               p = putText(p, "}}");
+               return p;
+           }) &&
+           out->put("\n]}\n") && out->finish();
+}
+
+static bool writeKml(const PPPResultColumns &r, ResultWriter *out)
+{
+    // 与convkml相同：轨迹线，然后是各历元的点（不输出高度，贴地显示）
+    char style[512];
+    if (!out->put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<kml xmlns=\"http://earth.google.com/kml/2.1\">\n"
+                  "<Document>\n")) {
+        return false;
+    }
+    for (int q = 1; q <= 6; q++) {
+        snprintf(style, sizeof(style),
+                 "<Style id=\"P%d\">\n  <IconStyle>\n    <color>%s</color>\n    <scale>0.3</scale>\n"
+                 "    <Icon><href>http://maps.google.com/mapfiles/kml/pal2/icon18.png</href></Icon>\n"
+                 "  </IconStyle>\n</Style>\n",
+                 q, KML_COLORS[q]);
+        if (!out->put(style)) return false;
+    }
+    return out->put("<Placemark>\n<name>Rover Track</name>\n<Style>\n<LineStyle>\n<color>ff00ffff</color>\n"
+                    "</LineStyle>\n</Style>\n<LineString>\n<coordinates>\n") &&
+           out->rows(r.size(), [&r](char *p, int i) {
+               p = putFixed(p, r.lon[i], 9);
+               *p++ = ',';
+               p = putFixed(p, r.lat[i], 9);
+               return putText(p, ",0.000\n");
+           }) &&
+           out->put("</coordinates>\n</LineString>\n</Placemark>\n<Folder>\n<name>Rover Position</name>\n") &&
+           out->rows(r.size(), [&r](char *p, int i) {
+               int q = r.quality[i] >= 1 && r.quality[i] <= 6 ? r.quality[i] : 6;
+               p = putText(p, "<Placemark>\n<styleUrl>#P");
+               p = putInt(p, q);
+               p = putText(p, "</styleUrl>\n<TimeStamp><when>");
+               p = putTime(p, gpst2utc(r.time[i]), true);
+               p = putText(p, "</when></TimeStamp>\n<Point>\n<coordinates>");
+               p = putFixed(p, r.lon[i], 9);
+               *p++ = ',';
+               p = putFixed(p, r.lat[i], 9);
+               return putText(p, ",0.000</coordinates>\n</Point>\n</Placemark>\n");
+           }) &&
+           out->put("</Folder>\n</Document>\n</kml>\n") && out->finish();
+}
+
+// 表格的一行还原为sol_t：位置转为ECEF，ENU标准差（协方差项带符号）还原为ECEF协方差
+static void rowSolution(const PPPResultColumns &r, int i, sol_t *sol)
+{
+    memset(sol, 0, sizeof(sol_t));
+    sol->time = r.time[i];
+    sol->stat = r.quality[i];
+    sol->ns = r.ns[i];
+    sol->age = r.age[i];
+    sol->ratio = r.ratio[i];
+
+    double pos[3] = { r.lat[i] * D2R, r.lon[i] * D2R, r.height[i] };
+    pos2ecef(pos, sol->rr);
+    auto var = [](double sd) { return sd < 0.0 ? -sd * sd : sd * sd; };
+    double Q[9], P[9];
+    Q[0] = var(r.sde[i]);
+    Q[4] = var(r.sdn[i]);
+    Q[8] = var(r.sdu[i]);
+    Q[1] = Q[3] = var(r.sdne[i]);
+    Q[2] = Q[6] = var(r.sdeu[i]);
+    Q[5] = Q[7] = var(r.sdun[i]);
+    covecef(pos, Q, P);
+    sol->qr[0] = float(P[0]);
+    sol->qr[1] = float(P[4]);
+    sol->qr[2] = float(P[8]);
+    sol->qr[3] = float(P[1]);
+    sol->qr[4] = float(P[5]);
+    sol->qr[5] = float(P[2]);
+}
+
+static bool writeBinary(const PPPResultColumns &r, ResultWriter *out)
+{
+    // 与solformat = binary的结果文件相同（PPPSolutionFile），无解的历元与写出时一样忽略
+    QByteArray header(PPPSolutionFile::headerSize(), '\0');
+    PPPSolutionFile::encodeHeader(header.data());
+    if (!out->raw(header.constData(), header.size(), 0)) {
+        return false;
+    }
+    QVector<gtime_t> times;
+    times.reserve(r.size());
+    sol_t sol;
+    bool ok = out->rows(r.size(), [&r, &times, &sol](char *p, int i) {
+        if (r.quality[i] <= SOLQ_NONE) {
+            return p;
+        }
+        rowSolution(r, i, &sol);
+        PPPSolutionFile::encode(sol, p);
+        times.append(r.time[i]);
+        return p + PPPSolutionFile::recordSize();
+    });
+    if (!ok) {
+        return false;
+    }
+    QByteArray index = PPPSolutionFile::encodeIndex(times);
+    return out->raw(index.constData(), index.size(), 0) && out->finish();
+}
+
+PPPResultExporter::PPPResultExporter(QObject *parent)
+    : QObject(parent), m_worker(nullptr), m_running(false), m_cancelRequested(false)
+{
+}
+
+PPPResultExporter::~PPPResultExporter()
+{
+    // 取消仍在进行的导出并等待工作线程退出
+    if (m_worker) {
+        cancel();
+        m_worker->wait();
+        delete m_worker;
+        m_worker = nullptr;
+    }
+}
+
+PPPResultExporter::Format PPPResultExporter::formatForFile(const QString &path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "geojson" || suffix == "json") return FormatGeoJson;
+    if (suffix == "kml") return FormatKml;
+    if (suffix == "bin") return FormatBinary;
+    return FormatCsv;
+}
+
+bool PPPResultExporter::start(const PPPResultColumns &results, const QString &path, Format format)
+{
+    if (m_running) {
+        return false;
+    }
+
+    // 回收上一次导出的线程
+    if (m_worker) {
+        m_worker->wait();
+        delete m_worker;
+        m_worker = nullptr;
+    }
+
+    m_running = true;
+    m_cancelRequested = false;
+    m_worker = QThread::create([this, results, path, format]() {
+        QString error;
+        bool success = write(results, path, format, &m_cancelRequested,
+                             [this](int percent) { emit progress(percent); }, &error);
+        m_running = false;
+        emit finished(success, error);
+    });
+    m_worker->start();
+    return true;
+}
+
+void PPPResultExporter::cancel()
+{
+    m_cancelRequested = true;
+}
+
+bool PPPResultExporter::isRunning() const
+{
+    return m_running;
+}
+
+bool PPPResultExporter::wasCancelled() const
+{
+    return m_cancelRequested;
+}
+
+bool PPPResultExporter::write(const PPPResultColumns &results, const QString &path, Format format,
+                              const std::atomic<bool> *cancel, const std::function<void(int)> &progress,
+                              QString *error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = "无法创建导出文件：" + path;
+        return false;
+    }
+    // 进度按输出的行数计算：KML输出轨迹和点两遍
+    qint64 total = results.size();
+    if (format == FormatKml) total *= 2;
+    ResultWriter out(&file, total, cancel, progress);
+    bool ok = false;
+    switch (format) {
+        case FormatCsv: ok = writeCsv(results, &out); break;
+        case FormatGeoJson: ok = writeGeoJson(results, &out); break;
+        case FormatKml: ok = writeKml(results, &out); break;
+        case FormatBinary: ok = writeBinary(results, &out); break;
+    }
+    if (!ok) {
+        file.cancelWriting();
+        *error = out.cancelled() ? QString("导出已取消") : "写入导出文件失败：" + path;
+        return false;
+    }
+    if (!file.commit()) {
+        *error = "写入导出文件失败：" + path;
+        return false;
+    }
+    return true;
+}
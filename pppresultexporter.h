@@ -0,0 +1,61 @@
+#ifndef PPPRESULTEXPORTER_H
+#define PPPRESULTEXPORTER_H
+
+#include "pppresultmodel.h"
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+class QThread;
+
+// 解算结果导出
+// 在工作线程中按块格式化并写出结果，数字用std::to_chars直接写入缓冲区，不创建QString，
+// 导出速度主要受磁盘写入限制。导出写入临时文件，完成后替换目标文件，取消或失败时不留下不完整的文件。
+// 支持的格式：
+//   CSV      与结果表格相同的各列
+//   GeoJSON  每个历元一个Point要素，属性为时间（UTC）、解算质量、卫星数和标准差
+//   KML      与RTKLIB的convkml相同的结构：轨迹线和按解算质量着色的点，点带时间戳
+//   二进制   与solformat = binary相同的结果文件（PPPSolutionFile），界面和--sol2pos可以直接读取
+class PPPResultExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        FormatCsv,
+        FormatGeoJson,
+        FormatKml,
+        FormatBinary
+    };
+
+    explicit PPPResultExporter(QObject *parent = nullptr);
+    ~PPPResultExporter();
+
+    // 按扩展名确定格式，无法识别时返回CSV
+    static Format formatForFile(const QString &path);
+
+    // 在工作线程中导出（立即返回，进度和结果通过信号通知）
+    bool start(const PPPResultColumns &results, const QString &path, Format format);
+
+    // 请求取消，导出在写完当前块后停止
+    void cancel();
+
+    bool isRunning() const;
+    bool wasCancelled() const;
+
+    // 在调用线程中同步导出，progress为完成的百分比（可为空）
+    static bool write(const PPPResultColumns &results, const QString &path, Format format,
+                      const std::atomic<bool> *cancel, const std::function<void(int)> &progress, QString *error);
+
+signals:
+    void progress(int percent);
+    void finished(bool success, const QString &message);
+
+private:
+    QThread *m_worker;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancelRequested;
+};
+
+#endif // PPPRESULTEXPORTER_H
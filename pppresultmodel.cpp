@@ -0,0 +1,226 @@
+#include "pppresultmodel.h"
+#include <algorithm>
+#include <numeric>
+
+int PPPResultColumns::size() const
+{
+    return time.size();
+}
+
+bool PPPResultColumns::isEmpty() const
+{
+    return time.isEmpty();
+}
+
+void PPPResultColumns::reserve(int n)
+{
+    time.reserve(n);
+    lat.reserve(n);
+    lon.reserve(n);
+    height.reserve(n);
+    quality.reserve(n);
+    ns.reserve(n);
+    sdn.reserve(n);
+    sde.reserve(n);
+    sdu.reserve(n);
+    sdne.reserve(n);
+    sdeu.reserve(n);
+    sdun.reserve(n);
+    age.reserve(n);
+    ratio.reserve(n);
+}
+
+void PPPResultColumns::append(const PosRecord &record)
+{
+    time.append(record.time);
+    lat.append(record.lat);
+    lon.append(record.lon);
+    height.append(record.height);
+    quality.append(quint8(record.quality));
+    ns.append(quint8(record.ns));
+    sdn.append(float(record.sdn));
+    sde.append(float(record.sde));
+    sdu.append(float(record.sdu));
+    sdne.append(float(record.sdne));
+    sdeu.append(float(record.sdeu));
+    sdun.append(float(record.sdun));
+    age.append(float(record.age));
+    ratio.append(float(record.ratio));
+}
+
+PosRecord PPPResultColumns::record(int i) const
+{
+    PosRecord record;
+    record.time = time[i];
+    record.lat = lat[i];
+    record.lon = lon[i];
+    record.height = height[i];
+    record.quality = quality[i];
+    record.ns = ns[i];
+    record.sdn = sdn[i];
+    record.sde = sde[i];
+    record.sdu = sdu[i];
+    record.sdne = sdne[i];
+    record.sdeu = sdeu[i];
+    record.sdun = sdun[i];
+    record.age = age[i];
+    record.ratio = ratio[i];
+    return record;
+}
+
+PPPResultModel::PPPResultModel(QObject *parent)
+    : QAbstractTableModel(parent), m_sortColumn(-1), m_sortOrder(Qt::AscendingOrder)
+{
+}
+
+void PPPResultModel::setResults(const PPPResultColumns &results)
+{
+    beginResetModel();
+    m_results = results;
+    sortRows();
+    endResetModel();
+}
+
+void PPPResultModel::clear()
+{
+    setResults(PPPResultColumns());
+}
+
+const PPPResultColumns &PPPResultModel::results() const
+{
+    return m_results;
+}
+
+int PPPResultModel::resultIndex(int row) const
+{
+    return m_order.isEmpty() ? row : m_order[row];
+}
+
+int PPPResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_results.size();
+}
+
+int PPPResultModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QString PPPResultModel::qualityText(int quality)
+{
+    switch (quality) {
+        case 1: return "1-固定解";
+        case 2: return "2-浮点解";
+        case 3: return "3-SBAS";
+        case 4: return "4-DGPS";
+        case 5: return "5-单点定位";
+        case 6: return "6-PPP";
+        default: return QString::number(quality);
+    }
+}
+
+QVariant PPPResultModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= m_results.size()) {
+        return QVariant();
+    }
+    int i = resultIndex(index.row());
+    switch (index.column()) {
+        case TimeColumn: {
+            char buff[64];
+            time2str(m_results.time[i], buff, 3);
+            return QString::fromLatin1(buff);
+        }
+        case LatColumn: return QString::number(m_results.lat[i], 'f', 9);
+        case LonColumn: return QString::number(m_results.lon[i], 'f', 9);
+        case HeightColumn: return QString::number(m_results.height[i], 'f', 4);
+        case QualityColumn: return qualityText(m_results.quality[i]);
+        case SatellitesColumn: return QString::number(m_results.ns[i]);
+        case SdnColumn: return QString::number(m_results.sdn[i], 'f', 4);
+        case SdeColumn: return QString::number(m_results.sde[i], 'f', 4);
+        case SduColumn: return QString::number(m_results.sdu[i], 'f', 4);
+        case SdneColumn: return QString::number(m_results.sdne[i], 'f', 4);
+        case SdeuColumn: return QString::number(m_results.sdeu[i], 'f', 4);
+        case SdunColumn: return QString::number(m_results.sdun[i], 'f', 4);
+        default: return QVariant();
+    }
+}
+
+QVariant PPPResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    static const char *const HEADERS[ColumnCount] = {
+        "时间", "纬度(°)", "经度(°)", "高程(m)", "解算质量", "卫星数",
+        "sdn(m)", "sde(m)", "sdu(m)", "sdne(m)", "sdeu(m)", "sdun(m)"
+    };
+    if (role == Qt::DisplayRole && orientation == Qt::Horizontal && section >= 0 && section < ColumnCount) {
+        return QString(HEADERS[section]);
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+void PPPResultModel::sort(int column, Qt::SortOrder order)
+{
+    if (column == m_sortColumn && order == m_sortOrder) {
+        return;
+    }
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    // 选中的行等持久索引按结果序号映射到新的显示位置
+    QModelIndexList from = persistentIndexList();
+    QVector<int> indexes;
+    indexes.reserve(from.size());
+    for (const QModelIndex &index : from) {
+        indexes.append(resultIndex(index.row()));
+    }
+
+    m_sortColumn = column;
+    m_sortOrder = order;
+    sortRows();
+
+    QVector<int> rows(m_results.size());
+    for (int row = 0; row < rows.size(); row++) {
+        rows[resultIndex(row)] = row;
+    }
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (int k = 0; k < from.size(); k++) {
+        to.append(index(rows[indexes[k]], from[k].column()));
+    }
+    changePersistentIndexList(from, to);
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+void PPPResultModel::sortRows()
+{
+    m_order.clear();
+    int n = m_results.size();
+    if (m_sortColumn < 0 || m_sortColumn >= ColumnCount || n == 0) {
+        return;
+    }
+
+    // 先取出排序列的数值，比较时不再按列分支；稳定排序使相同值保持原顺序
+    QVector<double> keys(n);
+    for (int i = 0; i < n; i++) {
+        switch (m_sortColumn) {
+            case TimeColumn: keys[i] = double(m_results.time[i].time) + m_results.time[i].sec; break;
+            case LatColumn: keys[i] = m_results.lat[i]; break;
+            case LonColumn: keys[i] = m_results.lon[i]; break;
+            case HeightColumn: keys[i] = m_results.height[i]; break;
+            case QualityColumn: keys[i] = m_results.quality[i]; break;
+            case SatellitesColumn: keys[i] = m_results.ns[i]; break;
+            case SdnColumn: keys[i] = m_results.sdn[i]; break;
+            case SdeColumn: keys[i] = m_results.sde[i]; break;
+            case SduColumn: keys[i] = m_results.sdu[i]; break;
+            case SdneColumn: keys[i] = m_results.sdne[i]; break;
+            case SdeuColumn: keys[i] = m_results.sdeu[i]; break;
+            case SdunColumn: keys[i] = m_results.sdun[i]; break;
+        }
+    }
+    m_order.resize(n);
+    std::iota(m_order.begin(), m_order.end(), 0);
+    if (m_sortOrder == Qt::AscendingOrder) {
+        std::stable_sort(m_order.begin(), m_order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+    } else {
+        std::stable_sort(m_order.begin(), m_order.end(), [&keys](int a, int b) { return keys[a] > keys[b]; });
+    }
+}
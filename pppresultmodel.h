@@ -0,0 +1,82 @@
+#ifndef PPPRESULTMODEL_H
+#define PPPRESULTMODEL_H
+
+#include "posfile.h"
+#include "rtklib.h"
+#include <QAbstractTableModel>
+#include <QVector>
+
+// 按列存储的解算结果，各列等长，可在工作线程中建立后交给界面（QVector隐式共享，传递不复制数据）
+// 标准差、龄期和比值用float保存，.pos文件中只有4位小数
+struct PPPResultColumns {
+    QVector<gtime_t> time;
+    QVector<double> lat, lon;     // 纬度/经度 (deg)
+    QVector<double> height;       // 高程 (m)
+    QVector<quint8> quality;      // 解算质量 (SOLQ_???)
+    QVector<quint8> ns;           // 卫星数
+    QVector<float> sdn, sde, sdu;
+    QVector<float> sdne, sdeu, sdun;
+    QVector<float> age, ratio;
+
+    int size() const;
+    bool isEmpty() const;
+    void reserve(int n);
+    void append(const PosRecord &record);
+    PosRecord record(int i) const;
+};
+
+// 结果表格的数据模型
+// 表格只请求可见的单元格，文本在data()中按需格式化，不为每个历元创建表格项。
+// 排序只生成显示顺序的索引表，不移动结果数据，导出等仍按原顺序访问results()。
+class PPPResultModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        TimeColumn,
+        LatColumn,
+        LonColumn,
+        HeightColumn,
+        QualityColumn,
+        SatellitesColumn,
+        SdnColumn,
+        SdeColumn,
+        SduColumn,
+        SdneColumn,
+        SdeuColumn,
+        SdunColumn,
+        ColumnCount
+    };
+
+    explicit PPPResultModel(QObject *parent = nullptr);
+
+    // 设置结果数据，保持当前的排序方式
+    void setResults(const PPPResultColumns &results);
+    void clear();
+    const PPPResultColumns &results() const;
+
+    // 显示顺序的第row行对应的结果序号
+    int resultIndex(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // column<0时恢复原顺序
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // 解算质量的说明文字
+    static QString qualityText(int quality);
+
+private:
+    void sortRows();
+
+    PPPResultColumns m_results;
+    QVector<int> m_order;     // 显示顺序，为空则按原顺序
+    int m_sortColumn;
+    Qt::SortOrder m_sortOrder;
+};
+
+#endif // PPPRESULTMODEL_H
@@ -0,0 +1,264 @@
+#include "pppshardrunner.h"
+#include "posfile.h"
+#include <QFile>
+#include <cmath>
+#include <cstdio>
+
+// 接缝处两个分片位置差异的最小容许值 (m)，实际容许值取 3 倍合成标准差与该值的较大者
+static const double SEAM_MIN_TOLERANCE = 0.05;
+// 历元时间比较的容差 (s)
+static const double SEAM_TIME_TOLERANCE = 1E-3;
+
+PPPShardRunner::PPPShardRunner(QObject *parent)
+    : QObject(parent), m_seamFailures(0)
+{
+    PPPProcessor::initPaths(&m_job);
+    connect(&m_engine, &PPPBatchEngine::jobFinished, this, &PPPShardRunner::shardFinished);
+    connect(&m_engine, &PPPBatchEngine::finished, this, &PPPShardRunner::onBatchFinished);
+}
+
+void PPPShardRunner::setWorkerProgram(const QString &program)
+{
+    m_engine.setWorkerProgram(program);
+}
+
+void PPPShardRunner::setWorkerCount(int count)
+{
+    m_engine.setWorkerCount(count);
+}
+
+const QStringList &PPPShardRunner::seamReport() const
+{
+    return m_seamReport;
+}
+
+int PPPShardRunner::seamFailures() const
+{
+    return m_seamFailures;
+}
+
+bool PPPShardRunner::start(const ppp_paths_t &job, QString *error)
+{
+    if (m_engine.isRunning()) {
+        *error = "分片处理正在进行中";
+        return false;
+    }
+    if (!job.use_time_range) {
+        *error = "分片处理需要指定开始和结束时间 (ts/te)";
+        return false;
+    }
+    if (job.shards < 2) {
+        *error = "分片数必须大于1";
+        return false;
+    }
+    gtime_t ts = epoch2time(job.ts);
+    gtime_t te = epoch2time(job.te);
+    double span = timediff(te, ts);
+    if (span <= 0.0) {
+        *error = "结束时间必须晚于开始时间";
+        return false;
+    }
+
+    m_job = job;
+    m_windows.clear();
+    m_seamReport.clear();
+    m_seamFailures = 0;
+    double length = span / job.shards;
+    for (int i = 0; i < job.shards; i++) {
+        Window window;
+        window.start = timeadd(ts, length * i);
+        window.end = i == job.shards - 1 ? te : timeadd(ts, length * (i + 1));
+        window.outFile = QString("%1.shard%2").arg(QString::fromLocal8Bit(job.out_file)).arg(i, 2, 10, QChar('0'));
+        m_windows.append(window);
+
+        // 每个分片从窗口开始前 overlap 秒起算，前段仅用于滤波收敛
+        gtime_t start = window.start;
+        if (i > 0) {
+            start = timeadd(window.start, -job.shard_overlap);
+            if (timediff(start, ts) < 0.0) start = ts;
+        }
+        ppp_paths_t shard = job;
+        shard.shards = 0;
+        time2epoch(start, shard.ts);
+        time2epoch(window.end, shard.te);
+        qstrncpy(shard.out_file, window.outFile.toLocal8Bit().constData(), sizeof(shard.out_file));
+        m_engine.addJob(shard);
+    }
+    if (!m_engine.start()) {
+        *error = "无法启动分片工作进程";
+        return false;
+    }
+    return true;
+}
+
+void PPPShardRunner::cancel()
+{
+    m_engine.cancel();
+}
+
+void PPPShardRunner::onBatchFinished(int succeeded, int failed)
+{
+    Q_UNUSED(succeeded);
+    if (failed > 0) {
+        // 保留分片文件便于排查
+        emit finished(false, QString("%1 个分片处理失败").arg(failed));
+        return;
+    }
+    QString message;
+    bool success = stitch(&message) && stitchStat(&message);
+    if (success) {
+        removeShardFiles();
+    }
+    emit finished(success, message);
+}
+
+bool PPPShardRunner::keep(const Window &window, gtime_t time, bool last)
+{
+    // 窗口为 [start, end)，最后一个分片包含结束时刻
+    double t0 = timediff(time, window.start);
+    double t1 = timediff(time, window.end);
+    return t0 >= -SEAM_TIME_TOLERANCE && (last ? t1 <= SEAM_TIME_TOLERANCE : t1 <= -SEAM_TIME_TOLERANCE);
+}
+
+bool PPPShardRunner::stitch(QString *message)
+{
+    const int n = m_windows.size();
+    QVector<PosFileData> shards(n);
+    for (int i = 0; i < n; i++) {
+        if (!PosFile::read(m_windows[i].outFile, &shards[i], message)) {
+            return false;
+        }
+    }
+
+    QFile out(QString::fromLocal8Bit(m_job.out_file));
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *message = QString("无法创建输出文件: %1").arg(out.fileName());
+        return false;
+    }
+
+    // 头部取第一个分片，在列标题行之前注明分片信息
+    QList<QByteArray> header = shards[0].header;
+    QByteArray note = QString("% shards    : %1 windows, overlap %2 s\n").arg(n).arg(m_job.shard_overlap).toLatin1();
+    header.insert(header.isEmpty() ? 0 : header.size() - 1, note);
+    for (const QByteArray &line : header) {
+        out.write(line);
+    }
+
+    int epochs = 0, warnings = 0;
+    const PosRecord *lastKept = nullptr;
+    for (int i = 0; i < n; i++) {
+        const Window &window = m_windows[i];
+        const PosFileData &data = shards[i];
+        bool last = i == n - 1;
+        const PosRecord *firstKept = nullptr;
+
+        for (int j = 0; j < data.records.size(); j++) {
+            const PosRecord &record = data.records[j];
+            if (!keep(window, record.time, last)) {
+                continue;
+            }
+            if (!firstKept) firstKept = &record;
+            out.write(data.lines[j]);
+            epochs++;
+        }
+
+        // 接缝连续性：比较上一分片在接缝前的最后一个历元与本分片重叠段中的同一历元
+        QString seam = QString("接缝 %1/%2").arg(i).arg(i + 1);
+        if (i == 0) {
+            // 第一个分片没有前接缝
+        } else if (!lastKept || !firstKept) {
+            m_seamReport.append(seam + ": 接缝一侧无有效历元");
+            warnings++;
+        } else {
+            const PosRecord *overlap = nullptr;
+            for (const PosRecord &record : data.records) {
+                if (fabs(timediff(record.time, lastKept->time)) <= SEAM_TIME_TOLERANCE) {
+                    overlap = &record;
+                    break;
+                }
+            }
+            double gap = timediff(firstKept->time, lastKept->time);
+            QString text;
+            if (m_job.ti > 0.0 && gap > m_job.ti * 1.5) {
+                text = QString("%1: 时间间断 %2 s").arg(seam).arg(gap, 0, 'f', 1);
+                warnings++;
+            } else if (!overlap) {
+                text = QString("%1: 重叠段无公共历元，无法检查连续性").arg(seam);
+                warnings++;
+            } else {
+                double a[3], b[3], d = 0.0;
+                PosFile::toEcef(*lastKept, a);
+                PosFile::toEcef(*overlap, b);
+                for (int k = 0; k < 3; k++) d += (a[k] - b[k]) * (a[k] - b[k]);
+                d = sqrt(d);
+                double sigma = sqrt(lastKept->sdn * lastKept->sdn + lastKept->sde * lastKept->sde +
+                                    lastKept->sdu * lastKept->sdu + overlap->sdn * overlap->sdn +
+                                    overlap->sde * overlap->sde + overlap->sdu * overlap->sdu);
+                double tolerance = qMax(SEAM_MIN_TOLERANCE, 3.0 * sigma);
+                text = QString("%1: 位置差异 %2 m (容许 %3 m)").arg(seam).arg(d, 0, 'f', 3).arg(tolerance, 0, 'f', 3);
+                if (d > tolerance) {
+                    text += "，超限";
+                    warnings++;
+                }
+            }
+            m_seamReport.append(text);
+        }
+        for (const PosRecord &record : data.records) {
+            if (keep(window, record.time, last)) {
+                lastKept = &record;
+            }
+        }
+    }
+    out.close();
+
+    m_seamFailures = warnings;
+    *message = QString("分片拼接完成: %1 个历元，%2 个接缝").arg(epochs).arg(n - 1);
+    if (warnings > 0) {
+        *message += QString("，%1 个接缝未通过检查").arg(warnings);
+    }
+    return true;
+}
+
+bool PPPShardRunner::stitchStat(QString *message)
+{
+    // 各分片的状态文件按与.pos相同的窗口保留历元后依次拼接，分片均未生成状态文件时不输出
+    QFile out(QString::fromLocal8Bit(m_job.out_file) + ".stat");
+    const int n = m_windows.size();
+    int files = 0;
+    for (int i = 0; i < n; i++) {
+        QFile in(m_windows[i].outFile + ".stat");
+        if (!in.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        if (files++ == 0 && !out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            *message = QString("无法创建状态文件: %1").arg(out.fileName());
+            return false;
+        }
+        bool last = i == n - 1;
+        while (!in.atEnd()) {
+            // 每行为 "$类型,GPS周,周内秒,..."
+            QByteArray line = in.readLine();
+            int comma = line.indexOf(',');
+            int week;
+            double tow;
+            if (comma < 0 || sscanf(line.constData() + comma + 1, "%d,%lf", &week, &tow) != 2) {
+                continue;
+            }
+            if (keep(m_windows[i], gpst2time(week, tow), last)) {
+                out.write(line);
+            }
+        }
+    }
+    if (files > 0 && files < n) {
+        *message += QString("，%1 个分片没有状态文件").arg(n - files);
+    }
+    return true;
+}
+
+void PPPShardRunner::removeShardFiles()
+{
+    for (const Window &window : m_windows) {
+        QFile::remove(window.outFile);
+        QFile::remove(window.outFile + ".stat");
+    }
+}
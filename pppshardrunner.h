@@ -0,0 +1,59 @@
+#ifndef PPPSHARDRUNNER_H
+#define PPPSHARDRUNNER_H
+
+#include "pppbatchengine.h"
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+// 时间窗分片并行处理
+// 将 [ts, te] 划分为 shards 个窗口，每个窗口向前多处理 shard_overlap 秒用于滤波收敛，
+// 各分片在独立的工作进程中并行处理，完成后丢弃收敛段并拼接成一个 .pos 文件（状态文件 .stat 按相同的窗口拼接），
+// 同时利用相邻分片在重叠段的公共历元检查接缝处的连续性。
+class PPPShardRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PPPShardRunner(QObject *parent = nullptr);
+
+    void setWorkerProgram(const QString &program);
+    void setWorkerCount(int count);
+
+    // 开始分片处理（异步，需要事件循环）
+    bool start(const ppp_paths_t &job, QString *error);
+    void cancel();
+
+    // 各接缝的连续性检查结果
+    const QStringList &seamReport() const;
+
+    // 未通过连续性检查的接缝数（位置超限、时间间断或无法检查），拼接成功时才有意义
+    int seamFailures() const;
+
+signals:
+    void shardFinished(int index, const PPPBatchResult &result);
+    void finished(bool success, const QString &message);
+
+private slots:
+    void onBatchFinished(int succeeded, int failed);
+
+private:
+    struct Window {
+        gtime_t start;     // 保留结果的起始时间
+        gtime_t end;       // 保留结果的结束时间（最后一个分片包含该时刻）
+        QString outFile;   // 分片输出文件
+    };
+
+    static bool keep(const Window &window, gtime_t time, bool last);
+    bool stitch(QString *message);
+    bool stitchStat(QString *message);
+    void removeShardFiles();
+
+    PPPBatchEngine m_engine;
+    ppp_paths_t m_job;
+    QVector<Window> m_windows;
+    QStringList m_seamReport;
+    int m_seamFailures;
+};
+
+#endif // PPPSHARDRUNNER_H
@@ -0,0 +1,401 @@
+#include "pppsolutionfile.h"
+#include <QByteArray>
+#include <QVector>
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+
+static const char SOLUTION_MAGIC[8] = { 'P', 'P', 'P', 'S', 'O', 'L', '0', '1' };
+static const char SOLUTION_INDEX_MAGIC[8] = { 'P', 'P', 'P', 'S', 'I', 'D', 'X', '1' };
+static const int INDEX_INTERVAL = 1024;  // 每个索引项对应的记录数
+
+struct SolutionFileHeader {
+    char magic[8];
+    quint32 recordSize;    // sizeof(Record)
+    quint32 interval;      // 索引间隔（记录数）
+};
+
+// 文件末尾的索引信息，其前为entries个索引项
+struct SolutionIndexTrailer {
+    qint64 records;        // 记录数
+    qint64 entries;        // 索引项数
+    char magic[8];
+};
+
+struct PPPSolutionFile::Record {
+    qint64 time;           // GPST (time_t)
+    double sec;
+    double rr[3];          // ECEF坐标 (m)
+    float qr[6];           // ECEF协方差 xx,yy,zz,xy,yz,zx (m^2)
+    quint8 stat;           // 解算质量 (SOLQ_???)
+    quint8 ns;             // 卫星数
+    quint16 reserved;
+    float age;             // 龄期 (s)
+    float ratio;           // 模糊度检验比值
+    quint32 reserved2;
+};
+
+// 结束记录，与解算记录等长，时间和解算质量的位置相同
+struct PPPSolutionFile::StopRecord {
+    qint64 time;
+    double sec;
+    double sigma;
+    double change;
+    double window;
+    double skipped;
+    quint8 reserved[16];
+    quint8 stat;           // SOLQ_NONE
+    quint8 type;           // STOP_RECORD
+    quint8 reserved2[14];
+};
+
+static const quint8 STOP_RECORD = 1;
+
+// 第k项为第k*interval条记录的时间
+struct PPPSolutionFile::IndexEntry {
+    qint64 time;
+    double sec;
+};
+
+// 记录时间早于t，orEqual时早于或等于t
+template <typename T>
+static bool earlier(const T &entry, gtime_t t, bool orEqual)
+{
+    return entry.time < qint64(t.time) ||
+           (entry.time == qint64(t.time) && (orEqual ? entry.sec <= t.sec : entry.sec < t.sec));
+}
+
+PPPSolutionFile::PPPSolutionFile()
+    : m_records(nullptr), m_index(nullptr), m_count(0), m_entries(0), m_interval(INDEX_INTERVAL)
+{
+    static_assert(sizeof(Record) == 80, "solution record size");
+    static_assert(sizeof(StopRecord) == sizeof(Record), "stop record size");
+    static_assert(offsetof(StopRecord, stat) == offsetof(Record, stat), "stop record layout");
+}
+
+PPPSolutionFile::~PPPSolutionFile()
+{
+}
+
+bool PPPSolutionFile::writeHeader(FILE *fp)
+{
+    char header[sizeof(SolutionFileHeader)];
+    encodeHeader(header);
+    return fwrite(header, sizeof(header), 1, fp) == 1;
+}
+
+bool PPPSolutionFile::writeRecord(FILE *fp, const sol_t &sol)
+{
+    if (sol.stat <= SOLQ_NONE) {
+        return true;
+    }
+    char record[sizeof(Record)];
+    encode(sol, record);
+    return fwrite(record, sizeof(record), 1, fp) == 1;
+}
+
+void PPPSolutionFile::encodeHeader(char *data)
+{
+    SolutionFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SOLUTION_MAGIC, sizeof(header.magic));
+    header.recordSize = sizeof(Record);
+    header.interval = INDEX_INTERVAL;
+    memcpy(data, &header, sizeof(header));
+}
+
+void PPPSolutionFile::encode(const sol_t &sol, char *data)
+{
+    Record record;
+    memset(&record, 0, sizeof(record));
+    record.time = qint64(sol.time.time);
+    record.sec = sol.time.sec;
+    for (int i = 0; i < 3; i++) record.rr[i] = sol.rr[i];
+    for (int i = 0; i < 6; i++) record.qr[i] = sol.qr[i];
+    record.stat = sol.stat;
+    record.ns = sol.ns;
+    record.age = sol.age;
+    record.ratio = sol.ratio;
+    memcpy(data, &record, sizeof(record));
+}
+
+QByteArray PPPSolutionFile::encodeIndex(const QVector<gtime_t> &times)
+{
+    QByteArray data;
+    for (int i = 0; i < times.size(); i += INDEX_INTERVAL) {
+        IndexEntry entry = { qint64(times[i].time), times[i].sec };
+        data.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    }
+    SolutionIndexTrailer trailer;
+    memcpy(trailer.magic, SOLUTION_INDEX_MAGIC, sizeof(trailer.magic));
+    trailer.records = times.size();
+    trailer.entries = (times.size() + INDEX_INTERVAL - 1) / INDEX_INTERVAL;
+    data.append(reinterpret_cast<const char *>(&trailer), sizeof(trailer));
+    return data;
+}
+
+bool PPPSolutionFile::writeStop(FILE *fp, const Stop &stop)
+{
+    StopRecord record;
+    memset(&record, 0, sizeof(record));
+    record.time = qint64(stop.time.time);
+    record.sec = stop.time.sec;
+    record.sigma = stop.sigma;
+    record.change = stop.change;
+    record.window = stop.window;
+    record.skipped = stop.skipped;
+    record.stat = SOLQ_NONE;
+    record.type = STOP_RECORD;
+    return fwrite(&record, sizeof(record), 1, fp) == 1;
+}
+
+void PPPSolutionFile::outputStop(FILE *fp, const Stop &stop)
+{
+    char str[64];
+    time2str(stop.time, str, 1);
+    fprintf(fp, "%s early stop: %s sigma=%.4fm change<%.4fm for %.0fs, %.0fs of obs skipped\n", COMMENTH, str,
+            stop.sigma, stop.change, stop.window, stop.skipped);
+}
+
+bool PPPSolutionFile::writeIndex(const char *path)
+{
+    QFile file(QString::fromLocal8Bit(path));
+    SolutionFileHeader header;
+    if (!file.open(QIODevice::ReadWrite) ||
+        file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        memcmp(header.magic, SOLUTION_MAGIC, sizeof(header.magic)) || header.recordSize != sizeof(Record) ||
+        header.interval == 0) {
+        return false;
+    }
+    qint64 size = file.size();
+    SolutionIndexTrailer trailer;
+    if (size >= qint64(sizeof(header) + sizeof(trailer)) && file.seek(size - sizeof(trailer)) &&
+        file.read(reinterpret_cast<char *>(&trailer), sizeof(trailer)) == qint64(sizeof(trailer)) &&
+        !memcmp(trailer.magic, SOLUTION_INDEX_MAGIC, sizeof(trailer.magic))) {
+        return true; // 已有索引
+    }
+
+    // 丢弃中断时写了一半的记录，然后读取每个索引间隔第一条记录的时间
+    qint64 count = (size - qint64(sizeof(header))) / qint64(sizeof(Record));
+    qint64 end = qint64(sizeof(header)) + count * qint64(sizeof(Record));
+    if (end != size && !file.resize(end)) {
+        return false;
+    }
+    QVector<IndexEntry> entries;
+    for (qint64 i = 0; i < count; i += header.interval) {
+        IndexEntry entry;
+        if (!file.seek(qint64(sizeof(header)) + i * qint64(sizeof(Record))) ||
+            file.read(reinterpret_cast<char *>(&entry), sizeof(entry)) != qint64(sizeof(entry))) {
+            return false;
+        }
+        entries.append(entry);
+    }
+    memcpy(trailer.magic, SOLUTION_INDEX_MAGIC, sizeof(trailer.magic));
+    trailer.records = count;
+    trailer.entries = entries.size();
+    qint64 bytes = qint64(entries.size()) * qint64(sizeof(IndexEntry));
+    return file.seek(end) && file.write(reinterpret_cast<const char *>(entries.constData()), bytes) == bytes &&
+           file.write(reinterpret_cast<const char *>(&trailer), sizeof(trailer)) == qint64(sizeof(trailer));
+}
+
+bool PPPSolutionFile::isSolutionFile(const QString &path)
+{
+    QFile file(path);
+    char magic[sizeof(SOLUTION_MAGIC)];
+    return file.open(QIODevice::ReadOnly) && file.read(magic, sizeof(magic)) == qint64(sizeof(magic)) &&
+           !memcmp(magic, SOLUTION_MAGIC, sizeof(magic));
+}
+
+int PPPSolutionFile::headerSize()
+{
+    return int(sizeof(SolutionFileHeader));
+}
+
+int PPPSolutionFile::recordSize()
+{
+    return int(sizeof(Record));
+}
+
+bool PPPSolutionFile::checkHeader(const char *data)
+{
+    SolutionFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    return !memcmp(header.magic, SOLUTION_MAGIC, sizeof(header.magic)) && header.recordSize == sizeof(Record);
+}
+
+void PPPSolutionFile::decode(const char *data, sol_t *sol)
+{
+    Record record;
+    memcpy(&record, data, sizeof(record));
+    decodeRecord(record, sol);
+}
+
+bool PPPSolutionFile::open(const QString &path, QString *error)
+{
+    close();
+    m_file.setFileName(path);
+    SolutionFileHeader header;
+    if (!m_file.open(QIODevice::ReadOnly) ||
+        m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        memcmp(header.magic, SOLUTION_MAGIC, sizeof(header.magic)) || header.recordSize != sizeof(Record) ||
+        header.interval == 0) {
+        *error = QString("无法打开结果文件: %1").arg(path);
+        close();
+        return false;
+    }
+    qint64 size = m_file.size();
+    const uchar *data = size > qint64(sizeof(header)) ? m_file.map(0, size) : nullptr;
+    if (size > qint64(sizeof(header)) && !data) {
+        *error = QString("无法映射结果文件: %1").arg(path);
+        close();
+        return false;
+    }
+    m_interval = int(header.interval);
+
+    // 有索引时记录数由索引信息给出，否则按文件长度计算（忽略末尾不完整的记录）
+    qint64 count = (size - qint64(sizeof(header))) / qint64(sizeof(Record));
+    SolutionIndexTrailer trailer;
+    if (size >= qint64(sizeof(header) + sizeof(trailer))) {
+        memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+        qint64 end = qint64(sizeof(header)) + qBound(qint64(0), trailer.records, count) * qint64(sizeof(Record));
+        if (!memcmp(trailer.magic, SOLUTION_INDEX_MAGIC, sizeof(trailer.magic)) && trailer.records >= 0 &&
+            trailer.records <= count && trailer.entries == (trailer.records + m_interval - 1) / m_interval &&
+            end + trailer.entries * qint64(sizeof(IndexEntry)) + qint64(sizeof(trailer)) == size) {
+            count = trailer.records;
+            m_entries = int(trailer.entries);
+            m_index = reinterpret_cast<const IndexEntry *>(data + end);
+        }
+    }
+    if (count > INT_MAX) {
+        *error = QString("结果文件过大: %1").arg(path);
+        close();
+        return false;
+    }
+    m_count = int(count);
+    m_records = data ? reinterpret_cast<const Record *>(data + sizeof(header)) : nullptr;
+    return true;
+}
+
+void PPPSolutionFile::close()
+{
+    m_file.close();
+    m_records = nullptr;
+    m_index = nullptr;
+    m_count = m_entries = 0;
+    m_interval = INDEX_INTERVAL;
+}
+
+int PPPSolutionFile::count() const
+{
+    return m_count;
+}
+
+bool PPPSolutionFile::indexed() const
+{
+    return m_index != nullptr;
+}
+
+gtime_t PPPSolutionFile::time(int i) const
+{
+    gtime_t time = { time_t(m_records[i].time), m_records[i].sec };
+    return time;
+}
+
+// 记录转为sol_t，结束记录只有时间
+void PPPSolutionFile::decodeRecord(const Record &record, sol_t *sol)
+{
+    memset(sol, 0, sizeof(sol_t));
+    sol->time.time = time_t(record.time);
+    sol->time.sec = record.sec;
+    if (record.stat == SOLQ_NONE) {
+        return;
+    }
+    for (int j = 0; j < 3; j++) sol->rr[j] = record.rr[j];
+    for (int j = 0; j < 6; j++) sol->qr[j] = record.qr[j];
+    sol->stat = record.stat;
+    sol->ns = record.ns;
+    sol->age = record.age;
+    sol->ratio = record.ratio;
+}
+
+void PPPSolutionFile::read(int i, sol_t *sol) const
+{
+    decodeRecord(m_records[i], sol);
+}
+
+bool PPPSolutionFile::stop(int i, Stop *stop) const
+{
+    const StopRecord &record = reinterpret_cast<const StopRecord &>(m_records[i]);
+    if (record.stat != SOLQ_NONE || record.type != STOP_RECORD) {
+        return false;
+    }
+    stop->time = time(i);
+    stop->sigma = record.sigma;
+    stop->change = record.change;
+    stop->window = record.window;
+    stop->skipped = record.skipped;
+    return true;
+}
+
+int PPPSolutionFile::lowerBound(gtime_t time) const
+{
+    return search(time, false);
+}
+
+int PPPSolutionFile::search(gtime_t time, bool after) const
+{
+    // 先在索引中确定所在的区间：第k项对应的记录不满足条件，第k-1项对应的记录之前的都满足
+    int first = 0, last = m_count;
+    if (m_index) {
+        int k = int(std::partition_point(m_index, m_index + m_entries,
+                                         [time, after](const IndexEntry &entry) { return earlier(entry, time, after); }) -
+                    m_index);
+        if (k == 0) {
+            return 0;
+        }
+        first = (k - 1) * m_interval;
+        last = int(qMin(qint64(k) * m_interval, qint64(m_count)));
+    }
+    return int(std::partition_point(m_records + first, m_records + last,
+                                    [time, after](const Record &record) { return earlier(record, time, after); }) -
+               m_records);
+}
+
+void PPPSolutionFile::window(gtime_t ts, gtime_t te, int *first, int *last) const
+{
+    *first = ts.time ? search(ts, false) : 0;
+    *last = te.time ? qMax(*first, search(te, true)) : m_count;
+}
+
+bool PPPSolutionFile::toText(const QString &path, const QString &outfile, const solopt_t *sopt, QString *error)
+{
+    PPPSolutionFile file;
+    if (!file.open(path, error)) {
+        return false;
+    }
+    QByteArray name = outfile.toLocal8Bit();
+    FILE *fp = fopen(name.constData(), "w");
+    if (!fp) {
+        *error = QString("无法创建结果文件: %1").arg(outfile);
+        return false;
+    }
+    double rb[3] = { 0 };
+    sol_t sol;
+    Stop stop;
+    outsolhead(fp, sopt);
+    for (int i = 0; i < file.count(); i++) {
+        if (file.stop(i, &stop)) {
+            outputStop(fp, stop);
+            continue;
+        }
+        file.read(i, &sol);
+        outsol(fp, &sol, rb, sopt);
+    }
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0 || !ok) {
+        *error = QString("无法写入结果文件: %1").arg(outfile);
+        return false;
+    }
+    return true;
+}
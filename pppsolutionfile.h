@@ -0,0 +1,99 @@
+#ifndef PPPSOLUTIONFILE_H
+#define PPPSOLUTIONFILE_H
+
+#include "rtklib.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <cstdio>
+
+// 二进制解算结果文件
+// 每个历元一条定长记录（80字节，.pos文本约150字节）：时间、ECEF坐标、协方差、解算质量、卫星数、龄期和比值。
+// 处理完成后在记录之后追加稀疏时间索引（每INDEX_INTERVAL条记录一项），读取时先在索引中查找，
+// 再在一个索引区间内二分查找，任意时间窗的定位只访问索引和少量记录；
+// 没有索引的文件（处理中断）按定长记录直接二分查找。
+// 记录的写出与文本相同地使用FILE*，检查点记录的文件偏移对两种格式都有效。
+// 提前结束时写出一条结束记录（与文本的 "% early stop" 注释行对应），解算质量为SOLQ_NONE，
+// 时间字段与解算记录相同，不影响时间索引和查找。
+// 数据按本机字节序（小端）存放。
+class PPPSolutionFile
+{
+public:
+    // 提前结束的结束记录
+    struct Stop {
+        gtime_t time;      // 最后一个解算历元
+        double sigma;      // 三维标准差 (m)
+        double change;     // 坐标变化阈值 (m)
+        double window;     // 条件保持的时长 (s)
+        double skipped;    // 未处理的观测时长 (s)
+    };
+
+    PPPSolutionFile();
+    ~PPPSolutionFile();
+
+    // 写出：文件头，每个历元一条记录（与outsol相同，忽略无解的历元），处理结束后追加时间索引
+    static bool writeHeader(FILE *fp);
+    static bool writeRecord(FILE *fp, const sol_t &sol);
+    static bool writeIndex(const char *path);
+
+    // 结束记录：二进制文件写出记录，文本文件写出注释行
+    static bool writeStop(FILE *fp, const Stop &stop);
+    static void outputStop(FILE *fp, const Stop &stop);
+
+    // 按文件头判断是否为二进制结果文件
+    static bool isSolutionFile(const QString &path);
+
+    // 逐条读取正在写出的文件（不加索引，见PPPEngine::setBinaryOutput）：
+    // 文件头和记录的长度，检查文件头，解码一条记录（结束记录解码为无解的历元）
+    static int headerSize();
+    static int recordSize();
+    static bool checkHeader(const char *data);
+    static void decode(const char *data, sol_t *sol);
+
+    // 在内存中生成文件（如结果导出）：文件头（headerSize()字节），一条记录（recordSize()字节），
+    // 以及各记录时间对应的时间索引和索引信息，依次连接即为带索引的结果文件
+    static void encodeHeader(char *data);
+    static void encode(const sol_t &sol, char *data);
+    static QByteArray encodeIndex(const QVector<gtime_t> &times);
+
+    // 映射文件读取
+    bool open(const QString &path, QString *error);
+    void close();
+
+    int count() const;
+    bool indexed() const;          // 文件是否包含时间索引
+    gtime_t time(int i) const;
+    void read(int i, sol_t *sol) const;     // 结束记录读出为无解（SOLQ_NONE）的历元
+    bool stop(int i, Stop *stop) const;     // 第i条是否为结束记录
+
+    // 第一个时间不早于time的记录序号，没有时返回count()
+    int lowerBound(gtime_t time) const;
+
+    // 时间窗[ts, te]内的记录序号范围[*first, *last)，时间为0表示不限
+    void window(gtime_t ts, gtime_t te, int *first, int *last) const;
+
+    // 转换为.pos文本（outsolhead和outsol，与引擎直接输出的文本相同）
+    static bool toText(const QString &path, const QString &outfile, const solopt_t *sopt, QString *error);
+
+private:
+    struct Record;
+    struct StopRecord;
+    struct IndexEntry;
+
+    static void decodeRecord(const Record &record, sol_t *sol);
+
+    // 第一个时间不早于（after为true时晚于）time的记录序号
+    int search(gtime_t time, bool after) const;
+
+    QFile m_file;
+    const Record *m_records;
+    const IndexEntry *m_index;
+    int m_count;
+    int m_entries;
+    int m_interval;
+
+    Q_DISABLE_COPY(PPPSolutionFile)
+};
+
+#endif // PPPSOLUTIONFILE_H
@@ -0,0 +1,128 @@
+#include "pppsolutionstore.h"
+#include <cmath>
+
+// 与RTKLIB solution.c的SQRT/sqvar相同
+static double sqrtPositive(double x)
+{
+    return x <= 0.0 || x != x ? 0.0 : sqrt(x);
+}
+
+static double sqrtSigned(double x)
+{
+    return x < 0.0 ? -sqrt(-x) : sqrt(x);
+}
+
+template <typename T>
+static qint64 vectorBytes(const std::vector<T> &v)
+{
+    return qint64(v.capacity()) * sizeof(T);
+}
+
+PPPSolutionStore::PPPSolutionStore()
+{
+}
+
+void PPPSolutionStore::clear()
+{
+    // 释放内存，clear()不会减小容量
+    *this = PPPSolutionStore();
+}
+
+void PPPSolutionStore::reserve(int n)
+{
+    m_time.reserve(n);
+    m_rr.reserve(size_t(n) * 3);
+    m_qr.reserve(size_t(n) * 6);
+    m_stat.reserve(n);
+    m_ns.reserve(n);
+    m_age.reserve(n);
+    m_ratio.reserve(n);
+}
+
+void PPPSolutionStore::append(const sol_t &sol)
+{
+    if (sol.stat <= SOLQ_NONE) {
+        return;
+    }
+    m_time.push_back(sol.time);
+    m_rr.insert(m_rr.end(), sol.rr, sol.rr + 3);
+    m_qr.insert(m_qr.end(), sol.qr, sol.qr + 6);
+    m_stat.push_back(sol.stat);
+    m_ns.push_back(sol.ns);
+    m_age.push_back(sol.age);
+    m_ratio.push_back(sol.ratio);
+}
+
+int PPPSolutionStore::size() const
+{
+    return int(m_time.size());
+}
+
+bool PPPSolutionStore::isEmpty() const
+{
+    return m_time.empty();
+}
+
+gtime_t PPPSolutionStore::time(int i) const
+{
+    return m_time[i];
+}
+
+int PPPSolutionStore::quality(int i) const
+{
+    return m_stat[i];
+}
+
+int PPPSolutionStore::satellites(int i) const
+{
+    return m_ns[i];
+}
+
+void PPPSolutionStore::position(int i, double *rr) const
+{
+    for (int j = 0; j < 3; j++) rr[j] = m_rr[size_t(i) * 3 + j];
+}
+
+void PPPSolutionStore::covariance(int i, double *qr) const
+{
+    for (int j = 0; j < 6; j++) qr[j] = m_qr[size_t(i) * 6 + j];
+}
+
+PosRecord PPPSolutionStore::record(int i) const
+{
+    // 与outsol的经纬度/高程输出相同：ECEF协方差转到测站ENU
+    double rr[3], qr[6], pos[3], P[9], Q[9];
+    position(i, rr);
+    covariance(i, qr);
+    ecef2pos(rr, pos);
+    P[0] = qr[0];
+    P[4] = qr[1];
+    P[8] = qr[2];
+    P[1] = P[3] = qr[3];
+    P[5] = P[7] = qr[4];
+    P[2] = P[6] = qr[5];
+    covenu(pos, P, Q);
+
+    PosRecord record;
+    record.time = m_time[i];
+    record.lat = pos[0] * R2D;
+    record.lon = pos[1] * R2D;
+    record.height = pos[2];
+    record.quality = m_stat[i];
+    record.ns = m_ns[i];
+    record.sdn = sqrtPositive(Q[4]);
+    record.sde = sqrtPositive(Q[0]);
+    record.sdu = sqrtPositive(Q[8]);
+    record.sdne = sqrtSigned(Q[1]);
+    record.sdeu = sqrtSigned(Q[2]);
+    record.sdun = sqrtSigned(Q[5]);
+    record.age = m_age[i];
+    record.ratio = m_ratio[i];
+    return record;
+}
+
+qint64 PPPSolutionStore::bytes() const
+{
+    return vectorBytes(m_time) + vectorBytes(m_rr) + vectorBytes(m_qr) + vectorBytes(m_stat) + vectorBytes(m_ns) +
+           vectorBytes(m_age) + vectorBytes(m_ratio);
+}
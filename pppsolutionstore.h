@@ -0,0 +1,49 @@
+#ifndef PPPSOLUTIONSTORE_H
+#define PPPSOLUTIONSTORE_H
+
+#include "posfile.h"
+#include "rtklib.h"
+#include <QtGlobal>
+#include <vector>
+
+// 处理过程中的解算结果
+// 引擎每得到一个历元的解就追加到本类，界面直接读取，不必写出.pos文本再解析
+// （文本中的经纬度只有9位小数）。按列存储ECEF坐标、协方差、解算质量、卫星数、龄期和比值，
+// 每个历元约70字节；经纬度和ENU标准差在读取时按outsol的方式计算。
+class PPPSolutionStore
+{
+public:
+    PPPSolutionStore();
+
+    void clear();
+    void reserve(int n);
+
+    // 追加一个历元的解，与outsol一样忽略无解的历元
+    void append(const sol_t &sol);
+
+    int size() const;
+    bool isEmpty() const;
+
+    gtime_t time(int i) const;
+    int quality(int i) const;       // SOLQ_???
+    int satellites(int i) const;
+    void position(int i, double *rr) const;   // ECEF坐标 (m)
+    void covariance(int i, double *qr) const; // ECEF协方差 xx,yy,zz,xy,yz,zx (m^2)
+
+    // 与.pos文件的经纬度/高程格式（椭球高，GPST）相同的结果，经纬度不截断
+    PosRecord record(int i) const;
+
+    // 占用的内存 (byte)
+    qint64 bytes() const;
+
+private:
+    std::vector<gtime_t> m_time;
+    std::vector<double> m_rr;       // [历元][3]
+    std::vector<float> m_qr;        // [历元][6]
+    std::vector<quint8> m_stat;
+    std::vector<quint8> m_ns;
+    std::vector<float> m_age;
+    std::vector<float> m_ratio;
+};
+
+#endif // PPPSOLUTIONSTORE_H
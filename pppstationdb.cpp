@@ -0,0 +1,121 @@
+#include "pppstationdb.h"
+#include <QFile>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QStringList>
+
+// 等待其他进程释放数据库锁的时间 (ms)
+static const int LOCK_TIMEOUT = 10000;
+
+bool PPPStationDb::lookup(const QString &path, const QString &name, PPPStationRecord *record)
+{
+    QMap<QString, PPPStationRecord> records;
+    if (name.isEmpty() || !read(path, &records)) {
+        return false;
+    }
+    auto it = records.constFind(name.toUpper());
+    if (it == records.constEnd()) {
+        return false;
+    }
+    *record = it.value();
+    return true;
+}
+
+bool PPPStationDb::update(const QString &path, const PPPStationRecord &record, QString *error)
+{
+    QLockFile lock(path + ".lock");
+    if (!lock.tryLock(LOCK_TIMEOUT)) {
+        *error = QString("无法锁定测站数据库: %1").arg(path);
+        return false;
+    }
+    QMap<QString, PPPStationRecord> records;
+    read(path, &records);
+    PPPStationRecord entry = record;
+    entry.name = record.name.toUpper();
+    records.insert(entry.name, entry);
+    return write(path, records, error);
+}
+
+QString PPPStationDb::stationName(const sta_t &sta)
+{
+    QString name = QString::fromLatin1(sta.name).trimmed();
+    if (name.isEmpty()) {
+        name = QString::fromLatin1(sta.marker).trimmed();
+    }
+    // 数据库以空白分隔，名称中的空格替换为下划线
+    return name.toUpper().replace(' ', '_');
+}
+
+bool PPPStationDb::read(const QString &path, QMap<QString, PPPStationRecord> *records)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    PPPStationRecord record;
+    while (!file.atEnd()) {
+        QString line = QString::fromLatin1(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (parseLine(line, &record)) {
+            records->insert(record.name, record);
+        }
+    }
+    return true;
+}
+
+bool PPPStationDb::parseLine(const QString &line, PPPStationRecord *record)
+{
+    const QStringList fields = line.split(' ', Qt::SkipEmptyParts);
+    if (fields.size() < 14) {
+        return false;
+    }
+    double values[11];
+    for (int i = 0; i < 11; i++) {
+        bool ok;
+        values[i] = fields[i + 3].toDouble(&ok);
+        if (!ok) return false;
+    }
+    double ep[6];
+    QByteArray text = (fields[1] + ' ' + fields[2]).toLatin1();
+    if (sscanf(text.constData(), "%lf/%lf/%lf %lf:%lf:%lf", ep, ep + 1, ep + 2, ep + 3, ep + 4, ep + 5) != 6) {
+        return false;
+    }
+    record->name = fields[0].toUpper();
+    record->time = epoch2time(ep);
+    for (int i = 0; i < 3; i++) {
+        record->pos[i] = values[i];
+        record->std[i] = values[i + 3];
+    }
+    record->ztd = values[6];
+    record->ztdStd = values[7];
+    record->runs = int(values[8]);
+    record->coldConvergence = values[9];
+    record->warmConvergence = values[10];
+    return true;
+}
+
+bool PPPStationDb::write(const QString &path, const QMap<QString, PPPStationRecord> &records, QString *error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        *error = QString("无法写入测站数据库: %1").arg(path);
+        return false;
+    }
+    file.write("# name time x(m) y(m) z(m) sdx(m) sdy(m) sdz(m) ztd(m) sdztd(m) runs cold(s) warm(s)\n");
+    for (const PPPStationRecord &record : records) {
+        char time[64];
+        time2str(record.time, time, 0);
+        file.write(QString::asprintf("%-16s %s %14.4f %14.4f %14.4f %8.4f %8.4f %8.4f %7.4f %7.4f %5d %8.0f %8.0f\n",
+                                     record.name.toLatin1().constData(), time, record.pos[0], record.pos[1],
+                                     record.pos[2], record.std[0], record.std[1], record.std[2], record.ztd,
+                                     record.ztdStd, record.runs, record.coldConvergence, record.warmConvergence)
+                       .toLatin1());
+    }
+    if (!file.commit()) {
+        *error = QString("无法写入测站数据库: %1").arg(path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#ifndef PPPSTATIONDB_H
+#define PPPSTATIONDB_H
+
+#include "rtklib.h"
+#include <QMap>
+#include <QString>
+
+// 测站数据库中的一条记录：上一次静态PPP的最终坐标、对流层延迟及收敛时间
+struct PPPStationRecord {
+    QString name;             // 测站名（观测文件头的MARKER NAME，大写）
+    gtime_t time;             // 解算结束时刻
+    double pos[3];            // ECEF坐标 (m)
+    double std[3];            // 坐标标准差 (m)
+    double ztd;               // 天顶对流层延迟 (m)，0为未估计
+    double ztdStd;            // 天顶对流层延迟标准差 (m)
+    int runs;                 // 更新次数
+    double coldConvergence;   // 最近一次冷启动的收敛时间 (s)，<0为未知
+    double warmConvergence;   // 最近一次热启动的收敛时间 (s)，<0为未知
+};
+
+// 测站坐标和对流层延迟数据库
+// 文本文件，每行一个测站，以空白分隔：
+//   名称 时间(yyyy/mm/dd hh:mm:ss) X Y Z sdX sdY sdZ ZTD sdZTD 次数 冷启动收敛 热启动收敛
+// 批处理的多个工作进程可能同时更新同一数据库，更新时用锁文件串行化读-改-写。
+class PPPStationDb
+{
+public:
+    // 查找测站，数据库不存在或无该测站时返回false
+    static bool lookup(const QString &path, const QString &name, PPPStationRecord *record);
+
+    // 写入或替换测站记录
+    static bool update(const QString &path, const PPPStationRecord &record, QString *error);
+
+    // 由观测文件头的测站信息得到数据库中的测站名
+    static QString stationName(const sta_t &sta);
+
+private:
+    static bool read(const QString &path, QMap<QString, PPPStationRecord> *records);
+    static bool write(const QString &path, const QMap<QString, PPPStationRecord> &records, QString *error);
+    static bool parseLine(const QString &line, PPPStationRecord *record);
+};
+
+#endif // PPPSTATIONDB_H
@@ -0,0 +1,225 @@
+#include "pppsweep.h"
+#include "pppengine.h"
+#include <QThread>
+#include <algorithm>
+
+// 比较两个组合的输入是否相同（文件和时间范围）
+static bool sameInputs(const ppp_paths_t &a, const ppp_paths_t &b)
+{
+    const char *const files[][2] = {
+        { a.obs_file, b.obs_file }, { a.nav_file, b.nav_file }, { a.sp3_file, b.sp3_file },
+        { a.clk_file, b.clk_file }, { a.atx_file, b.atx_file }, { a.dcb_file, b.dcb_file },
+        { a.erp_file, b.erp_file },
+    };
+    for (const auto &file : files) {
+        if (strcmp(file[0], file[1])) return false;
+    }
+    if (a.use_time_range != b.use_time_range || a.ti != b.ti) {
+        return false;
+    }
+    return !a.use_time_range || (!memcmp(a.ts, b.ts, sizeof(a.ts)) && !memcmp(a.te, b.te, sizeof(a.te)));
+}
+
+PPPSweep::PPPSweep(QObject *parent)
+    : QObject(parent), m_threadCount(QThread::idealThreadCount()), m_thread(nullptr), m_next(0), m_cancelled(false),
+      m_running(false), m_loadSeconds(0.0), m_elapsed(0.0)
+{
+    // 结果从工作线程发出
+    qRegisterMetaType<PPPSweepResult>("PPPSweepResult");
+}
+
+PPPSweep::~PPPSweep()
+{
+    cancel();
+    wait();
+    delete m_thread;
+}
+
+void PPPSweep::setThreadCount(int count)
+{
+    m_threadCount = qMax(1, count);
+}
+
+int PPPSweep::threadCount() const
+{
+    return m_threadCount;
+}
+
+bool PPPSweep::isRunning() const
+{
+    return m_running;
+}
+
+const QVector<PPPSweepResult> &PPPSweep::results() const
+{
+    return m_results;
+}
+
+QVector<PPPSweepResult> PPPSweep::ranking() const
+{
+    QVector<PPPSweepResult> ranked = m_results;
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const PPPSweepResult &a, const PPPSweepResult &b) { return a.rank < b.rank; });
+    return ranked;
+}
+
+double PPPSweep::loadSeconds() const
+{
+    return m_loadSeconds;
+}
+
+double PPPSweep::elapsedSeconds() const
+{
+    return m_running ? m_timer.elapsed() / 1000.0 : m_elapsed;
+}
+
+bool PPPSweep::start(const QList<ppp_paths_t> &variants, const QStringList &labels, QString *error)
+{
+    if (m_running) {
+        *error = "参数扫描正在进行中";
+        return false;
+    }
+    if (variants.isEmpty() || labels.size() != variants.size()) {
+        *error = "没有参数组合";
+        return false;
+    }
+    for (const ppp_paths_t &variant : variants) {
+        if (!sameInputs(variant, variants[0])) {
+            *error = "参数扫描的各组合必须使用相同的输入文件和时间范围";
+            return false;
+        }
+    }
+    wait();
+    delete m_thread;
+
+    m_variants = variants;
+    m_results = QVector<PPPSweepResult>(variants.size());
+    for (int i = 0; i < variants.size(); i++) {
+        m_results[i] = PPPSweepResult{ labels[i], false, -1.0, -1.0, -1.0, 0, 0.0, 0 };
+    }
+    m_next = 0;
+    m_cancelled = false;
+    m_running = true;
+    m_loadSeconds = 0.0;
+    m_timer.start();
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+    return true;
+}
+
+void PPPSweep::cancel()
+{
+    m_cancelled = true;
+}
+
+bool PPPSweep::wait(unsigned long msecs)
+{
+    return !m_thread || m_thread->wait(msecs);
+}
+
+void PPPSweep::run()
+{
+    // 读取选项取各组合卫星系统的并集，使所有组合需要的卫星天线参数都被设置
+    ppp_paths_t job = m_variants[0];
+    for (const ppp_paths_t &variant : m_variants) {
+        job.navsys |= variant.navsys;
+    }
+    prcopt_t prcopt;
+    solopt_t solopt;
+    QString message;
+    m_inputs.reset(new PPPInputs);
+    bool ok = PPPProcessor::loadInputs(&job, &prcopt, &solopt, m_inputs.get(), &message);
+    m_loadSeconds = m_timer.elapsed() / 1000.0;
+    if (!ok) {
+        m_inputs.reset();
+        m_elapsed = m_timer.elapsed() / 1000.0;
+        m_running = false;
+        emit loaded(false, message);
+        emit finished(false, message);
+        return;
+    }
+    emit loaded(true, QString("读取输入 %1 s，%2 MB")
+                          .arg(m_loadSeconds, 0, 'f', 1).arg(m_inputs->bytes() / 1048576.0, 0, 'f', 1));
+
+    // 各线程从同一队列中领取组合
+    QList<QThread *> threads;
+    for (int i = 0; i < qMin(m_threadCount, m_variants.size()); i++) {
+        threads.append(QThread::create([this]() { solveLoop(); }));
+        threads.last()->start();
+    }
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+    m_inputs.reset();
+
+    rank(&m_results);
+    int succeeded = 0;
+    for (const PPPSweepResult &result : m_results) {
+        if (result.success) succeeded++;
+    }
+    m_elapsed = m_timer.elapsed() / 1000.0;
+    m_running = false;
+    if (m_cancelled) {
+        emit finished(false, "参数扫描已取消");
+    } else {
+        emit finished(succeeded > 0, QString("参数扫描完成: %1/%2 个组合成功，总耗时 %3 s")
+                                         .arg(succeeded).arg(m_results.size()).arg(m_elapsed, 0, 'f', 1));
+    }
+}
+
+void PPPSweep::solveLoop()
+{
+    int index;
+    while (!m_cancelled && (index = m_next++) < m_variants.size()) {
+        QElapsedTimer timer;
+        timer.start();
+        ppp_paths_t variant = m_variants[index];
+        variant.soltype = SOLTYPE_FORWARD;
+        prcopt_t prcopt;
+        solopt_t solopt;
+        filopt_t filopt;
+        PPPProcessor::initOptions(&variant, &prcopt, &solopt, &filopt);
+
+        // rtk_t较大，引擎在堆上创建，避免超出线程栈
+        std::unique_ptr<PPPEngine> engine(new PPPEngine);
+        engine->setOptions(&prcopt);
+        engine->setCancelFlag(&m_cancelled);
+        int ret = engine->process(m_inputs.get(), &solopt, nullptr);
+
+        PPPSweepResult &result = m_results[index];
+        result.success = ret == 0 && !m_cancelled;
+        result.convergence = engine->convergenceSeconds();
+        result.finalSigma = engine->finalSigma();
+        result.repeatability = engine->repeatability();
+        result.epochs = engine->epochCount();
+        result.wallTime = timer.elapsed() / 1000.0;
+        emit variantFinished(index, result);
+    }
+}
+
+void PPPSweep::rank(QVector<PPPSweepResult> *results)
+{
+    // 收敛时间、最终标准差和离散度分别排序，按名次之和综合排名；未收敛的组合排在最后
+    QVector<int> order(results->size()), score(results->size(), 0);
+    auto metrics = { &PPPSweepResult::convergence, &PPPSweepResult::finalSigma, &PPPSweepResult::repeatability };
+    for (double PPPSweepResult::*metric : metrics) {
+        for (int i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [results, metric](int a, int b) {
+            double va = (*results)[a].*metric, vb = (*results)[b].*metric;
+            if ((va < 0.0) != (vb < 0.0)) return vb < 0.0;
+            return va < vb;
+        });
+        for (int i = 0; i < order.size(); i++) score[order[i]] += i;
+    }
+    for (int i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [results, &score](int a, int b) {
+        bool ca = (*results)[a].success && (*results)[a].convergence >= 0.0;
+        bool cb = (*results)[b].success && (*results)[b].convergence >= 0.0;
+        if (ca != cb) return ca;
+        return score[a] < score[b];
+    });
+    for (int i = 0; i < order.size(); i++) {
+        (*results)[order[i]].rank = i + 1;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef PPPSWEEP_H
+#define PPPSWEEP_H
+
+#include "pppprocessor.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaType>
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+class PPPInputs;
+class QThread;
+
+// 参数扫描中一个参数组合的结果
+struct PPPSweepResult {
+    QString label;          // 参数组合说明
+    bool success;           // 是否处理成功
+    double convergence;     // 收敛时间 (s)，<0为未收敛
+    double finalSigma;      // 最终位置三维标准差 (m)，<0为无PPP解
+    double repeatability;   // 收敛后坐标的三维离散度 (m)，<0为未收敛
+    int epochs;             // 处理的历元数
+    double wallTime;        // 处理耗时 (s)
+    int rank;               // 综合排名，1为最好
+};
+Q_DECLARE_METATYPE(PPPSweepResult)
+
+// 参数扫描
+// 观测、星历和精密产品只读取一次，各参数组合在多个线程中使用同一份只读输入同时处理。
+// 每个线程持有自己的滤波器状态（PPPEngine），不输出结果文件和状态文件。
+// 各组合必须使用相同的输入文件和时间范围，只能改变处理选项（模式、对流层、电离层、卫星系统、截止高度角、迭代次数等）。
+class PPPSweep : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PPPSweep(QObject *parent = nullptr);
+    ~PPPSweep();
+
+    // 并行线程数，默认为逻辑核心数
+    void setThreadCount(int count);
+    int threadCount() const;
+
+    // 开始扫描（异步，结果通过信号通知）
+    bool start(const QList<ppp_paths_t> &variants, const QStringList &labels, QString *error);
+    void cancel();
+    bool isRunning() const;
+    bool wait(unsigned long msecs = ULONG_MAX);
+
+    // 各组合的结果（与输入顺序相同），完成后按综合排名排序的结果
+    const QVector<PPPSweepResult> &results() const;
+    QVector<PPPSweepResult> ranking() const;
+
+    double loadSeconds() const;
+    double elapsedSeconds() const;
+
+signals:
+    void loaded(bool success, const QString &message);
+    void variantFinished(int index, const PPPSweepResult &result);
+    void finished(bool success, const QString &message);
+
+private:
+    void run();
+    void solveLoop();
+    static void rank(QVector<PPPSweepResult> *results);
+
+    QList<ppp_paths_t> m_variants;
+    QVector<PPPSweepResult> m_results;
+    std::unique_ptr<PPPInputs> m_inputs;
+    int m_threadCount;
+    QThread *m_thread;
+    std::atomic<int> m_next;          // 下一个待处理的组合
+    std::atomic<bool> m_cancelled;
+    std::atomic<bool> m_running;
+    QElapsedTimer m_timer;
+    double m_loadSeconds;
+    double m_elapsed;
+};
+
+#endif // PPPSWEEP_H
@@ -0,0 +1,533 @@
+#include "ppptracer.h"
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QThread>
+#include <cstring>
+#include <vector>
+#ifdef PPP_WITH_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char TRACE_MAGIC[8] = { 'P', 'P', 'P', 'T', 'R', 'C', '0', '1' };
+static const quint32 TRACE_COMPRESSED = 1;      // 各块经zlib压缩
+static const int RING_ENTRIES = 1 << 16;        // 环形缓冲区的条目数（4 MB）
+static const int PAYLOAD_BYTES = 44;            // 每个条目的数据字节数，较长的行拆为多个条目
+static const int BLOCK_BYTES = 1 << 18;         // 写出块的大小（压缩前）
+static const qint64 PIPE_BYTES = 1 << 16;       // 每次从管道读取的字节数
+static const int IDLE_MSECS = 5;                // 缓冲区为空时写出线程的等待时间
+static const qint64 FLUSH_MSECS = 1000;         // 不满一块的条目最长的等待时间
+
+// 条目类型
+enum {
+    ENTRY_TEXT = 1,        // 一行跟踪文本的开始
+    ENTRY_CONTINUED,       // 上一行的后续部分
+    ENTRY_EPOCH,           // 历元事件
+    ENTRY_DROPPED          // 缓冲区满时丢弃的条目数
+};
+
+struct TraceFileHeader {
+    char magic[8];
+    quint32 flags;
+    quint32 reserved;
+};
+
+// 每块的开头，其后为stored字节的数据（未压缩时等于raw）
+struct TraceBlockHeader {
+    quint32 raw;
+    quint32 stored;
+};
+
+struct EpochPayload {
+    qint64 time;
+    double sec;
+    float micros;
+    quint8 stat;
+    quint8 ns;
+    quint16 reserved;
+};
+
+struct PPPTracer::Entry {
+    quint64 tick;          // 跟踪开始后的时间 (ns)
+    quint8 type;
+    quint8 level;          // RTKLIB的跟踪级别，0为没有级别前缀的行（tracemat等）
+    quint8 length;         // payload的有效字节数
+    quint8 reserved;
+    char payload[PAYLOAD_BYTES];
+};
+
+// 有界多写入方队列的槽（Vyukov），sequence等于位置时可写，等于位置+1时可读
+struct PPPTracer::Slot {
+    std::atomic<quint64> sequence;
+    Entry entry;
+};
+
+// 文件中的条目：tick、type、level、length和length字节的数据
+static const int RECORD_HEADER_BYTES = 11;
+
+PPPTracer::PPPTracer()
+    : m_mask(RING_ENTRIES - 1), m_head(0), m_tail(0), m_dropped(0), m_entries(0), m_textBytes(0), m_fileBytes(0),
+      m_reader(nullptr), m_writer(nullptr), m_stopReader(false), m_stopWriter(false), m_failed(false)
+#ifdef WIN32
+      , m_next(INVALID_HANDLE_VALUE)
+#endif
+{
+    static_assert(sizeof(Entry) == 56, "trace entry size");
+}
+
+PPPTracer::~PPPTracer()
+{
+    stop();
+}
+
+bool PPPTracer::start(const QString &path, QString *error)
+{
+    m_path = path;
+    m_file.reset(new QFile(path));
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+#ifdef PPP_WITH_ZLIB
+    header.flags = TRACE_COMPRESSED;
+#endif
+    if (!m_file->open(QIODevice::WriteOnly) ||
+        m_file->write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        *error = QString("cannot create trace file %1").arg(path);
+        m_file.reset();
+        return false;
+    }
+    m_fileBytes = sizeof(header);
+
+    m_slots.reset(new Slot[RING_ENTRIES]);
+    for (int i = 0; i < RING_ENTRIES; i++) {
+        m_slots[i].sequence.store(quint64(i), std::memory_order_relaxed);
+    }
+    m_head = m_tail = 0;
+    m_dropped = m_entries = m_textBytes = 0;
+    m_stopReader = m_stopWriter = false;
+    m_failed = false;
+    m_line.clear();
+    m_clock.start();
+
+    static QAtomicInt counter;
+    int id = counter.fetchAndAddRelaxed(1);
+#ifdef WIN32
+    m_pipe = QString("\\\\.\\pipe\\ppp-trace-%1-%2").arg(QCoreApplication::applicationPid()).arg(id).toLocal8Bit();
+    // 第一个实例在返回前创建，之后traceopen即可打开
+    m_next = CreateNamedPipeA(m_pipe.constData(), PIPE_ACCESS_INBOUND, PIPE_TYPE_BYTE | PIPE_WAIT,
+                              PIPE_UNLIMITED_INSTANCES, 0, DWORD(PIPE_BYTES), 0, NULL);
+    if (m_next == INVALID_HANDLE_VALUE) {
+        *error = QString("cannot create pipe %1").arg(m_pipe.constData());
+        m_file.reset();
+        return false;
+    }
+#else
+    m_dir.reset(new QTemporaryDir);
+    m_pipe = QFile::encodeName(m_dir->filePath(QString("trace-%1").arg(id)));
+    if (!m_dir->isValid() || mkfifo(m_pipe.constData(), 0600)) {
+        *error = QString("cannot create fifo %1 (%2)").arg(m_pipe.constData(), strerror(errno));
+        m_dir.reset();
+        m_file.reset();
+        return false;
+    }
+#endif
+    m_reader = QThread::create([this]() { serve(); });
+    m_writer = QThread::create([this]() { flush(); });
+    m_reader->start();
+    m_writer->start();
+    return true;
+}
+
+void PPPTracer::stop()
+{
+    if (!m_reader) {
+        return;
+    }
+    // 读取线程可能正在等待下一次打开，连接一次使其返回，直到线程结束
+    m_stopReader = true;
+    while (!m_reader->wait(10)) {
+#ifdef WIN32
+        HANDLE client = CreateFileA(m_pipe.constData(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (client != INVALID_HANDLE_VALUE) CloseHandle(client);
+#else
+        int fd = open(m_pipe.constData(), O_WRONLY | O_NONBLOCK);
+        if (fd >= 0) close(fd);
+#endif
+    }
+    m_stopWriter = true;
+    m_writer->wait();
+    delete m_reader;
+    delete m_writer;
+    m_reader = m_writer = nullptr;
+    m_file.reset();
+#ifndef WIN32
+    unlink(m_pipe.constData());
+    m_dir.reset();
+#endif
+}
+
+QByteArray PPPTracer::pipePath() const
+{
+    return m_pipe;
+}
+
+void PPPTracer::epoch(gtime_t time, int stat, int ns, double micros)
+{
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.tick = quint64(m_clock.nsecsElapsed());
+    entry.type = ENTRY_EPOCH;
+    EpochPayload payload;
+    memset(&payload, 0, sizeof(payload));
+    payload.time = qint64(time.time);
+    payload.sec = time.sec;
+    payload.micros = float(micros);
+    payload.stat = quint8(stat);
+    payload.ns = quint8(ns);
+    entry.length = sizeof(payload);
+    memcpy(entry.payload, &payload, sizeof(payload));
+    push(&entry, 1);
+}
+
+qint64 PPPTracer::entries() const
+{
+    return m_entries;
+}
+
+qint64 PPPTracer::dropped() const
+{
+    return m_dropped;
+}
+
+qint64 PPPTracer::textBytes() const
+{
+    return m_textBytes;
+}
+
+qint64 PPPTracer::fileBytes() const
+{
+    return m_fileBytes;
+}
+
+bool PPPTracer::push(const Entry *entries, int count)
+{
+    if (count > RING_ENTRIES) {
+        m_dropped += count;
+        return false;
+    }
+    quint64 pos = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+        // pos起的count个槽都可写时才占用：槽的序号只有占用该位置的写入方和读取方会修改，
+        // 检查之后其他写入方占用这些位置会使head改变，下面的比较交换失败
+        qint64 diff = 0;
+        for (int i = 0; i < count && diff == 0; i++) {
+            diff = qint64(m_slots[(pos + i) & m_mask].sequence.load(std::memory_order_acquire) - (pos + i));
+        }
+        if (diff == 0) {
+            if (m_head.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+                for (int i = 0; i < count; i++) {
+                    Slot &slot = m_slots[(pos + i) & m_mask];
+                    slot.entry = entries[i];
+                    slot.sequence.store(pos + i + 1, std::memory_order_release);
+                }
+                return true;
+            }
+        } else if (diff < 0) {
+            m_dropped += count;  // 缓冲区已满，整行丢弃
+            return false;
+        } else {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool PPPTracer::pop(Entry *entry)
+{
+    Slot &slot = m_slots[m_tail & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1) {
+        return false;
+    }
+    *entry = slot.entry;
+    slot.sequence.store(m_tail + RING_ENTRIES, std::memory_order_release);
+    m_tail++;
+    return true;
+}
+
+void PPPTracer::consume(const char *data, qint64 size)
+{
+    m_textBytes += size;
+    m_line.append(data, int(size));
+    int start = 0, end;
+    while ((end = m_line.indexOf('\n', start)) >= 0) {
+        textLine(m_line.constData() + start, end - start);
+        start = end + 1;
+    }
+    m_line.remove(0, start);
+}
+
+void PPPTracer::textLine(const char *line, int length)
+{
+    if (length > 0 && line[length - 1] == '\r') length--; // Windows文本方式写出的换行
+    Entry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.tick = quint64(m_clock.nsecsElapsed());
+    entry.type = ENTRY_TEXT;
+
+    // trace/tracet的行以"级别 "开头，tracemat等输出的行没有级别
+    if (length >= 2 && line[0] >= '1' && line[0] <= '9' && line[1] == ' ') {
+        entry.level = quint8(line[0] - '0');
+        line += 2;
+        length -= 2;
+    }
+    m_parts.clear();
+    do {
+        entry.length = quint8(qMin(length, PAYLOAD_BYTES));
+        memcpy(entry.payload, line, entry.length);
+        m_parts.push_back(entry);
+        line += entry.length;
+        length -= entry.length;
+        entry.type = ENTRY_CONTINUED;
+    } while (length > 0);
+    push(m_parts.data(), int(m_parts.size()));
+}
+
+#ifdef WIN32
+void PPPTracer::serve()
+{
+    std::vector<char> buffer(PIPE_BYTES);
+    while (m_next != INVALID_HANDLE_VALUE) {
+        HANDLE pipe = m_next;
+        m_next = INVALID_HANDLE_VALUE;
+        bool connected = ConnectNamedPipe(pipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED;
+        if (connected && !m_stopReader) {
+            // RTKLIB每天切换跟踪文件时重新打开，连接到下一个实例
+            m_next = CreateNamedPipeA(m_pipe.constData(), PIPE_ACCESS_INBOUND, PIPE_TYPE_BYTE | PIPE_WAIT,
+                                      PIPE_UNLIMITED_INSTANCES, 0, DWORD(PIPE_BYTES), 0, NULL);
+            DWORD n = 0;
+            while (ReadFile(pipe, buffer.data(), DWORD(buffer.size()), &n, NULL) && n > 0) {
+                consume(buffer.data(), n);
+            }
+            if (!m_line.isEmpty()) {
+                textLine(m_line.constData(), m_line.size());
+                m_line.clear();
+            }
+        }
+        DisconnectNamedPipe(pipe);
+        CloseHandle(pipe);
+    }
+}
+#else
+void PPPTracer::serve()
+{
+    std::vector<char> buffer(PIPE_BYTES);
+    while (!m_stopReader) {
+        // 等待RTKLIB打开（traceopen，以及每天切换跟踪文件时重新打开）
+        int fd = open(m_pipe.constData(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (;;) {
+            ssize_t n = read(fd, buffer.data(), buffer.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            consume(buffer.data(), n);
+        }
+        if (!m_line.isEmpty()) {
+            textLine(m_line.constData(), m_line.size()); // 最后一行没有换行
+            m_line.clear();
+        }
+        close(fd);
+    }
+}
+#endif
+
+void PPPTracer::flush()
+{
+    QByteArray block;
+    block.reserve(BLOCK_BYTES + RECORD_HEADER_BYTES + PAYLOAD_BYTES);
+    QElapsedTimer sinceFlush;
+    sinceFlush.start();
+    qint64 reported = 0;
+    Entry entry;
+    auto append = [&block](const Entry &e) {
+        char header[RECORD_HEADER_BYTES];
+        memcpy(header, &e.tick, 8);
+        header[8] = char(e.type);
+        header[9] = char(e.level);
+        header[10] = char(e.length);
+        block.append(header, RECORD_HEADER_BYTES);
+        block.append(e.payload, e.length);
+    };
+    for (;;) {
+        // 先读取停止标志：停止时读取线程已结束，之后不会再有新的条目
+        bool stopping = m_stopWriter;
+        int n = 0;
+        while (pop(&entry)) {
+            append(entry);
+            n++;
+            if (block.size() >= BLOCK_BYTES) {
+                writeBlock(&block);
+                sinceFlush.restart();
+            }
+        }
+        m_entries += n;
+        qint64 dropped = m_dropped;
+        if (dropped != reported) {
+            memset(&entry, 0, sizeof(entry));
+            entry.tick = quint64(m_clock.nsecsElapsed());
+            entry.type = ENTRY_DROPPED;
+            entry.length = sizeof(qint64);
+            qint64 count = dropped - reported;
+            memcpy(entry.payload, &count, sizeof(count));
+            append(entry);
+            reported = dropped;
+        }
+        if (stopping) {
+            break;
+        }
+        if (!block.isEmpty() && sinceFlush.elapsed() >= FLUSH_MSECS) {
+            writeBlock(&block);
+            sinceFlush.restart();
+        }
+        if (n == 0) {
+            QThread::msleep(IDLE_MSECS);
+        }
+    }
+    writeBlock(&block);
+    m_file->close();
+}
+
+bool PPPTracer::writeBlock(QByteArray *block)
+{
+    if (block->isEmpty()) {
+        return true;
+    }
+    TraceBlockHeader header;
+    header.raw = quint32(block->size());
+    QByteArray data;
+#ifdef PPP_WITH_ZLIB
+    uLongf size = compressBound(uLong(block->size()));
+    data.resize(int(size));
+    if (compress2(reinterpret_cast<Bytef *>(data.data()), &size, reinterpret_cast<const Bytef *>(block->constData()),
+                  uLong(block->size()), Z_BEST_SPEED) != Z_OK) {
+        m_failed = true;
+    }
+    data.resize(int(size));
+#else
+    data = *block;
+#endif
+    block->clear();
+    header.stored = quint32(data.size());
+    if (!m_failed && (m_file->write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+                      m_file->write(data) != data.size())) {
+        m_failed = true; // 磁盘已满等，之后的条目不再写出
+    }
+    if (!m_failed) {
+        m_fileBytes += qint64(sizeof(header)) + data.size();
+    }
+    return !m_failed;
+}
+
+bool PPPTracer::decode(const QString &path, const QString &outfile, QString *error)
+{
+    QFile file(path);
+    TraceFileHeader header;
+    if (!file.open(QIODevice::ReadOnly) ||
+        file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header)) ||
+        memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic))) {
+        *error = QString("无法打开跟踪文件: %1").arg(path);
+        return false;
+    }
+#ifndef PPP_WITH_ZLIB
+    if (header.flags & TRACE_COMPRESSED) {
+        *error = "跟踪文件经zlib压缩，构建时未找到zlib";
+        return false;
+    }
+#endif
+    QByteArray name = outfile.toLocal8Bit();
+    FILE *fp = fopen(name.constData(), "w");
+    if (!fp) {
+        *error = QString("无法创建文件: %1").arg(outfile);
+        return false;
+    }
+    bool open = false;  // 当前行尚未结束
+    bool ok = true;
+    TraceBlockHeader block;
+    while (ok && file.read(reinterpret_cast<char *>(&block), sizeof(block)) == qint64(sizeof(block))) {
+        QByteArray stored = file.read(block.stored);
+        QByteArray data;
+        if (stored.size() != int(block.stored)) {
+            break; // 写出时中断，忽略不完整的块
+        }
+        if (header.flags & TRACE_COMPRESSED) {
+#ifdef PPP_WITH_ZLIB
+            uLongf size = block.raw;
+            data.resize(int(block.raw));
+            ok = uncompress(reinterpret_cast<Bytef *>(data.data()), &size,
+                            reinterpret_cast<const Bytef *>(stored.constData()), uLong(stored.size())) == Z_OK &&
+                 size == block.raw;
+#endif
+        } else {
+            data = stored;
+            ok = block.raw == block.stored;
+        }
+        const char *p = data.constData(), *end = p + data.size();
+        while (ok && end - p >= RECORD_HEADER_BYTES) {
+            quint64 tick;
+            memcpy(&tick, p, 8);
+            int type = quint8(p[8]), level = quint8(p[9]), length = quint8(p[10]);
+            p += RECORD_HEADER_BYTES;
+            if (end - p < length) {
+                ok = false;
+                break;
+            }
+            if (type == ENTRY_CONTINUED) {
+                fwrite(p, 1, length, fp);
+            } else {
+                if (open) fputc('\n', fp);
+                open = false;
+                if (type == ENTRY_TEXT) {
+                    if (level > 0) fprintf(fp, "%d ", level);
+                    fwrite(p, 1, length, fp);
+                    open = true;
+                } else if (type == ENTRY_EPOCH && length >= int(sizeof(EpochPayload))) {
+                    EpochPayload epoch;
+                    memcpy(&epoch, p, sizeof(epoch));
+                    gtime_t time = { time_t(epoch.time), epoch.sec };
+                    char str[64];
+                    time2str(time, str, 3);
+                    fprintf(fp, "# %.6f epoch %s Q=%d ns=%d %.1f us\n", tick * 1E-9, str, epoch.stat, epoch.ns,
+                            epoch.micros);
+                } else if (type == ENTRY_DROPPED && length >= int(sizeof(qint64))) {
+                    qint64 count;
+                    memcpy(&count, p, sizeof(count));
+                    fprintf(fp, "# %.6f dropped %lld entries\n", tick * 1E-9, count);
+                }
+            }
+            p += length;
+        }
+    }
+    if (open) fputc('\n', fp);
+    bool written = !ferror(fp);
+    fclose(fp);
+    if (!ok) {
+        *error = QString("跟踪文件已损坏: %1").arg(path);
+        return false;
+    }
+    if (!written) {
+        *error = QString("无法写入文件: %1").arg(outfile);
+        return false;
+    }
+    return true;
+}
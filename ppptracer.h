@@ -0,0 +1,95 @@
+#ifndef PPPTRACER_H
+#define PPPTRACER_H
+
+#include "rtklib.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QFile;
+class QTemporaryDir;
+class QThread;
+
+// 异步二进制跟踪日志
+// RTKLIB的trace每行格式化后立即fflush到日志文件，级别3时长时间处理的日志写入拖慢处理并占满磁盘。
+// RTKLIB的跟踪函数在预编译的库中无法替换，本类让traceopen打开命名管道（Windows）或FIFO（其他系统），
+// 读取线程把每行拆成定长的二进制条目放入无锁环形缓冲区；PPPEngine的历元事件也直接写入缓冲区。
+// 写出线程按块取出条目写入跟踪文件（有zlib时压缩），处理线程不等待磁盘。
+// 缓冲区满时丢弃条目并计数，不阻塞处理；一行拆成的各条目一次占用连续的槽，放不下时整行丢弃，
+// 解码时不会出现缺少开头的后续条目。decode()把跟踪文件还原为与RTKLIB相同的文本。
+// 限制：RTKLIB仍在处理线程中格式化每一行并fflush到管道，每次trace调用的格式化和一次写管道仍然存在，
+// 本类只去掉了磁盘写入和文件增长的开销；管道缓冲区由读取线程及时取空，写管道不等待磁盘。
+// 同一进程同一时刻只能有一个跟踪器（RTKLIB的跟踪文件是全局的）。
+class PPPTracer
+{
+public:
+    PPPTracer();
+    ~PPPTracer();
+
+    // 创建管道并启动读取和写出线程，之后以pipePath()调用traceopen
+    bool start(const QString &path, QString *error);
+
+    // 在traceclose之后调用：读取管道中剩余的内容，写出全部条目并关闭文件
+    void stop();
+
+    QByteArray pipePath() const;
+
+    // 记录一个历元（处理线程调用）：时间、解算质量、卫星数、rtkpos耗时 (us)
+    void epoch(gtime_t time, int stat, int ns, double micros);
+
+    qint64 entries() const;        // 写出的条目数
+    qint64 dropped() const;        // 缓冲区满时丢弃的条目数
+    qint64 textBytes() const;      // 读取的跟踪文本字节数
+    qint64 fileBytes() const;      // 跟踪文件的字节数
+
+    // 跟踪文件转换为文本：RTKLIB的跟踪输出与原文本相同，历元事件和丢弃记录为以#开头的行
+    static bool decode(const QString &path, const QString &outfile, QString *error);
+
+private:
+    struct Entry;
+    struct Slot;
+
+    // 一次放入count个连续的条目，缓冲区放不下时全部丢弃
+    bool push(const Entry *entries, int count);
+    bool pop(Entry *entry);
+
+    // 读取线程：从管道读取RTKLIB的输出，按行拆分为条目
+    void serve();
+    void consume(const char *data, qint64 size);
+    void textLine(const char *line, int length);
+
+    // 写出线程
+    void flush();
+    bool writeBlock(QByteArray *block);
+
+    QString m_path;
+    QByteArray m_pipe;
+    std::unique_ptr<QTemporaryDir> m_dir;  // FIFO所在目录（Windows使用命名管道，不需要）
+    std::unique_ptr<QFile> m_file;
+    std::unique_ptr<Slot[]> m_slots;
+    quint64 m_mask;
+    alignas(64) std::atomic<quint64> m_head;  // 下一个写入位置（多个写入方）
+    alignas(64) quint64 m_tail;               // 下一个读取位置（只有写出线程）
+    std::atomic<qint64> m_dropped;
+    std::atomic<qint64> m_entries;
+    std::atomic<qint64> m_textBytes;
+    std::atomic<qint64> m_fileBytes;
+    QElapsedTimer m_clock;
+    QByteArray m_line;       // 读取线程中未结束的行
+    std::vector<Entry> m_parts; // 读取线程中一行拆成的条目
+    QThread *m_reader;
+    QThread *m_writer;
+    std::atomic<bool> m_stopReader;
+    std::atomic<bool> m_stopWriter;
+    bool m_failed;           // 写出失败，之后的条目丢弃
+#ifdef WIN32
+    void *m_next;            // 等待连接的管道实例
+#endif
+
+    Q_DISABLE_COPY(PPPTracer)
+};
+
+#endif // PPPTRACER_H
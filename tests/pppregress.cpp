@@ -0,0 +1,460 @@
+// 回归测试：各项优化的输出与原来的处理流程逐字节比较
+// 用法: ppp_regress <测试名>，样例任务由环境变量PPP_TEST_JOB（任务文件）给出，未设置时跳过
+//   decompress <目录> 目录中的样例压缩文件（多成员gzip、.Z、CRINEX 1/3）由解码器直接解压和经管道读取，
+//                 都与解压后的文件逐字节相同，不需要样例任务
+//   obs           PPPObsReader读取的观测数据与readrnxt逐位相同
+//   engine        PPPEngine处理（产品缓存、写检查点、观测数据缓存的写入和读取）的.pos和.stat与postpos相同
+//   stream        流式处理的输出与postpos相同
+//   resume        处理中断后从检查点恢复，输出与postpos相同
+//   resume-stream 流式处理中断后从检查点恢复，输出与postpos相同
+//   kill          处理进程被强制结束后从检查点恢复，输出与postpos相同
+//   kill-stream   流式处理的进程被强制结束后从检查点恢复，输出与postpos相同
+// 任务文件中的输出文件、日志和各项优化选项被忽略，输出写在临时目录中
+#include "pppdecompress.h"
+#include "pppengine.h"
+#include "pppjobfile.h"
+#include "pppobsreader.h"
+#include "pppproductcache.h"
+#include "pppprocessor.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QThread>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+// 退出码，77为CTest的跳过
+enum {
+    EXIT_OK = 0,
+    EXIT_FAILED = 1,
+    EXIT_USAGE = 2,
+    EXIT_SKIPPED = 77
+};
+
+// 逐字节比较，不同时输出第一处不同所在的行号
+static bool sameBytes(const QByteArray &x, const QByteArray &y, const QString &expected, const QString &actual)
+{
+    if (x == y) {
+        return true;
+    }
+    int i = 0, n = qMin(x.size(), y.size());
+    while (i < n && x[i] == y[i]) i++;
+    fprintf(stderr, "%s 与 %s 不同（大小 %d/%d 字节，第 %d 行起）\n", actual.toLocal8Bit().constData(),
+            expected.toLocal8Bit().constData(), int(x.size()), int(y.size()), int(x.left(i).count('\n')) + 1);
+    return false;
+}
+
+static bool sameFile(const QString &expected, const QString &actual)
+{
+    QFile a(expected), b(actual);
+    if (!a.open(QIODevice::ReadOnly) || !b.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "无法打开 %s 或 %s\n", expected.toLocal8Bit().constData(), actual.toLocal8Bit().constData());
+        return false;
+    }
+    return sameBytes(a.readAll(), b.readAll(), expected, actual);
+}
+
+// 结果文件和状态文件都与参考输出相同（参考输出没有状态文件时只比较结果文件）
+static bool sameOutput(const QString &expected, const QString &actual)
+{
+    bool same = sameFile(expected, actual);
+    if (QFile::exists(expected + ".stat")) {
+        same = sameFile(expected + ".stat", actual + ".stat") && same;
+    }
+    return same;
+}
+
+// 读取样例任务，关闭各项优化选项，得到只读取输入并前向解算的任务
+static bool loadJob(ppp_paths_t *paths)
+{
+    QByteArray path = qgetenv("PPP_TEST_JOB");
+    if (path.isEmpty()) {
+        fprintf(stderr, "未设置PPP_TEST_JOB，跳过\n");
+        return false;
+    }
+    QString error;
+    if (!PPPJobFile::load(QString::fromLocal8Bit(path), paths, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return false;
+    }
+    paths->trace_level = 0;
+    paths->soltype = SOLTYPE_FORWARD;
+    paths->solformat = SOLFORMAT_TEXT;
+    paths->shards = 0;
+    paths->checkpoint = false;
+    paths->obs_cache[0] = '\0';
+    paths->stream = false;
+    paths->station_db[0] = '\0';
+    paths->early_stop = false;
+    return true;
+}
+
+static void setOutFile(ppp_paths_t *paths, const QString &file)
+{
+    QByteArray out = file.toLocal8Bit();
+    qstrncpy(paths->out_file, out.constData(), sizeof(paths->out_file));
+}
+
+// 由RTKLIB的postpos处理一个任务，作为参考输出（PPPProcessor的前向解算由PPPEngine处理）
+static bool postprocess(const ppp_paths_t &paths, const QString &outfile)
+{
+    ppp_paths_t job = paths;
+    setOutFile(&job, outfile);
+    PPPProcessor::checkInputFiles(&job);
+    prcopt_t prcopt;
+    solopt_t solopt;
+    filopt_t filopt;
+    PPPProcessor::initOptions(&job, &prcopt, &solopt, &filopt);
+    PPPDecompressor decompressor;
+    char *infiles[8] = { 0 };
+    QString error;
+    int n = decompressor.prepare(&job, &filopt, &error) ? PPPProcessor::inputFiles(&job, infiles) : 0;
+    if (n < 2) {
+        fprintf(stderr, "错误: %s\n", error.isEmpty() ? "需要至少一个观测文件和导航/精密星历文件" : error.toLocal8Bit().constData());
+        return false;
+    }
+    gtime_t ts = { 0 }, te = { 0 };
+    if (job.use_time_range) {
+        ts = epoch2time(job.ts);
+        te = epoch2time(job.te);
+    }
+    int ret = postpos(ts, te, job.ti, 0.0, &prcopt, &solopt, &filopt, infiles, n, job.out_file, (char *)"", (char *)"");
+    if (ret != 0 || !decompressor.errors().isEmpty()) {
+        fprintf(stderr, "postpos处理失败（返回 %d）\n", ret);
+        return false;
+    }
+    return true;
+}
+
+// 由PPPProcessor处理一个任务
+static bool execute(const ppp_paths_t &paths, const QString &outfile)
+{
+    ppp_paths_t job = paths;
+    setOutFile(&job, outfile);
+    PPPProcessor processor;
+    processor.setPaths(job);
+    bool success = processor.execute();
+    if (!success) {
+        fprintf(stderr, "%s\n", processor.getStatusMessage().toLocal8Bit().constData());
+    }
+    return success;
+}
+
+// 观测数据：PPPObsReader与readrnxt
+static int testObs(const ppp_paths_t &paths)
+{
+    if (PPPDecompressor::isCompressed(QString::fromLocal8Bit(paths.obs_file))) {
+        fprintf(stderr, "观测文件为压缩文件，PPPObsReader直接使用readrnxt，跳过\n");
+        return EXIT_SKIPPED;
+    }
+    ppp_paths_t job = paths;
+    prcopt_t prcopt;
+    solopt_t solopt;
+    filopt_t filopt;
+    PPPProcessor::initOptions(&job, &prcopt, &solopt, &filopt);
+    gtime_t ts = { 0 }, te = { 0 };
+    if (job.use_time_range) {
+        ts = epoch2time(job.ts);
+        te = epoch2time(job.te);
+    }
+
+    obs_t obs[2] = {};
+    sta_t sta[2] = {};
+    nav_t *nav[2] = { new nav_t(), new nav_t() };
+    int stat[2];
+    stat[0] = readrnxt(job.obs_file, 1, ts, te, job.ti, prcopt.rnxopt[0], &obs[0], nav[0], &sta[0]);
+    PPPObsReader reader;
+    stat[1] = reader.read(job.obs_file, 1, ts, te, job.ti, prcopt.rnxopt[0], &obs[1], nav[1], &sta[1]);
+
+    bool same = stat[0] == stat[1] && obs[0].n == obs[1].n && PPPObsReader::sameStation(sta[0], sta[1]) &&
+                !memcmp(nav[0]->glo_fcn, nav[1]->glo_fcn, sizeof(nav[0]->glo_fcn));
+    int i = 0;
+    for (; same && i < obs[0].n; i++) {
+        same = PPPObsReader::sameObs(obs[0].data[i], obs[1].data[i]);
+    }
+    if (reader.chunkCount() == 0) {
+        fprintf(stderr, "观测文件不能分段解码（非RINEX 3观测文件、文件较小或含事件记录），两次都由readrnxt读取\n");
+    }
+    if (!same) {
+        fprintf(stderr, "观测数据不同：%d/%d 条观测，第 %d 条起\n", obs[0].n, obs[1].n, i);
+    }
+    for (int k = 0; k < 2; k++) {
+        freeobs(&obs[k]);
+        freenav(nav[k], 0xFF);
+        delete nav[k];
+    }
+    return stat[0] >= 0 && same ? EXIT_OK : EXIT_FAILED;
+}
+
+// PPPEngine（产品缓存、检查点、观测数据缓存）与postpos
+static int testEngine(const ppp_paths_t &paths, const QDir &dir)
+{
+    QString reference = dir.filePath("postpos.pos");
+    if (!postprocess(paths, reference)) {
+        return EXIT_FAILED;
+    }
+    // 与界面中连续两次处理相同：第一次读取精密产品并放入缓存，第二次由缓存读取
+    PPPProductCache::instance().setBudget(qint64(512) << 20);
+    bool same = true;
+    for (const char *name : { "engine1.pos", "engine2.pos" }) {
+        same = execute(paths, dir.filePath(name)) && sameOutput(reference, dir.filePath(name)) && same;
+    }
+    PPPProductCache::instance().setBudget(0);
+
+    ppp_paths_t job = paths;
+    job.checkpoint = true;
+    same = execute(job, dir.filePath("checkpoint.pos")) && sameOutput(reference, dir.filePath("checkpoint.pos")) && same;
+
+    // 第一次写入缓存，第二次由缓存读取
+    job = paths;
+    QByteArray cache = dir.filePath("cache").toLocal8Bit();
+    qstrncpy(job.obs_cache, cache.constData(), sizeof(job.obs_cache));
+    for (const char *name : { "cache1.pos", "cache2.pos" }) {
+        same = execute(job, dir.filePath(name)) && sameOutput(reference, dir.filePath(name)) && same;
+    }
+    return same ? EXIT_OK : EXIT_FAILED;
+}
+
+// 流式处理与postpos
+static int testStream(const ppp_paths_t &paths, const QDir &dir)
+{
+    QString reference = dir.filePath("postpos.pos");
+    if (!postprocess(paths, reference)) {
+        return EXIT_FAILED;
+    }
+    ppp_paths_t job = paths;
+    job.stream = true;
+    QString outfile = dir.filePath("stream.pos");
+    return execute(job, outfile) && sameOutput(reference, outfile) ? EXIT_OK : EXIT_FAILED;
+}
+
+// 写检查点处理任务（检查点间隔为0，尽快写出检查点），cancel不为空时可被取消
+// 返回PPPEngine::process的返回值，读取输入失败为-1，观测文件不能流式读取为-2
+static int processCheckpointed(const ppp_paths_t &paths, const QString &outfile, bool stream,
+                               const std::atomic<bool> *cancel, bool *resumed)
+{
+    ppp_paths_t job = paths;
+    setOutFile(&job, outfile);
+    job.checkpoint = true;
+    job.stream = stream;
+
+    prcopt_t prcopt;
+    solopt_t solopt;
+    PPPInputs inputs;
+    inputs.setStreaming(stream);
+    QString error;
+    if (!PPPProcessor::loadInputs(&job, &prcopt, &solopt, &inputs, &error)) {
+        fprintf(stderr, "%s\n", error.toLocal8Bit().constData());
+        return -1;
+    }
+    if (stream && !inputs.streaming()) {
+        fprintf(stderr, "观测文件不能流式读取（非RINEX 3观测文件或压缩文件），跳过\n");
+        return -2;
+    }
+    PPPEngine engine;
+    PPPProcessor::setupEngine(&job, &engine);
+    engine.setCheckpointInterval(0.0);
+    engine.setCancelFlag(cancel);
+    int ret = engine.process(&inputs, &solopt, job.out_file);
+    if (resumed) *resumed = engine.resumed();
+    return ret;
+}
+
+// 处理中断后从检查点恢复，结果与不中断的postpos相同
+// kill为false时检查点出现后取消处理；为true时在子进程中处理，检查点出现后强制结束子进程，
+// 结果文件和状态文件停在任意位置（可能有检查点之后的记录和不完整的行），与崩溃或断电相同
+static int testResume(const ppp_paths_t &paths, const QDir &dir, bool stream, bool kill)
+{
+    QString reference = dir.filePath("postpos.pos");
+    if (!postprocess(paths, reference)) {
+        return EXIT_FAILED;
+    }
+    QString outfile = dir.filePath("resume.pos");
+    QString checkpoint = outfile + ".ckpt";
+    int ret;
+    if (kill) {
+        QProcess child;
+        child.setProcessChannelMode(QProcess::ForwardedChannels);
+        child.start(QCoreApplication::applicationFilePath(), { stream ? "child-stream" : "child", outfile });
+        if (!child.waitForStarted()) {
+            fprintf(stderr, "错误: 无法启动子进程\n");
+            return EXIT_FAILED;
+        }
+        while (child.state() == QProcess::Running && !QFile::exists(checkpoint)) {
+            child.waitForFinished(1);
+        }
+        child.waitForFinished(20); // 之后还会写出若干检查点，在两个检查点之间结束
+        if (child.state() != QProcess::Running) {
+            if (child.exitCode() == EXIT_SKIPPED) {
+                return EXIT_SKIPPED;
+            }
+            fprintf(stderr, "子进程在结束前已退出（退出码 %d），观测数据过短，无法测试恢复\n", child.exitCode());
+            return EXIT_FAILED;
+        }
+        child.kill();
+        child.waitForFinished();
+    } else {
+        // 检查点文件出现后设置取消标志，引擎在之后的某个历元返回
+        std::atomic<bool> cancel{ false };
+        std::atomic<bool> finished{ false };
+        QThread *watcher = QThread::create([&checkpoint, &cancel, &finished]() {
+            while (!finished && !QFile::exists(checkpoint)) {
+                QThread::msleep(1);
+            }
+            cancel = true;
+        });
+        watcher->start();
+        ret = processCheckpointed(paths, outfile, stream, &cancel, nullptr);
+        finished = true;
+        watcher->wait();
+        delete watcher;
+        if (ret == -2) {
+            return EXIT_SKIPPED;
+        }
+        if (ret != 1) {
+            fprintf(stderr, "处理在中断前已结束（返回 %d），观测数据过短，无法测试恢复\n", ret);
+            return EXIT_FAILED;
+        }
+    }
+
+    // 再次处理从检查点恢复
+    bool resumed = false;
+    ret = processCheckpointed(paths, outfile, stream, nullptr, &resumed);
+    if (ret != 0 || !resumed) {
+        fprintf(stderr, "恢复处理失败（返回 %d，%s）\n", ret, resumed ? "已恢复" : "未从检查点恢复");
+        return EXIT_FAILED;
+    }
+    return sameOutput(reference, outfile) ? EXIT_OK : EXIT_FAILED;
+}
+
+// 与RTKLIB一样用fopen读取整个文件（管道）
+static QByteArray readWhole(const char *path)
+{
+    QByteArray data;
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return data;
+    }
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), fp)) > 0) {
+        data.append(block, int(n));
+    }
+    fclose(fp);
+    return data;
+}
+
+// 解压：样例压缩文件由解码器直接解压和经管道读取两次（RTKLIB可能多次打开同一输入文件），
+// 都与同一目录中解压后的文件逐字节相同
+static int testDecompress(const QDir &data)
+{
+    int files = 0;
+    bool same = true;
+    for (const QString &name : data.entryList(QDir::Files, QDir::Name)) {
+        QString target = PPPDecompressor::decompressedName(name);
+        if (target == name) {
+            continue; // 解压后的文件
+        }
+        QString path = data.filePath(name);
+        if (!PPPDecompressor::isCompressed(path)) {
+            fprintf(stderr, "%s: 构建时未找到zlib，跳过\n", name.toLocal8Bit().constData());
+            continue;
+        }
+        QFile file(data.filePath(target));
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "错误: 无法打开 %s\n", file.fileName().toLocal8Bit().constData());
+            return EXIT_FAILED;
+        }
+        QByteArray expected = file.readAll();
+        files++;
+
+        QByteArray direct;
+        QString error;
+        bool ok = PPPDecompressor::decompress(path, [&direct](const char *block, qint64 size) {
+            direct.append(block, int(size));
+            return true;
+        }, &error);
+        ok = ok && sameBytes(expected, direct, file.fileName(), path);
+
+        ppp_paths_t paths;
+        PPPProcessor::initPaths(&paths);
+        filopt_t filopt = {};
+        qstrncpy(paths.obs_file, path.toLocal8Bit().constData(), sizeof(paths.obs_file));
+        PPPDecompressor pipe;
+        if (pipe.prepare(&paths, &filopt, &error) && pipe.files().size() == 1) {
+            QString pipePath = QString::fromLocal8Bit(paths.obs_file);
+            for (int i = 0; i < 2; i++) {
+                ok = sameBytes(expected, readWhole(paths.obs_file), file.fileName(), pipePath) && ok;
+            }
+            if (!pipe.errors().isEmpty()) {
+                error = pipe.errors().join("; ");
+                ok = false;
+            }
+        } else {
+            ok = false;
+        }
+        if (!error.isEmpty()) {
+            fprintf(stderr, "%s: %s\n", name.toLocal8Bit().constData(), error.toLocal8Bit().constData());
+        }
+        fprintf(stderr, "%s -> %s: %s\n", name.toLocal8Bit().constData(), target.toLocal8Bit().constData(),
+                ok ? "相同" : "不同");
+        same = same && ok;
+    }
+    if (files == 0) {
+        fprintf(stderr, "错误: %s 中没有样例压缩文件\n", data.path().toLocal8Bit().constData());
+        return EXIT_USAGE;
+    }
+    return same ? EXIT_OK : EXIT_FAILED;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (argc < 2) {
+        fprintf(stderr, "用法: ppp_regress obs|engine|stream|resume|resume-stream|kill|kill-stream\n"
+                        "      ppp_regress decompress <样例压缩文件目录>\n");
+        return EXIT_USAGE;
+    }
+    if (!strcmp(argv[1], "decompress") && argc == 3) {
+        return testDecompress(QDir(QString::fromLocal8Bit(argv[2])));
+    }
+    ppp_paths_t paths;
+    if (!loadJob(&paths)) {
+        return qEnvironmentVariableIsEmpty("PPP_TEST_JOB") ? EXIT_SKIPPED : EXIT_USAGE;
+    }
+    // 各测试只处理一个任务，与ppp_cli处理单个任务时一样不缓存产品
+    PPPProductCache::instance().setBudget(0);
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        fprintf(stderr, "错误: 无法创建临时目录\n");
+        return EXIT_FAILED;
+    }
+    QDir out(dir.path());
+    const char *test = argv[1];
+    if (!strcmp(test, "obs")) {
+        return testObs(paths);
+    } else if (!strcmp(test, "engine")) {
+        return testEngine(paths, out);
+    } else if (!strcmp(test, "stream")) {
+        return testStream(paths, out);
+    } else if (!strcmp(test, "resume")) {
+        return testResume(paths, out, false, false);
+    } else if (!strcmp(test, "resume-stream")) {
+        return testResume(paths, out, true, false);
+    } else if (!strcmp(test, "kill")) {
+        return testResume(paths, out, false, true);
+    } else if (!strcmp(test, "kill-stream")) {
+        return testResume(paths, out, true, true);
+    } else if ((!strcmp(test, "child") || !strcmp(test, "child-stream")) && argc == 3) {
+        // kill测试的子进程：处理到被父进程结束
+        int ret = processCheckpointed(paths, QString::fromLocal8Bit(argv[2]), !strcmp(test, "child-stream"), nullptr,
+                                      nullptr);
+        return ret == -2 ? EXIT_SKIPPED : ret == 0 ? EXIT_OK : EXIT_FAILED;
+    }
+    fprintf(stderr, "未知的测试: %s\n", test);
+    return EXIT_USAGE;
+}
@@ -0,0 +1,555 @@
+// 性能测试工具：比较各项优化前后的耗时并检查结果是否一致
+// 与处理无关，不随ppp_cli安装；界面原来的结果文件解析方式只保留在这里作为比较对象
+#include "pppdecompress.h"
+#include "pppjobfile.h"
+#include "posfile.h"
+#include "pppobsreader.h"
+#include "pppproductcache.h"
+#include "pppprocessor.h"
+#include "pppresidualstore.h"
+#include "pppsolutionfile.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QString>
+#include <QTextStream>
+#include <cstdio>
+#include <cstring>
+
+// 退出码
+enum {
+    EXIT_OK = 0,          // 结果一致
+    EXIT_FAILED = 1,      // 处理失败或结果不一致
+    EXIT_USAGE = 2        // 参数或文件错误
+};
+
+static void printUsage()
+{
+    fprintf(stderr,
+            "用法: ppp_bench --obs <观测文件> [-j 线程数]\n"
+            "      ppp_bench --decompress <压缩文件>\n"
+            "      ppp_bench --pos <结果文件>\n"
+            "      ppp_bench --sol <历元数>\n"
+            "      ppp_bench --res <状态文件>\n"
+            "      ppp_bench --trace <任务文件>\n"
+            "      以上测试均可加 --product-cache <MB>（默认不缓存）\n"
+            "  --obs        比较单线程和多线程读取观测文件的耗时，并检查结果是否一致\n"
+            "  --decompress 比较进程内解压与RTKLIB调用外部程序解压的耗时，并检查结果是否一致\n"
+            "  --pos        比较界面原来的正则表达式解析与映射文件逐字段解析结果文件的耗时，并检查结果是否一致\n"
+            "  --sol        比较.pos文本与二进制结果文件的大小、写出和读取速度及按时间窗定位的耗时\n"
+            "  --res        读取结果文件对应的.stat状态文件，统计逐颗卫星残差查询和各系统拒绝次数查询的耗时\n"
+            "  --trace      比较不生成日志、文本日志和二进制日志时每个历元的处理时间和日志大小\n"
+            "退出码: 0 成功且结果一致, 1 处理失败或结果不一致, 2 参数错误\n");
+}
+
+// 观测文件读取测试：readrnxt与多线程读取的耗时和结果
+static int runObsBench(int &argc, char *argv[], const char *file, int threads)
+{
+    QCoreApplication app(argc, argv);
+    QFile source(QString::fromLocal8Bit(file));
+    if (!source.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "错误: 无法打开观测文件 %s\n", file);
+        return EXIT_USAGE;
+    }
+    // 先读一遍文件，两种方式都从系统缓存读取
+    while (!source.atEnd()) {
+        source.read(1 << 20);
+    }
+    double mb = source.size() / 1048576.0;
+    source.close();
+
+    gtime_t t0 = { 0 };
+    obs_t obs[2] = {};
+    sta_t sta[2] = {};
+    nav_t *nav[2] = { new nav_t(), new nav_t() };
+    double seconds[2];
+    QElapsedTimer timer;
+    timer.start();
+    int stat = readrnxt(file, 1, t0, t0, 0.0, "", &obs[0], nav[0], &sta[0]);
+    seconds[0] = timer.restart() / 1000.0;
+
+    PPPObsReader reader;
+    if (threads > 0) {
+        reader.setThreadCount(threads);
+    }
+    reader.read(file, 1, t0, t0, 0.0, "", &obs[1], nav[1], &sta[1]);
+    seconds[1] = timer.elapsed() / 1000.0;
+
+    bool same = obs[0].n == obs[1].n && PPPObsReader::sameStation(sta[0], sta[1]) &&
+                !memcmp(nav[0]->glo_fcn, nav[1]->glo_fcn, sizeof(nav[0]->glo_fcn));
+    for (int i = 0; same && i < obs[0].n; i++) {
+        same = PPPObsReader::sameObs(obs[0].data[i], obs[1].data[i]);
+    }
+    double interval = 0.0;
+    for (int i = 1; i < obs[0].n && interval <= 0.0; i++) {
+        interval = timediff(obs[0].data[i].time, obs[0].data[0].time);
+    }
+
+    fprintf(stdout, "观测文件: %s (%.1f MB，%d 条观测，采样间隔 %g s)\n", file, mb, obs[0].n, interval);
+    fprintf(stdout, "单线程 readrnxt     : %8.2f s %8.1f MB/s\n", seconds[0], mb / qMax(seconds[0], 1E-3));
+    if (reader.chunkCount() > 0) {
+        fprintf(stdout, "多线程 (%2d 段)      : %8.2f s %8.1f MB/s  加速比 %.2f\n", reader.chunkCount(), seconds[1],
+                mb / qMax(seconds[1], 1E-3), seconds[0] / qMax(seconds[1], 1E-3));
+    } else {
+        fprintf(stdout, "文件不能分段解码（非RINEX 3观测文件、文件较小或含事件记录），已使用readrnxt\n");
+    }
+    fprintf(stdout, "结果%s\n", same ? "一致" : "不一致");
+
+    for (int i = 0; i < 2; i++) {
+        freeobs(&obs[i]);
+        freenav(nav[i], 0xFF);
+        delete nav[i];
+    }
+    return stat >= 0 && same ? EXIT_OK : EXIT_FAILED;
+}
+
+// 解压基准：进程内解码器与RTKLIB调用外部程序（gzip/crx2rnx）解压到文件再读取的耗时比较
+static int runDecompressBench(int &argc, char *argv[], const char *file)
+{
+    QCoreApplication app(argc, argv);
+    QString path = QString::fromLocal8Bit(file);
+    QFile source(path);
+    if (!PPPDecompressor::isCompressed(path) || !source.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "错误: 不是可在进程内解压的文件 %s\n", file);
+        return EXIT_USAGE;
+    }
+    // 先读一遍文件，两种方式都从系统缓存读取
+    while (!source.atEnd()) {
+        source.read(1 << 20);
+    }
+    double mb = source.size() / 1048576.0;
+    source.close();
+
+    QCryptographicHash hash[2] = { QCryptographicHash(QCryptographicHash::Md5),
+                                   QCryptographicHash(QCryptographicHash::Md5) };
+    qint64 bytes[2] = { 0, 0 };
+    double seconds[2] = { 0.0, 0.0 };
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    bool ok = PPPDecompressor::decompress(path, [&hash, &bytes](const char *data, qint64 size) {
+        hash[0].addData(QByteArray::fromRawData(data, int(size)));
+        bytes[0] += size;
+        return true;
+    }, &error);
+    seconds[0] = timer.restart() / 1000.0;
+
+    // rtk_uncompress在压缩文件所在目录写出解压后的文件，已有同名文件时不覆盖
+    QString target = QFileInfo(path).dir().filePath(PPPDecompressor::decompressedName(path));
+    char uncfile[1024] = "";
+    int stat = QFile::exists(target) ? 0 : rtk_uncompress(file, uncfile);
+    if (stat > 0) {
+        QFile output(QString::fromLocal8Bit(uncfile));
+        if (output.open(QIODevice::ReadOnly)) {
+            while (!output.atEnd()) {
+                QByteArray block = output.read(1 << 20);
+                hash[1].addData(block);
+                bytes[1] += block.size();
+            }
+            output.close();
+        }
+        seconds[1] = timer.elapsed() / 1000.0;
+        remove(uncfile);
+    }
+
+    double out = bytes[0] / 1048576.0;
+    fprintf(stdout, "压缩文件: %s (%.1f MB，解压后 %.1f MB)\n", file, mb, out);
+    if (!ok) {
+        fprintf(stdout, "进程内解压失败: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    fprintf(stdout, "进程内解压          : %8.2f s %8.1f MB/s\n", seconds[0], out / qMax(seconds[0], 1E-3));
+    if (stat <= 0) {
+        fprintf(stdout, "外部程序解压%s，未比较\n", QFile::exists(target) ? "的输出文件已存在" : "失败（未安装gzip/crx2rnx？）");
+        return EXIT_OK;
+    }
+    bool same = bytes[0] == bytes[1] && hash[0].result() == hash[1].result();
+    fprintf(stdout, "外部程序解压到文件  : %8.2f s %8.1f MB/s  加速比 %.2f\n", seconds[1], out / qMax(seconds[1], 1E-3),
+            seconds[1] / qMax(seconds[0], 1E-3));
+    fprintf(stdout, "结果%s\n", same ? "一致" : "不一致");
+    return same ? EXIT_OK : EXIT_FAILED;
+}
+
+// 结果文件解析的基准测试：界面原来的逐行正则表达式解析与PosFile::load比较
+static int runPosBench(int &argc, char *argv[], const char *file)
+{
+    QCoreApplication app(argc, argv);
+    QString path = QString::fromLocal8Bit(file);
+    QFile source(path);
+    if (!source.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        fprintf(stderr, "错误: 无法打开结果文件 %s\n", file);
+        return EXIT_USAGE;
+    }
+    // 先读一遍文件，两种方式都从系统缓存读取
+    while (!source.atEnd()) {
+        source.read(1 << 20);
+    }
+    double mb = source.size() / 1048576.0;
+    source.seek(0);
+
+    // 原来的解析方式（MainWindow::parseResultFile）：每行构造正则表达式，字段经QString转换
+    struct Legacy {
+        QDateTime timestamp;
+        double values[9];
+        int quality, ns;
+    };
+    QList<Legacy> legacy;
+    QElapsedTimer timer;
+    timer.start();
+    QTextStream in(&source);
+    while (!in.atEnd()) {
+        QString line = in.readLine();
+        if (line.startsWith("%")) {
+            continue;
+        }
+        QRegularExpression re("^(\\d{4}/\\d{2}/\\d{2}\\s+\\d{2}:\\d{2}:\\d{2}\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+(\\d+)\\s+(\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+)\\s+([-+]?\\d+\\.\\d+).*$");
+        QRegularExpressionMatch match = re.match(line);
+        if (match.hasMatch()) {
+            Legacy result;
+            result.timestamp = QDateTime::fromString(match.captured(1), "yyyy/MM/dd hh:mm:ss.zzz");
+            for (int i = 0; i < 3; i++) result.values[i] = match.captured(2 + i).toDouble();
+            result.quality = match.captured(5).toInt();
+            result.ns = match.captured(6).toInt();
+            for (int i = 3; i < 9; i++) result.values[i] = match.captured(4 + i).toDouble();
+            legacy.append(result);
+        }
+    }
+    double seconds[2];
+    seconds[0] = timer.restart() / 1000.0;
+    source.close();
+
+    QVector<PosRecord> records;
+    QString error;
+    int skipped = 0;
+    bool ok = PosFile::load(path, &records, &skipped, &error);
+    seconds[1] = timer.elapsed() / 1000.0;
+
+    fprintf(stdout, "结果文件: %s (%.1f MB)\n", file, mb);
+    if (!ok) {
+        fprintf(stdout, "解析失败: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    fprintf(stdout, "正则表达式逐行解析  : %8.3f s %8d 行\n", seconds[0], int(legacy.size()));
+    fprintf(stdout, "映射文件逐字段解析  : %8.3f s %8d 行  加速比 %.1f\n", seconds[1], int(records.size()),
+            seconds[0] / qMax(seconds[1], 1E-6));
+
+    // 逐历元比较时间文本和各字段
+    bool same = legacy.size() == records.size();
+    for (int i = 0; same && i < records.size(); i++) {
+        const Legacy &a = legacy[i];
+        const PosRecord &b = records[i];
+        double values[9] = { b.lat, b.lon, b.height, b.sdn, b.sde, b.sdu, b.sdne, b.sdeu, b.sdun };
+        same = a.timestamp.toString("yyyy/MM/dd hh:mm:ss.zzz") == PosFile::timeText(b) && a.quality == b.quality &&
+               a.ns == b.ns && !memcmp(a.values, values, sizeof(values));
+        if (!same) {
+            fprintf(stdout, "第 %d 个历元不一致\n", i + 1);
+        }
+    }
+    fprintf(stdout, "结果%s\n", same ? "一致" : "不一致");
+    return same ? EXIT_OK : EXIT_FAILED;
+}
+
+// 结果文件格式的基准测试：生成epochs个1 Hz的动态解，分别写出.pos文本和二进制文件，
+// 比较文件大小、写出和读取的速度以及按时间窗定位的耗时，并检查二进制转换的文本与直接输出的文本是否相同
+static int runSolBench(int &argc, char *argv[], int epochs)
+{
+    QCoreApplication app(argc, argv);
+    if (epochs <= 0) {
+        fprintf(stderr, "错误: 历元数无效\n");
+        return EXIT_USAGE;
+    }
+    ppp_paths_t paths;
+    PPPProcessor::initPaths(&paths);
+    solopt_t sopt;
+    PPPProcessor::initSolutionOptions(&paths, &sopt);
+
+    // 模拟的动态轨迹：在参考点附近缓慢移动，协方差随时间收敛
+    double ep[6] = { 2024, 1, 1, 0, 0, 0 }, base[3] = { -2148744.0, 4426641.0, 4044655.0 };
+    gtime_t start = epoch2time(ep);
+    QVector<sol_t> sols(epochs);
+    for (int i = 0; i < epochs; i++) {
+        sol_t &sol = sols[i];
+        memset(&sol, 0, sizeof(sol));
+        sol.time = timeadd(start, i);
+        for (int j = 0; j < 3; j++) sol.rr[j] = base[j] + 50.0 * sin(i * 1E-3 + j) + 1E-3 * ((i * 7 + j) % 13);
+        double var = 1E-4 + 1.0 / (1.0 + i);
+        sol.qr[0] = sol.qr[1] = sol.qr[2] = float(var);
+        sol.qr[3] = float(var * 0.1);
+        sol.qr[4] = float(-var * 0.05);
+        sol.qr[5] = float(var * 0.02);
+        sol.stat = SOLQ_PPP;
+        sol.ns = 8 + i % 10;
+    }
+    QString dir = QDir::tempPath();
+    QByteArray text = QDir(dir).filePath(QString("ppp_bench_%1.pos").arg(QCoreApplication::applicationPid())).toLocal8Bit();
+    QByteArray binary = QDir(dir).filePath(QString("ppp_bench_%1.sol").arg(QCoreApplication::applicationPid())).toLocal8Bit();
+    QByteArray converted = text + ".conv";
+    double rb[3] = { 0 };
+    double seconds[6];
+    QElapsedTimer timer;
+
+    // 写出
+    timer.start();
+    FILE *fp = fopen(text.constData(), "w");
+    if (!fp) {
+        fprintf(stderr, "错误: 无法创建 %s\n", text.constData());
+        return EXIT_FAILED;
+    }
+    outsolhead(fp, &sopt);
+    for (const sol_t &sol : sols) outsol(fp, &sol, rb, &sopt);
+    fclose(fp);
+    seconds[0] = timer.restart() / 1000.0;
+    fp = fopen(binary.constData(), "wb");
+    if (!fp) {
+        fprintf(stderr, "错误: 无法创建 %s\n", binary.constData());
+        return EXIT_FAILED;
+    }
+    PPPSolutionFile::writeHeader(fp);
+    for (const sol_t &sol : sols) PPPSolutionFile::writeRecord(fp, sol);
+    fclose(fp);
+    bool indexed = PPPSolutionFile::writeIndex(binary.constData());
+    seconds[1] = timer.restart() / 1000.0;
+
+    // 读取全部历元
+    QVector<PosRecord> records;
+    QString error;
+    int skipped = 0;
+    PosFile::load(QString::fromLocal8Bit(text), &records, &skipped, &error);
+    seconds[2] = timer.restart() / 1000.0;
+    PPPSolutionFile file;
+    double sum = 0.0;
+    if (file.open(QString::fromLocal8Bit(binary), &error)) {
+        sol_t sol;
+        for (int i = 0; i < file.count(); i++) {
+            file.read(i, &sol);
+            sum += sol.rr[0];
+        }
+    }
+    seconds[3] = timer.restart() / 1000.0;
+
+    // 按时间窗定位：1000个随机的10分钟时间窗
+    const int windows = 1000;
+    int found = 0;
+    for (int k = 0; k < windows; k++) {
+        gtime_t ts = timeadd(start, double((k * 7919LL) % epochs)), te = timeadd(ts, 600.0);
+        int first, last;
+        file.window(ts, te, &first, &last);
+        found += last - first;
+    }
+    seconds[4] = timer.restart() / 1000.0;
+
+    // 二进制转换为文本，应与直接输出的文本相同
+    bool same = PPPSolutionFile::toText(QString::fromLocal8Bit(binary), QString::fromLocal8Bit(converted), &sopt, &error);
+    seconds[5] = timer.elapsed() / 1000.0;
+    QFile a(QString::fromLocal8Bit(text)), b(QString::fromLocal8Bit(converted));
+    same = same && a.open(QIODevice::ReadOnly) && b.open(QIODevice::ReadOnly) && a.readAll() == b.readAll();
+    a.close();
+    b.close();
+
+    double mb[2] = { QFileInfo(QString::fromLocal8Bit(text)).size() / 1048576.0,
+                     QFileInfo(QString::fromLocal8Bit(binary)).size() / 1048576.0 };
+    fprintf(stdout, "历元数: %d (读取 %d/%d, 校验和 %.3f)\n", epochs, int(records.size()), file.count(), sum / qMax(1, file.count()));
+    fprintf(stdout, "           大小(MB)  字节/历元   写出(s)  写出(MB/s)  读取(s)  读取(万历元/s)\n");
+    fprintf(stdout, ".pos文本   %8.1f  %9.1f  %8.3f  %10.1f  %7.3f  %14.1f\n", mb[0], mb[0] * 1048576.0 / epochs, seconds[0],
+            mb[0] / qMax(seconds[0], 1E-6), seconds[2], epochs / 1E4 / qMax(seconds[2], 1E-6));
+    fprintf(stdout, "二进制     %8.1f  %9.1f  %8.3f  %10.1f  %7.3f  %14.1f\n", mb[1], mb[1] * 1048576.0 / epochs, seconds[1],
+            mb[1] / qMax(seconds[1], 1E-6), seconds[3], epochs / 1E4 / qMax(seconds[3], 1E-6));
+    fprintf(stdout, "时间窗定位: %d 次 %.1f us/次（%s，共 %d 个历元）\n", windows, seconds[4] * 1E6 / windows,
+            file.indexed() && indexed ? "使用时间索引" : "无索引", found);
+    fprintf(stdout, "转换为文本: %.3f s，与直接输出的文本%s\n", seconds[5], same ? "相同" : "不同");
+    file.close();
+    QFile::remove(QString::fromLocal8Bit(text));
+    QFile::remove(QString::fromLocal8Bit(binary));
+    QFile::remove(QString::fromLocal8Bit(converted));
+    return same ? EXIT_OK : EXIT_FAILED;
+}
+
+// 残差查询的基准测试：读取RTKLIB的状态文件，比较与二进制残差文件的读取耗时，
+// 并统计逐颗卫星3小时时间窗的残差查询和各系统拒绝次数查询的耗时
+static int runResBench(int &argc, char *argv[], const char *file)
+{
+    QCoreApplication app(argc, argv);
+    QString path = QString::fromLocal8Bit(file);
+    QString binary = QDir(QDir::tempPath()).filePath(QString("ppp_bench_%1.res").arg(QCoreApplication::applicationPid()));
+    PPPResidualStore store;
+    QString error;
+    QElapsedTimer timer;
+    timer.start();
+    if (!store.loadStat(path, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    double textSeconds = timer.restart() / 1000.0;
+    if (store.isEmpty()) {
+        fprintf(stderr, "错误: 状态文件中没有残差记录（$SAT）\n");
+        return EXIT_FAILED;
+    }
+    if (!store.save(binary, &error)) {
+        fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+    timer.restart();
+    PPPResidualStore loaded;
+    bool ok = loaded.load(binary, &error);
+    double binarySeconds = timer.restart() / 1000.0;
+    qint64 binaryBytes = QFileInfo(binary).size();
+    QFile::remove(binary);
+    if (!ok || loaded.size() != store.size()) {
+        fprintf(stderr, "错误: 二进制残差文件读取失败 %s\n", error.toLocal8Bit().constData());
+        return EXIT_FAILED;
+    }
+
+    // 逐颗卫星、逐个频率查询一天中的各3小时时间窗
+    const double window = 3 * 3600.0;
+    QVector<int> sats = loaded.satellites();
+    gtime_t start = loaded.startTime();
+    int queries = 0;
+    qint64 records = 0;
+    timer.restart();
+    for (int sat : sats) {
+        for (int frq = 1; frq <= NFREQ; frq++) {
+            for (double t = 0.0; t < 86400.0; t += window) {
+                gtime_t ts = timeadd(start, t), te = timeadd(ts, window);
+                records += loaded.residuals(sat, frq, ts, te).size();
+                queries++;
+            }
+        }
+    }
+    double querySeconds = timer.restart() / 1000.0;
+
+    timer.restart();
+    QString report = PPPProcessor::rejectReport(loaded);
+    double rejectSeconds = timer.elapsed() / 1000.0;
+
+    fprintf(stdout, "卫星 %d 颗，内存 %.1f MB\n", int(sats.size()), loaded.bytes() / 1048576.0);
+    fprintf(stdout, "读取状态文件:   %8.3f s (%.1f MB)\n", textSeconds, QFileInfo(path).size() / 1048576.0);
+    fprintf(stdout, "读取二进制文件: %8.3f s (%.1f MB)\n", binarySeconds, binaryBytes / 1048576.0);
+    fprintf(stdout, "3小时时间窗查询: %d 次，共 %lld 条记录，%.3f ms/次\n", queries, records,
+            querySeconds * 1000.0 / qMax(queries, 1));
+    fprintf(stdout, "%s（%.3f ms）\n", report.toLocal8Bit().constData(), rejectSeconds * 1000.0);
+    return EXIT_OK;
+}
+
+// 跟踪日志开销的基准测试：同一任务分别不生成日志、写文本日志和写二进制日志各处理一次，
+// 比较每个历元的处理时间和日志文件的大小（日志级别取任务文件的设置，未设置时为3）
+static int runTraceBench(const ppp_paths_t &paths)
+{
+    static const struct {
+        const char *name;
+        bool trace;
+        trace_format_t format;
+    } modes[] = { { "无日志", false, TRACEFORMAT_BINARY }, { "文本", true, TRACEFORMAT_TEXT },
+                  { "二进制", true, TRACEFORMAT_BINARY } };
+    int level = paths.trace_level > 0 ? paths.trace_level : 3;
+    double seconds[3] = { 0 }, megabytes[3] = { 0 };
+    int epochs = 0;
+    for (int i = 0; i < 3; i++) {
+        ppp_paths_t job = paths;
+        job.trace_level = modes[i].trace ? level : 0;
+        job.tracefmt = modes[i].format;
+        PPPProcessor processor;
+        processor.setPaths(job);
+        QElapsedTimer timer;
+        timer.start();
+        bool success = processor.execute();
+        seconds[i] = timer.elapsed() / 1000.0;
+        if (!success) {
+            fprintf(stderr, "%s\n", processor.getStatusMessage().toLocal8Bit().constData());
+            return EXIT_FAILED;
+        }
+        if (!processor.traceFile().isEmpty()) {
+            megabytes[i] = QFileInfo(processor.traceFile()).size() / 1048576.0;
+            QFile::remove(processor.traceFile());
+        }
+        epochs = processor.solutions().size();
+        if (epochs == 0 && job.out_file[0]) {
+            QVector<PosRecord> records;
+            QString error;
+            int skipped = 0;
+            PosFile::load(QString::fromLocal8Bit(job.out_file), &records, &skipped, &error);
+            epochs = records.size();
+        }
+    }
+    fprintf(stdout, "日志级别 %d，历元数 %d\n", level, epochs);
+    fprintf(stdout, "          耗时(s)  每历元(us)  日志开销(us/历元)  日志(MB)\n");
+    for (int i = 0; i < 3; i++) {
+        double perEpoch = seconds[i] * 1E6 / qMax(epochs, 1);
+        fprintf(stdout, "%-8s %8.2f  %10.1f  %17.1f  %8.1f\n", modes[i].name, seconds[i], perEpoch,
+                perEpoch - seconds[0] * 1E6 / qMax(epochs, 1), megabytes[i]);
+    }
+    return EXIT_OK;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *obsPath = nullptr;
+    const char *decompressPath = nullptr;
+    const char *posPath = nullptr;
+    int solEpochs = 0;
+    const char *resPath = nullptr;
+    const char *jobPath = nullptr;
+    int threads = 0;
+    double productCache = 0.0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--obs") && i + 1 < argc) {
+            obsPath = argv[++i];
+        } else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--decompress") && i + 1 < argc) {
+            decompressPath = argv[++i];
+        } else if (!strcmp(argv[i], "--pos") && i + 1 < argc) {
+            posPath = argv[++i];
+        } else if (!strcmp(argv[i], "--sol") && i + 1 < argc) {
+            solEpochs = atoi(argv[++i]);
+            if (solEpochs <= 0) {
+                printUsage();
+                return EXIT_USAGE;
+            }
+        } else if (!strcmp(argv[i], "--res") && i + 1 < argc) {
+            resPath = argv[++i];
+        } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            jobPath = argv[++i];
+        } else if (!strcmp(argv[i], "--product-cache") && i + 1 < argc) {
+            productCache = atof(argv[++i]);
+        } else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            printUsage();
+            return EXIT_OK;
+        } else {
+            printUsage();
+            return EXIT_USAGE;
+        }
+    }
+    // 每次测试只处理一个任务，缺省不缓存产品，与ppp_cli处理单个任务时相同
+    PPPProductCache::instance().setBudget(qint64(productCache * 1048576.0));
+    if (obsPath) {
+        return runObsBench(argc, argv, obsPath, threads);
+    }
+    if (decompressPath) {
+        return runDecompressBench(argc, argv, decompressPath);
+    }
+    if (posPath) {
+        return runPosBench(argc, argv, posPath);
+    }
+    if (solEpochs > 0) {
+        return runSolBench(argc, argv, solEpochs);
+    }
+    if (resPath) {
+        return runResBench(argc, argv, resPath);
+    }
+    if (jobPath) {
+        ppp_paths_t paths;
+        QString error;
+        if (!PPPJobFile::load(QString::fromLocal8Bit(jobPath), &paths, &error)) {
+            fprintf(stderr, "错误: %s\n", error.toLocal8Bit().constData());
+            return EXIT_USAGE;
+        }
+        return runTraceBench(paths);
+    }
+    printUsage();
+    return EXIT_USAGE;
+}